@@ -22,13 +22,14 @@
 #include <jellyfish/stream_manager.hpp>
 #include <jellyfish/whole_sequence_parser.hpp>
 #include <jellyfish/mer_dna_bloom_counter.hpp>
+#include <jellyfish/sequence_mers.hpp>
 #include <jellyfish/jellyfish.hpp>
-#include "sequence_mers.hpp"
 
 namespace err = jellyfish::err;
 
 using jellyfish::mer_dna;
 using jellyfish::mer_dna_bloom_counter;
+using jellyfish::sequence_mers;
 typedef jellyfish::whole_sequence_parser<jellyfish::stream_manager<char**> > sequence_parser;
 
 template<typename PathIterator, typename Database>
@@ -22,20 +22,20 @@
 #include <iterator>
 
 #include <jellyfish/allocators_mmap.hpp>
-#include <jellyfish/atomic_gcc.hpp>
+#include <jellyfish/atomic_cxx11.hpp>
 #include <jellyfish/divisor.hpp>
 
 namespace jellyfish {
 template<typename Value, typename T, typename Derived>
 class atomic_bits_array_base {
-  static const int       w_ = sizeof(T) * 8;
-  const int              bits_;
-  const size_t           size_;
-  const T                mask_;
-  const jflib::divisor64 d_;
-  size_t                 size_bytes_;
-  T*                     data_;
-  static atomic::gcc     atomic_;
+  static const int        w_ = sizeof(T) * 8;
+  const int               bits_;
+  const size_t            size_;
+  const T                 mask_;
+  const jflib::divisor64  d_;
+  size_t                  size_bytes_;
+  T*                      data_;
+  static atomic::standard atomic_;
 
   friend class iterator;
   class iterator : public std::iterator<std::input_iterator_tag, Value> {
@@ -96,10 +96,8 @@ class atomic_bits_array_base {
       do {
         pval = cval;
         const T new_word    = (prev_word_ & ~mask_) | ((static_cast<T>(nval) << off_) & mask_);
-        const T actual_word = atomic_.cas(word_, prev_word_, new_word);
-        if(__builtin_expect(actual_word == prev_word_, 1))
+        if(__builtin_expect(atomic_.cas_weak(word_, &prev_word_, new_word), 1))
           return true;
-        prev_word_ = actual_word;
         cval = get_val(prev_word_);
       } while(pval == cval);
       nval = cval;
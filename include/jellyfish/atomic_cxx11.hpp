@@ -0,0 +1,93 @@
+/*  This file is part of Jellyfish.
+
+    Jellyfish is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Jellyfish is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Jellyfish.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __JELLYFISH_ATOMIC_CXX11_HPP__
+#define __JELLYFISH_ATOMIC_CXX11_HPP__
+
+#include <jellyfish/atomic_gcc.hpp>
+
+namespace atomic
+{
+#ifdef __ATOMIC_ACQ_REL
+  /// Same interface as gcc, built on the __atomic builtins (the
+  /// C++11 memory model) instead of the legacy __sync builtins, which
+  /// are full barriers. The read-modify-write operations are
+  /// acquire-release. fetch_add and add_fetch are a single
+  /// instruction (lock xadd on x86) rather than compare-and-swap
+  /// loops. fetch_add_relaxed is for pure counters, updated
+  /// concurrently but read only after the threads synchronized
+  /// (barrier or join).
+  class cxx11
+  {
+  public:
+    template<typename T>
+    static inline T cas(volatile T *ptr, T oval, T nval) {
+      __atomic_compare_exchange_n(ptr, &oval, nval, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+      return oval;
+    }
+
+    /// Compare-and-swap which may fail spuriously, for retry
+    /// loops. On failure, *oval is updated to the current value.
+    template<typename T>
+    static inline bool cas_weak(volatile T *ptr, T* oval, T nval) {
+      return __atomic_compare_exchange_n(ptr, oval, nval, true, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+    }
+
+    template<typename T>
+    static inline T set(T *ptr, T nval) {
+      return __atomic_exchange_n(ptr, nval, __ATOMIC_ACQ_REL);
+    }
+
+    template<typename T>
+    static inline T add_fetch(volatile T *ptr, T x) {
+      return __atomic_add_fetch(ptr, x, __ATOMIC_ACQ_REL);
+    }
+
+    template<typename T>
+    static inline T fetch_add(volatile T *ptr, T x) {
+      return __atomic_fetch_add(ptr, x, __ATOMIC_ACQ_REL);
+    }
+
+    template<typename T>
+    static inline T fetch_or(volatile T *ptr, T x) {
+      return __atomic_fetch_or(ptr, x, __ATOMIC_ACQ_REL);
+    }
+
+    template<typename T>
+    static inline T fetch_add_relaxed(volatile T *ptr, T x) {
+      return __atomic_fetch_add(ptr, x, __ATOMIC_RELAXED);
+    }
+
+    template<typename T>
+    static inline T set_to_max(volatile T *ptr, T x) {
+      T count = __atomic_load_n(ptr, __ATOMIC_RELAXED);
+      while(x > count) {
+        if(cas_weak(ptr, &count, x))
+          return x;
+      }
+      return count;
+    }
+  };
+
+  /// The atomic policy used by default by the data structures: cxx11
+  /// if the compiler has the __atomic builtins (gcc >= 4.7, clang),
+  /// gcc otherwise.
+  typedef cxx11 standard;
+#else
+  typedef gcc standard;
+#endif
+}
+#endif
@@ -27,6 +27,14 @@ namespace atomic
       return __sync_val_compare_and_swap(ptr, oval, nval);
     }
 
+    template<typename T>
+    static inline bool cas_weak(volatile T *ptr, T* oval, T nval) {
+      const T cval = cas(ptr, *oval, nval);
+      const bool res = cval == *oval;
+      *oval = cval;
+      return res;
+    }
+
     template<typename T>
     static inline T set(T *ptr, T nval) {
       return __sync_lock_test_and_set(ptr, nval);
@@ -52,6 +60,16 @@ namespace atomic
       return count;
     }
 
+    template<typename T>
+    static inline T fetch_or(volatile T *ptr, T x) {
+      return __sync_fetch_and_or(ptr, x);
+    }
+
+    template<typename T>
+    static inline T fetch_add_relaxed(volatile T *ptr, T x) {
+      return fetch_add(ptr, x);
+    }
+
     template<typename T>
     static inline T set_to_max(volatile T *ptr, T x) {
       T count = *ptr;
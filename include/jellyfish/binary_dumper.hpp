@@ -93,14 +93,14 @@ class binary_reader {
   const int                     val_len_;
   Key                           key_;
   Val                           val_;
-  const RectangularBinaryMatrix m_;
+  const invertible_hash         m_;
   const size_t                  size_mask_;
 
 public:
   binary_reader(std::istream& is, // stream containing data (past any header)
                 file_header* header) :  // header which contains counter_len, matrix, size and key_len
     is_(is), val_len_(header->counter_len()), key_(header->key_len() / 2),
-    m_(header->matrix()),
+    m_(header->hash_function()),
     size_mask_(header->size() - 1)
   { }
 
@@ -116,12 +116,49 @@ public:
   }
 };
 
+/// Records of a database in binary/sorted format, in memory (usually
+/// a mapped file). Random access to the keys and values by record
+/// index.
+template<typename Key, typename Val>
+class binary_records {
+  const char* const  data_;
+  const unsigned int val_len_; // In bytes
+  const unsigned int key_len_; // In bytes
+  const size_t       record_len_;
+  const size_t       nb_records_;
+
+public:
+  // key_len passed in bits, val_len in bytes (as in binary_query_base).
+  binary_records(const char* data, unsigned int key_len, unsigned int val_len, size_t length) :
+    data_(data),
+    val_len_(val_len),
+    key_len_(key_len / 8 + (key_len % 8 != 0)),
+    record_len_(val_len + key_len_),
+    nb_records_(length / record_len_)
+  {
+    if(length % record_len_ != 0)
+      throw std::length_error(err::msg() << "Size of database (" << length << ") must be a multiple of the length of a record ("
+                              << record_len_ << ")");
+  }
+
+  size_t size() const { return nb_records_; }
+  void key_at(size_t id, Key& key) const {
+    memcpy(key.data__(), data_ + id * record_len_, key_len_);
+    key.clean_msw();
+  }
+  Val val_at(size_t id) const {
+    Val res = 0;
+    memcpy(&res, data_ + id * record_len_ + key_len_, val_len_);
+    return res;
+  }
+};
+
 template<typename Key, typename Val>
 class binary_query_base {
   const char* const             data_;
   const unsigned int            val_len_; // In bytes
   const unsigned int            key_len_; // In bytes
-  const RectangularBinaryMatrix m_;
+  const invertible_hash         m_;
   const size_t                  mask_;
   const size_t                  record_len_;
   const size_t                  last_id_;
@@ -131,7 +168,7 @@ class binary_query_base {
 
 public:
   // key_len passed in bits
-  binary_query_base(const char* data, unsigned int key_len, unsigned int val_len, const RectangularBinaryMatrix& m, size_t mask,
+  binary_query_base(const char* data, unsigned int key_len, unsigned int val_len, const invertible_hash& m, size_t mask,
                     size_t size) :
     data_(data),
     val_len_(val_len),
@@ -154,6 +191,12 @@ public:
   }
 
   bool val_id(const Key& key,  Val* res, uint64_t* id) const {
+    return val_id(key, res, id, mid_key_);
+  }
+
+  // Same as above, with mid_key as scratch space instead of a member:
+  // the query is thread safe if every thread has its own mid_key.
+  bool val_id(const Key& key,  Val* res, uint64_t* id, Key& mid_key) const {
     if(last_id_ == 0) return false;
     uint64_t first     = 0;
     uint64_t last      = last_id_;
@@ -171,10 +214,10 @@ public:
       cid = first + lrint(diff * ((double)(pos - first_pos) / (double)(last_pos - first_pos)));
       cid = std::max(first + 1, cid);
       cid = std::min(cid, last - 1);
-      key_at(cid, mid_key_);
-      if(key == mid_key_) goto found;
-      uint64_t mid_pos = key_pos(mid_key_);
-      if(mid_pos > pos || (mid_pos == pos && mid_key_ > key)) {
+      key_at(cid, mid_key);
+      if(key == mid_key) goto found;
+      uint64_t mid_pos = key_pos(mid_key);
+      if(mid_pos > pos || (mid_pos == pos && mid_key > key)) {
         last     = cid;
         last_pos = mid_pos;
       } else {
@@ -185,8 +228,8 @@ public:
 
     // Then a linear search (avoids matrix computation)
     for(cid = first + 1; cid < last; ++cid) {
-      key_at(cid, mid_key_);
-      if(key == mid_key_) goto found;
+      key_at(cid, mid_key);
+      if(key == mid_key) goto found;
     }
     return false;
 
@@ -205,6 +248,11 @@ public:
   }
 
   inline Val check(const Key& key) const { return (*this)[key]; }
+  Val check(const Key& key, Key& mid_key) const {
+    Val      res;
+    uint64_t id;
+    return val_id(key, &res, &id, mid_key) ? res : 0;
+  }
 
 protected:
   void key_at(size_t id, Key& key) const {
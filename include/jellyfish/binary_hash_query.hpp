@@ -0,0 +1,156 @@
+/*  This file is part of Jellyfish.
+
+    Jellyfish is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Jellyfish is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Jellyfish.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef __JELLYFISH_BINARY_HASH_QUERY_HPP__
+#define __JELLYFISH_BINARY_HASH_QUERY_HPP__
+
+#include <string.h>
+#include <memory>
+#include <stdexcept>
+
+#include <jellyfish/err.hpp>
+#include <jellyfish/large_hash_array.hpp>
+#include <jellyfish/invertible_hash.hpp>
+#include <jellyfish/thread_exec.hpp>
+
+namespace jellyfish {
+/// Query a database in binary/sorted format after loading it in a
+/// read-only large hash array. A query is then a hash computation and
+/// a few probes in the array, instead of the interpolation search of
+/// binary_query_base.
+///
+/// The loading is done in parallel. The records in the file are
+/// sorted by their position in the hash array they were dumped from,
+/// and the array is created with the same hash function and
+/// size. Hence, each thread inserts its range of records in a
+/// contiguous region of the array and there are very few conflicts
+/// between threads. If the records do not fit, the array is enlarged
+/// with a new random matrix (and the loading loses this locality).
+template<typename Key, typename Val>
+class binary_hash_query {
+public:
+  typedef large_hash::array<Key> array;
+
+protected:
+  const char* const      data_;
+  const unsigned int     key_bits_; // In bits
+  const unsigned int     val_len_;  // In bytes
+  const unsigned int     key_len_;  // In bytes
+  const size_t           record_len_;
+  const size_t           nb_records_;
+  std::unique_ptr<array> ary_;
+
+  class loader : public thread_exec {
+    const binary_hash_query& query_;
+    array&                   ary_;
+    const int                nb_threads_;
+    volatile bool            full_;
+
+  public:
+    loader(const binary_hash_query& query, array& ary, int nb_threads) :
+      query_(query), ary_(ary), nb_threads_(nb_threads), full_(false)
+    { }
+
+    bool full() const { return full_; }
+
+    virtual void start(int thid) {
+      const size_t start = (query_.nb_records_ * thid) / nb_threads_;
+      const size_t end   = (query_.nb_records_ * (thid + 1)) / nb_threads_;
+      Key          key(query_.key_bits_ / 2);
+      Val          val;
+
+      for(size_t id = start; id < end && !full_; ++id) {
+        query_.key_at(id, key);
+        query_.val_at(id, &val);
+        if(!ary_.add(key, val))
+          full_ = true;
+      }
+    }
+  };
+  friend class loader;
+
+public:
+  // key_len passed in bits, val_len in bytes (as in binary_query_base).
+  binary_hash_query(const char* data, unsigned int key_len, unsigned int val_len, const invertible_hash& m,
+                    size_t size, // Size of hash array the file was dumped from
+                    size_t length, // Length of data in bytes
+                    int nb_threads = 1,
+                    uint16_t counter_len = 7, // Length in bits of the counter in hash
+                    uint16_t reprobe_limit = 126) :
+    data_(data),
+    key_bits_(key_len),
+    val_len_(val_len),
+    key_len_(key_len / 8 + (key_len % 8 != 0)),
+    record_len_(val_len + key_len_),
+    nb_records_(length / record_len_)
+  {
+    if(length % record_len_ != 0)
+      throw std::length_error(err::msg() << "Size of database (" << length << ") must be a multiple of the length of a record ("
+                              << record_len_ << ")");
+
+    bool   use_hash = nb_records_ <= size;
+    size_t asize    = use_hash ? size : 2 * nb_records_;
+    while(true) {
+      ary_.reset(use_hash ?
+                 new array(asize, key_len, counter_len, reprobe_limit, m) :
+                 new array(asize, key_len, counter_len, reprobe_limit));
+      loader load(*this, *ary_, nb_threads);
+      load.exec_join(nb_threads);
+      if(!load.full())
+        break;
+      asize   *= 2;
+      use_hash = false;
+    }
+  }
+
+  const array& ary() const { return *ary_; }
+  size_t nb_records() const { return nb_records_; }
+
+  Val operator[](const Key& key) const {
+    uint64_t res;
+    if(!ary_->get_val_for_key(key, &res))
+      return 0;
+    return res;
+  }
+  inline Val check(const Key& key) const { return (*this)[key]; }
+
+  /// Prefetch the memory for key. Pass the return value to
+  /// check(key, pos) to do the actual query.
+  size_t prefetch(const Key& key) const { return ary_->prefetch_key(key); }
+
+  /// Query key after a call to prefetch.
+  Val check(const Key& key, size_t pos) const {
+    Key                                tmp_key;
+    size_t                             id;
+    const typename array::data_word*   w;
+    const typename array::offset_t*    o;
+    if(!ary_->get_key_id(key, &id, tmp_key, &w, &o, pos))
+      return 0;
+    return ary_->get_val_at_id(id, w, o);
+  }
+
+protected:
+  void key_at(size_t id, Key& key) const {
+    memcpy(key.data__(), data_ + id * record_len_, key_len_);
+    key.clean_msw();
+  }
+  void val_at(size_t id, Val* val) const {
+    *val = 0;
+    memcpy(val, data_ + id * record_len_ + key_len_, val_len_);
+  }
+};
+}
+
+#endif /* __JELLYFISH_BINARY_HASH_QUERY_HPP__ */
@@ -18,8 +18,9 @@
 #define __JELLYFISH_BLOOM_COMMON_HPP__
 
 #include <math.h>
+#include <type_traits>
 #include <jellyfish/divisor.hpp>
-#include <jellyfish/atomic_gcc.hpp>
+#include <jellyfish/atomic_cxx11.hpp>
 
 namespace jellyfish {
 template<typename Key>
@@ -33,6 +34,14 @@ protected:
     unsigned char* pos;
   };
 
+  // Output iterator ignoring the values written to it
+  struct discard_iterator {
+    discard_iterator& operator*() { return *this; }
+    discard_iterator& operator=(unsigned int) { return *this; }
+    discard_iterator& operator++() { return *this; }
+    discard_iterator& operator++(int) { return *this; }
+  };
+
   // The number of bits in the structure, previously known as m_, is
   // know stored as d_.d()
   const jflib::divisor64 d_;
@@ -86,6 +95,77 @@ public:
     return static_cast<const Derived*>(this)->check__(hashes);
   }
 
+  // Batch versions of insert and check. The keys in [first, last) are
+  // pipelined: the hashes of a key are computed and its memory
+  // locations prefetched batch_lookahead keys before it is probed, so
+  // the memory accesses of consecutive keys overlap. The result for
+  // each key, as returned by insert or check, is written to res.
+  static const size_t batch_lookahead = 8;
+
+  // Steps of the batch pipeline. pinfo has room for k_ entries and is
+  // kept from the prefetch of a key to its probe. By default, the
+  // prefetch and the probe use only the hashes. A layout probing k
+  // scattered positions overrides these to compute the positions once
+  // in prefetch_at__ and reuse them.
+  void prefetch_at__(const uint64_t* hashes, prefetch_info*, bool write) const {
+    static_cast<const Derived*>(this)->prefetch__(hashes, write);
+  }
+  unsigned int insert_at__(const uint64_t* hashes, const prefetch_info*) {
+    return static_cast<Derived*>(this)->insert__(hashes);
+  }
+  unsigned int check_at__(const uint64_t* hashes, const prefetch_info*) const {
+    return static_cast<const Derived*>(this)->check__(hashes);
+  }
+
+  template<typename KeyIterator, typename OutputIterator>
+  OutputIterator insert_many(KeyIterator first, KeyIterator last, OutputIterator res) {
+    static_assert(std::is_pod<prefetch_info>::value, "prefetch_info must be a POD");
+    Derived* const self = static_cast<Derived*>(this);
+    uint64_t       hashes[batch_lookahead][2];
+    prefetch_info  pinfo[batch_lookahead * k_];
+    size_t         nb = 0;
+    for( ; first != last; ++first, ++nb) {
+      const size_t    j = nb % batch_lookahead;
+      uint64_t* const h = hashes[j];
+      if(nb >= batch_lookahead)
+        *res++ = self->insert_at__(h, pinfo + j * k_);
+      hash_fns_(*first, h);
+      self->prefetch_at__(h, pinfo + j * k_, true);
+    }
+    for(size_t i = nb > batch_lookahead ? nb - batch_lookahead : 0; i < nb; ++i) {
+      const size_t j = i % batch_lookahead;
+      *res++ = self->insert_at__(hashes[j], pinfo + j * k_);
+    }
+    return res;
+  }
+
+  template<typename KeyIterator>
+  void insert_many(KeyIterator first, KeyIterator last) {
+    insert_many(first, last, discard_iterator());
+  }
+
+  template<typename KeyIterator, typename OutputIterator>
+  OutputIterator check_many(KeyIterator first, KeyIterator last, OutputIterator res) const {
+    static_assert(std::is_pod<prefetch_info>::value, "prefetch_info must be a POD");
+    const Derived* const self = static_cast<const Derived*>(this);
+    uint64_t             hashes[batch_lookahead][2];
+    prefetch_info        pinfo[batch_lookahead * k_];
+    size_t               nb = 0;
+    for( ; first != last; ++first, ++nb) {
+      const size_t    j = nb % batch_lookahead;
+      uint64_t* const h = hashes[j];
+      if(nb >= batch_lookahead)
+        *res++ = self->check_at__(h, pinfo + j * k_);
+      hash_fns_(*first, h);
+      self->prefetch_at__(h, pinfo + j * k_, false);
+    }
+    for(size_t i = nb > batch_lookahead ? nb - batch_lookahead : 0; i < nb; ++i) {
+      const size_t j = i % batch_lookahead;
+      *res++ = self->check_at__(hashes[j], pinfo + j * k_);
+    }
+    return res;
+  }
+
 
 
   // Limited std::map interface compatibility
@@ -25,7 +25,7 @@
 #include <jellyfish/mapped_file.hpp>
 #include <jellyfish/allocators_mmap.hpp>
 #include <jellyfish/divisor.hpp>
-#include <jellyfish/atomic_gcc.hpp>
+#include <jellyfish/atomic_cxx11.hpp>
 #include <jellyfish/atomic_field.hpp>
 
 #include <jellyfish/err.hpp>
@@ -35,11 +35,57 @@
 #endif
 
 namespace jellyfish {
+/* The counters of a bloom counter take 3 values: 0, 1 or 2 (trits). 5
+   trits are packed in a byte, the trit at offset boff having weight
+   3^boff.
+ */
+template<typename atomic_t>
+struct bloom_counter2_trits {
+  // values[v][boff] is the trit at offset boff in byte v. Bytes above
+  // 242 are not valid but are in the table for safety.
+  static const unsigned char values[256][5];
+  static const unsigned char weights[5];
+
+  // Value of the trit at offset boff in byte v
+  static unsigned char get(unsigned char v, size_t boff) {
+    return values[v][boff];
+  }
+
+  // Increment, saturating at 2, the trit at offset boff in byte
+  // *pos. Returns its previous value.
+  static unsigned char increment(atomic_t& atomic, unsigned char* pos, size_t boff) {
+    unsigned char v = jflib::a_load(pos);
+    while(true) {
+      const unsigned char w = get(v, boff);
+      if(w == 2) return w;
+      if(atomic.cas_weak(pos, &v, (unsigned char)(v + weights[boff]))) return w;
+    }
+  }
+};
+
+#define JF_TRITS(v)   { (v) % 3, (v) / 3 % 3, (v) / 9 % 3, (v) / 27 % 3, (v) / 81 % 3 }
+#define JF_TRITS3(v)  JF_TRITS(v), JF_TRITS(v + 1), JF_TRITS(v + 2)
+#define JF_TRITS9(v)  JF_TRITS3(v), JF_TRITS3(v + 3), JF_TRITS3(v + 6)
+#define JF_TRITS27(v) JF_TRITS9(v), JF_TRITS9(v + 9), JF_TRITS9(v + 18)
+#define JF_TRITS81(v) JF_TRITS27(v), JF_TRITS27(v + 27), JF_TRITS27(v + 54)
+template<typename atomic_t>
+const unsigned char bloom_counter2_trits<atomic_t>::values[256][5] = {
+  JF_TRITS81(0), JF_TRITS81(81), JF_TRITS81(162), JF_TRITS9(243), JF_TRITS3(252), JF_TRITS(255)
+};
+#undef JF_TRITS81
+#undef JF_TRITS27
+#undef JF_TRITS9
+#undef JF_TRITS3
+#undef JF_TRITS
+template<typename atomic_t>
+const unsigned char bloom_counter2_trits<atomic_t>::weights[5] = { 1, 3, 9, 27, 81 };
+
 /* Bloom counter with 3 values: 0, 1 or 2. It is thread safe and lock free.
  */
-template<typename Key, typename HashPair = hash_pair<Key>, typename atomic_t = ::atomic::gcc>
+template<typename Key, typename HashPair = hash_pair<Key>, typename atomic_t = ::atomic::standard>
 class bloom_counter2_base : public bloom_base<Key, bloom_counter2_base<Key, HashPair, atomic_t>, HashPair> {
   typedef bloom_base<Key, bloom_counter2_base<Key, HashPair, atomic_t>, HashPair> super;
+  typedef bloom_counter2_trits<atomic_t> trits;
 
   atomic_t atomic_;
 
@@ -60,11 +106,8 @@ public:
     return nb_bytes__(super::d_.d());
   }
 
-  // Insert key with given hashes
-  unsigned int insert__(const uint64_t* hashes) {
-    // Prefetch memory locations
-    static_assert(std::is_pod<typename super::prefetch_info>::value, "prefetch_info must be a POD");
-    typename super::prefetch_info pinfo[super::k_];
+  // Memory locations of the counters of a key with given hashes
+  void positions__(const uint64_t* hashes, typename super::prefetch_info* pinfo) const {
     const size_t base = super::d_.remainder(hashes[0]);
     const size_t inc  = super::d_.remainder(hashes[1]);
     for(unsigned long i = 0; i < super::k_; ++i) {
@@ -72,77 +115,53 @@ public:
       const size_t off = p / 5;
       pinfo[i].boff    = p % 5;
       pinfo[i].pos     = super::data_ + off;
-      //      prefetch_write_no(pinfo[i].pos);
-      __builtin_prefetch(pinfo[i].pos, 1, 0);
     }
+  }
 
-    // Insert element
-    unsigned char res = 2;
+  // Compute and prefetch the counters of a key with given hashes
+  void prefetch_at__(const uint64_t* hashes, typename super::prefetch_info* pinfo, bool write) const {
+    positions__(hashes, pinfo);
     for(unsigned long i = 0; i < super::k_; ++i) {
-      size_t        boff = pinfo[i].boff;
-      unsigned char v    = jflib::a_load(pinfo[i].pos);
-
-      while(true) {
-        unsigned char w = v;
-        switch(boff) {
-        case 0:          break;
-        case 1: w /= 3;  break;
-        case 2: w /= 9;  break;
-        case 3: w /= 27; break;
-        case 4: w /= 81; break;
-        }
-        w = w % 3;
-        if(w == 2) break;
-        unsigned char nv = v;
-
-        switch(boff) {
-        case 0: nv += 1;  break;
-        case 1: nv += 3;  break;
-        case 2: nv += 9;  break;
-        case 3: nv += 27; break;
-        case 4: nv += 81; break;
-        }
-        unsigned char cv = atomic_.cas(pinfo[i].pos, v, nv);
-        if(cv == v) {
-          if(w < res)
-            res = w;
-          break;
-        }
-        v = cv;
-      }
+      if(write)
+        __builtin_prefetch(pinfo[i].pos, 1, 0);
+      else
+        __builtin_prefetch(pinfo[i].pos, 0, 0);
     }
-    return res;
   }
 
-  unsigned int check__(uint64_t *hashes) const {
+  // Insert key with given hashes
+  unsigned int insert__(const uint64_t* hashes) {
     // Prefetch memory locations
     static_assert(std::is_pod<typename super::prefetch_info>::value, "prefetch_info must be a POD");
     typename super::prefetch_info pinfo[super::k_];
-    const size_t base = super::d_.remainder(hashes[0]);
-    const size_t inc  = super::d_.remainder(hashes[1]);
+    prefetch_at__(hashes, pinfo, true);
+    return insert_at__(hashes, pinfo);
+  }
+
+  // Insert key whose counters were computed by prefetch_at__
+  unsigned int insert_at__(const uint64_t*, const typename super::prefetch_info* pinfo) {
+    unsigned char res = 2;
     for(unsigned long i = 0; i < super::k_; ++i) {
-      const size_t p   = super::d_.remainder(base + i * inc);
-      const size_t off = p / 5;
-      pinfo[i].boff    = p % 5;
-      pinfo[i].pos     = super::data_ + off;
-      //      prefetch_read_no(pinfo[i].pos);
-      __builtin_prefetch(pinfo[i].pos, 0, 0);
+      const unsigned char w = trits::increment(atomic_, pinfo[i].pos, pinfo[i].boff);
+      if(w < res)
+        res = w;
     }
+    return res;
+  }
 
-    // Check element
+  unsigned int check__(const uint64_t *hashes) const {
+    // Prefetch memory locations
+    static_assert(std::is_pod<typename super::prefetch_info>::value, "prefetch_info must be a POD");
+    typename super::prefetch_info pinfo[super::k_];
+    prefetch_at__(hashes, pinfo, false);
+    return check_at__(hashes, pinfo);
+  }
+
+  // Check key whose counters were computed by prefetch_at__
+  unsigned int check_at__(const uint64_t*, const typename super::prefetch_info* pinfo) const {
     unsigned char res = 2;
     for(unsigned long i = 0; i < super::k_; ++i) {
-      size_t        boff = pinfo[i].boff;
-      unsigned char w    = jflib::a_load(pinfo[i].pos);
-
-      switch(boff) {
-      case 0:          break;
-      case 1: w /= 3;  break;
-      case 2: w /= 9;  break;
-      case 3: w /= 27; break;
-      case 4: w /= 81; break;
-      }
-      w = w % 3;
+      const unsigned char w = trits::get(jflib::a_load(pinfo[i].pos), pinfo[i].boff);
       if(w < res)
         res = w;
     }
@@ -150,7 +169,7 @@ public:
   }
 };
 
-template<typename Key, typename HashPair = hash_pair<Key>, typename atomic_t = ::atomic::gcc,
+template<typename Key, typename HashPair = hash_pair<Key>, typename atomic_t = ::atomic::standard,
          typename mem_block_t = allocators::mmap>
 class bloom_counter2:
     protected mem_block_t,
@@ -161,6 +180,11 @@ class bloom_counter2:
 public:
   typedef typename super::key_type key_type;
 
+  /// Memory used for n elements with a false positive rate of fp
+  static size_t mem(const double fp, const size_t n) {
+    return super::nb_bytes__(super::opt_m(fp, n));
+  }
+
   bloom_counter2(const double fp, const size_t n, const HashPair& fns = HashPair()) :
     mem_block_t(super::nb_bytes__(super::opt_m(fp, n))),
     super(super::opt_m(fp, n), super::opt_k(fp), (unsigned char*)mem_block_t::get_ptr(), fns)
@@ -195,7 +219,7 @@ public:
   { }
 };
 
-template<typename Key, typename HashPair = hash_pair<Key>, typename atomic_t = ::atomic::gcc>
+template<typename Key, typename HashPair = hash_pair<Key>, typename atomic_t = ::atomic::standard>
 class bloom_counter2_file :
     protected mapped_file,
     public bloom_counter2_base<Key, HashPair, atomic_t>
@@ -204,10 +228,17 @@ class bloom_counter2_file :
 public:
   typedef typename super::key_type key_type;
 
-  bloom_counter2_file(size_t m, unsigned long k, const char* path, const HashPair& fns = HashPair(), off_t offset = 0) :
-    mapped_file(path),
+  bloom_counter2_file(size_t m, unsigned long k, const char* path, const HashPair& fns = HashPair(), off_t offset = 0,
+                       int map_flags = 0) :
+    mapped_file(path, map_flags),
     super(m, k, (unsigned char*)mapped_file::base() + offset, fns)
-  { }
+  {
+    if(mapped_file::length() < offset + super::nb_bytes())
+      throw std::runtime_error(err::msg() << "File '" << path << "' is truncated");
+  }
+
+  /// The mapped file, e.g. to give advice on its use
+  const mapped_file& file() const { return *this; }
 
   bloom_counter2_file(const bloom_counter2_file& rhs) = delete;
   bloom_counter2_file(bloom_counter2_file&& rhs) :
@@ -0,0 +1,233 @@
+/*  This file is part of Jellyfish.
+
+    Jellyfish is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Jellyfish is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Jellyfish.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef __BLOOM_COUNTER2_BLOCKED_HPP__
+#define __BLOOM_COUNTER2_BLOCKED_HPP__
+
+#include <math.h>
+#include <algorithm>
+#include <jellyfish/bloom_counter2.hpp>
+
+namespace jellyfish {
+/* Cache blocked bloom counter with 3 values: 0, 1 or 2. The array is
+   split in blocks of 64 bytes (one cache line) and all the counters of
+   a key are in the same block, selected by the first hash. A lookup
+   costs at most one cache miss instead of k. It is thread safe and
+   lock free.
+
+   The keys are not evenly spread between the blocks, hence for the
+   same number of counters the false positive rate is higher than for
+   bloom_counter2. opt_m accounts for it.
+ */
+template<typename Key, typename HashPair = hash_pair<Key>, typename atomic_t = ::atomic::standard>
+class bloom_counter2_blocked_base :
+    public bloom_base<Key, bloom_counter2_blocked_base<Key, HashPair, atomic_t>, HashPair> {
+  typedef bloom_base<Key, bloom_counter2_blocked_base<Key, HashPair, atomic_t>, HashPair> super;
+  typedef bloom_counter2_trits<atomic_t> trits;
+
+  atomic_t               atomic_;
+  const jflib::divisor64 blocks_;
+
+public:
+  static const size_t block_bytes    = 64;
+  static const size_t block_counters = 5 * block_bytes;
+
+protected:
+  static size_t nb_blocks__(size_t m) {
+    return std::max((size_t)1, m / block_counters + (m % block_counters != 0));
+  }
+  static size_t nb_bytes__(size_t m) {
+    return nb_blocks__(m) * block_bytes;
+  }
+  // Number of counters, rounded up to a whole number of blocks
+  static size_t round_m__(size_t m) {
+    return nb_blocks__(m) * block_counters;
+  }
+
+  // Position in its block of the next counter of a key. The second
+  // hash seeds a linear congruential generator whose high bits are
+  // mapped to [0, block_counters) by a multiply and shift. (Double
+  // hashing in such a small range clusters the counters and doubles
+  // the false positive rate.)
+  static size_t next_pos(uint64_t& h) {
+    h = h * 6364136223846793005ULL + 1442695040888963407ULL;
+    return ((h >> 32) * block_counters) >> 32;
+  }
+
+public:
+  bloom_counter2_blocked_base(size_t m, unsigned long k, unsigned char* ptr, const HashPair& fns = HashPair()) :
+    super(round_m__(m), k, ptr, fns),
+    blocks_(nb_blocks__(m))
+  { }
+  bloom_counter2_blocked_base(bloom_counter2_blocked_base&& rhs) :
+    super(std::move(rhs)),
+    blocks_(rhs.blocks_)
+  { }
+  size_t nb_bytes() const {
+    return nb_bytes__(super::d_.d());
+  }
+  size_t nb_blocks() const { return blocks_.d(); }
+
+  // False positive rate with n keys inserted in nb_blocks blocks, using
+  // k counters per key. The number of keys in a block follows a
+  // Poisson law of mean n / nb_blocks.
+  static double fp_rate(size_t nb_blocks, size_t n, unsigned long k) {
+    const double lambda = (double)n / nb_blocks;
+    const double log_q  = log1p(-1.0 / block_counters);
+    const size_t max_j  = (size_t)(lambda + 10 * sqrt(lambda)) + 10;
+    double       log_p  = -lambda; // log of P(j keys in block)
+    double       res    = 0;
+    for(size_t j = 0; j <= max_j; ++j) {
+      res   += exp(log_p) * pow(-expm1(k * j * log_q), k);
+      log_p += log(lambda) - log(j + 1);
+    }
+    return res;
+  }
+
+  // Number of counters to get a false positive rate of fp with n
+  // keys. Start from the size of a non blocked bloom counter and grow
+  // by steps of 1/64.
+  static size_t opt_m(const double fp, const size_t n) {
+    const unsigned long k         = super::opt_k(fp);
+    size_t              nb_blocks = nb_blocks__(super::opt_m(fp, n));
+    while(fp_rate(nb_blocks, n, k) > fp)
+      nb_blocks += nb_blocks / 64 + 1;
+    return nb_blocks * block_counters;
+  }
+
+  // Prefetch the block of a key with given hashes
+  void prefetch__(const uint64_t* hashes, bool write) const {
+    const unsigned char* const block = super::data_ + blocks_.remainder(hashes[0]) * block_bytes;
+    if(write)
+      __builtin_prefetch(block, 1, 0);
+    else
+      __builtin_prefetch(block, 0, 0);
+  }
+
+  // Insert key with given hashes
+  unsigned int insert__(const uint64_t* hashes) {
+    unsigned char* const block = super::data_ + blocks_.remainder(hashes[0]) * block_bytes;
+    __builtin_prefetch(block, 1, 0);
+
+    uint64_t      h   = hashes[1];
+    unsigned char res = 2;
+    for(unsigned long i = 0; i < super::k_; ++i) {
+      const size_t        p = next_pos(h);
+      const unsigned char w = trits::increment(atomic_, block + p / 5, p % 5);
+      if(w < res)
+        res = w;
+    }
+    return res;
+  }
+
+  unsigned int check__(const uint64_t *hashes) const {
+    const unsigned char* const block = super::data_ + blocks_.remainder(hashes[0]) * block_bytes;
+    __builtin_prefetch(block, 0, 0);
+
+    uint64_t      h   = hashes[1];
+    unsigned char res = 2;
+    for(unsigned long i = 0; i < super::k_; ++i) {
+      const size_t        p = next_pos(h);
+      const unsigned char w = trits::get(jflib::a_load(block + p / 5), p % 5);
+      if(w < res)
+        res = w;
+    }
+    return res;
+  }
+};
+
+template<typename Key, typename HashPair = hash_pair<Key>, typename atomic_t = ::atomic::standard,
+         typename mem_block_t = allocators::mmap>
+class bloom_counter2_blocked:
+    protected mem_block_t,
+    public bloom_counter2_blocked_base<Key, HashPair, atomic_t>
+{
+  typedef bloom_counter2_blocked_base<Key, HashPair, atomic_t> super;
+
+public:
+  typedef typename super::key_type key_type;
+
+  /// Memory used for n elements with a false positive rate of fp
+  static size_t mem(const double fp, const size_t n) {
+    return super::nb_bytes__(super::opt_m(fp, n));
+  }
+
+  bloom_counter2_blocked(const double fp, const size_t n, const HashPair& fns = HashPair()) :
+    mem_block_t(super::nb_bytes__(super::opt_m(fp, n))),
+    super(super::opt_m(fp, n), super::opt_k(fp), (unsigned char*)mem_block_t::get_ptr(), fns)
+  {
+    if(!mem_block_t::get_ptr())
+      throw std::runtime_error(err::msg() << "Failed to allocate " << super::nb_bytes__(super::opt_m(fp, n))
+                               << " bytes of memory for bloom_counter");
+  }
+
+  bloom_counter2_blocked(size_t m, unsigned long k, const HashPair& fns = HashPair()) :
+    mem_block_t(super::nb_bytes__(m)),
+    super(m, k, (unsigned char*)mem_block_t::get_ptr(), fns)
+  {
+    if(!mem_block_t::get_ptr())
+      throw std::runtime_error(err::msg() << "Failed to allocate " << super::nb_bytes__(m) << " bytes of memory for bloom_counter");
+  }
+
+  bloom_counter2_blocked(size_t m, unsigned long k, std::istream& is, const HashPair& fns = HashPair()) :
+    mem_block_t(super::nb_bytes__(m)),
+    super(m, k, (unsigned char*)mem_block_t::get_ptr(), fns)
+  {
+    if(!mem_block_t::get_ptr())
+      throw std::runtime_error(err::msg() << "Failed to allocate " << super::nb_bytes__(m) << " bytes of memory for bloom_counter");
+
+    is.read((char*)mem_block_t::get_ptr(), super::nb_bytes());
+  }
+
+  bloom_counter2_blocked(const bloom_counter2_blocked& rhs) = delete;
+  bloom_counter2_blocked(bloom_counter2_blocked&& rhs) :
+    mem_block_t(std::move(rhs)),
+    super(std::move(rhs))
+  { }
+};
+
+template<typename Key, typename HashPair = hash_pair<Key>, typename atomic_t = ::atomic::standard>
+class bloom_counter2_blocked_file :
+    protected mapped_file,
+    public bloom_counter2_blocked_base<Key, HashPair, atomic_t>
+{
+  typedef bloom_counter2_blocked_base<Key, HashPair, atomic_t> super;
+public:
+  typedef typename super::key_type key_type;
+
+  bloom_counter2_blocked_file(size_t m, unsigned long k, const char* path, const HashPair& fns = HashPair(), off_t offset = 0,
+                               int map_flags = 0) :
+    mapped_file(path, map_flags),
+    super(m, k, (unsigned char*)mapped_file::base() + offset, fns)
+  {
+    if(mapped_file::length() < offset + super::nb_bytes())
+      throw std::runtime_error(err::msg() << "File '" << path << "' is truncated");
+  }
+
+  /// The mapped file, e.g. to give advice on its use
+  const mapped_file& file() const { return *this; }
+
+  bloom_counter2_blocked_file(const bloom_counter2_blocked_file& rhs) = delete;
+  bloom_counter2_blocked_file(bloom_counter2_blocked_file&& rhs) :
+    mapped_file(std::move(rhs)),
+    super(std::move(rhs))
+  { }
+};
+
+} // namespace jellyfish {
+
+#endif // __BLOOM_COUNTER2_BLOCKED_HPP__
@@ -18,11 +18,11 @@
 #define __JELLYFISH_BLOOM_FILTER_HPP__
 
 #include <jellyfish/allocators_mmap.hpp>
-#include <jellyfish/atomic_gcc.hpp>
+#include <jellyfish/atomic_cxx11.hpp>
 #include <jellyfish/bloom_common.hpp>
 
 namespace jellyfish {
-template<typename Key, typename HashPair = hash_pair<Key>, typename atomic_t = ::atomic::gcc>
+template<typename Key, typename HashPair = hash_pair<Key>, typename atomic_t = ::atomic::standard>
 class bloom_filter_base :
     public bloom_base<Key, bloom_filter_base<Key, HashPair>, HashPair>
 {
@@ -46,13 +46,8 @@ public:
     return nb_bytes__(super::d_.d());
   }
 
-  // Insert key with given hashes
-  unsigned int insert__(const uint64_t *hashes) {
-    // Prefetch memory locations
-    // This static_assert make clang++ happy...
-    static_assert(std::is_pod<typename super::prefetch_info>::value, "prefetch_info must be a POD");
-
-    typename super::prefetch_info pinfo[super::k_];
+  // Memory locations of the bits of a key with given hashes
+  void positions__(const uint64_t* hashes, typename super::prefetch_info* pinfo) const {
     const size_t base    = super::d_.remainder(hashes[0]);
     const size_t inc     = super::d_.remainder(hashes[1]);
     for(unsigned long i = 0; i < super::k_; ++i) {
@@ -60,14 +55,38 @@ public:
       const size_t elt_i = pos / 8;
       pinfo[i].boff      = pos % 8;
       pinfo[i].pos       = super::data_ + elt_i;
-      __builtin_prefetch(pinfo[i].pos, 1, 0);
     }
+  }
+
+  // Compute and prefetch the bits of a key with given hashes
+  void prefetch_at__(const uint64_t* hashes, typename super::prefetch_info* pinfo, bool write) const {
+    positions__(hashes, pinfo);
+    for(unsigned long i = 0; i < super::k_; ++i) {
+      if(write)
+        __builtin_prefetch(pinfo[i].pos, 1, 0);
+      else
+        __builtin_prefetch(pinfo[i].pos, 0, 0);
+    }
+  }
+
+  // Insert key with given hashes
+  unsigned int insert__(const uint64_t *hashes) {
+    // Prefetch memory locations
+    // This static_assert make clang++ happy...
+    static_assert(std::is_pod<typename super::prefetch_info>::value, "prefetch_info must be a POD");
 
+    typename super::prefetch_info pinfo[super::k_];
+    prefetch_at__(hashes, pinfo, true);
+    return insert_at__(hashes, pinfo);
+  }
+
+  // Insert key whose bits were computed by prefetch_at__
+  unsigned int insert_at__(const uint64_t*, const typename super::prefetch_info* pinfo) {
     // Check if element present
     bool present = true;
     for(unsigned long i = 0; i < super::k_; ++i) {
-      const char mask = (char)1 << pinfo[i].boff;
-      const char prev = __sync_fetch_and_or(pinfo[i].pos, mask);
+      const unsigned char mask = (unsigned char)1 << pinfo[i].boff;
+      const unsigned char prev = atomic_t::fetch_or(pinfo[i].pos, mask);
       present         = present && (prev & mask);
     }
 
@@ -81,16 +100,12 @@ public:
     // Prefetch memory locations
     static_assert(std::is_pod<typename super::prefetch_info>::value, "prefetch_info must be a POD");
     typename super::prefetch_info pinfo[super::k_];
-    const size_t base    = super::d_.remainder(hashes[0]);
-    const size_t inc     = super::d_.remainder(hashes[1]);
-    for(unsigned long i = 0; i < super::k_; ++i) {
-      const size_t pos   = super::d_.remainder(base + i * inc);
-      const size_t elt_i = pos / 8;
-      pinfo[i].boff      = pos % 8;
-      pinfo[i].pos       = super::data_ + elt_i;
-      __builtin_prefetch(pinfo[i].pos, 0, 0);
-    }
+    prefetch_at__(hashes, pinfo, false);
+    return check_at__(hashes, pinfo);
+  }
 
+  // Check key whose bits were computed by prefetch_at__
+  unsigned int check_at__(const uint64_t*, const typename super::prefetch_info* pinfo) const {
     for(unsigned long i = 0; i < super::k_; ++i)
       if(!(jflib::a_load(pinfo[i].pos) & ((char)1 << pinfo[i].boff)))
         return 0;
@@ -98,7 +113,7 @@ public:
   }
 };
 
-template<typename Key, typename HashPair = hash_pair<Key>, typename atomic_t = ::atomic::gcc,
+template<typename Key, typename HashPair = hash_pair<Key>, typename atomic_t = ::atomic::standard,
          typename mem_block_t = allocators::mmap>
 class bloom_filter :
   protected mem_block_t,
@@ -106,6 +121,11 @@ class bloom_filter :
 {
   typedef bloom_filter_base<Key, HashPair, atomic_t> super;
 public:
+  /// Memory used for n elements with a false positive rate of fp
+  static size_t mem(const double fp, const size_t n) {
+    return super::nb_bytes__(super::opt_m(fp, n));
+  }
+
   bloom_filter(double fp, size_t n, const HashPair& fns = HashPair()) :
     mem_block_t(super::nb_bytes__(super::opt_m(fp, n))),
     super(super::opt_m(fp, n), super::opt_k(fp), (unsigned char*)mem_block_t::get_ptr(), fns)
@@ -139,7 +159,7 @@ public:
   { }
 };
 
-template<typename Key, typename HashPair = hash_pair<Key>, typename atomic_t = ::atomic::gcc>
+template<typename Key, typename HashPair = hash_pair<Key>, typename atomic_t = ::atomic::standard>
 class bloom_filter_file :
     protected mapped_file,
     public bloom_filter_base<Key, HashPair, atomic_t>
@@ -148,10 +168,17 @@ class bloom_filter_file :
 public:
   typedef typename super::key_type key_type;
 
-  bloom_filter_file(size_t m, unsigned long k, const char* path, const HashPair& fns = HashPair(), off_t offset = 0) :
-    mapped_file(path),
+  bloom_filter_file(size_t m, unsigned long k, const char* path, const HashPair& fns = HashPair(), off_t offset = 0,
+                     int map_flags = 0) :
+    mapped_file(path, map_flags),
     super(m, k, (unsigned char*)mapped_file::base() + offset, fns)
-  { }
+  {
+    if(mapped_file::length() < offset + super::nb_bytes())
+      throw std::runtime_error(err::msg() << "File '" << path << "' is truncated");
+  }
+
+  /// The mapped file, e.g. to give advice on its use
+  const mapped_file& file() const { return *this; }
 
   bloom_filter_file(const bloom_filter_file& rhs) = delete;
   bloom_filter_file(bloom_filter_file&& rhs) :
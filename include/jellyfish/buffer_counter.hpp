@@ -0,0 +1,269 @@
+/*  This file is part of Jellyfish.
+
+    Jellyfish is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Jellyfish is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Jellyfish.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __JELLYFISH_BUFFER_COUNTER_HPP__
+#define __JELLYFISH_BUFFER_COUNTER_HPP__
+
+#include <time.h>
+#include <sys/time.h>
+
+#include <deque>
+#include <algorithm>
+#include <stdexcept>
+
+#include <jellyfish/mer_dna.hpp>
+#include <jellyfish/cooperative_pool2.hpp>
+#include <jellyfish/mer_iterator.hpp>
+#include <jellyfish/thread_exec.hpp>
+#include <jellyfish/locks_pthread.hpp>
+
+namespace jellyfish {
+/// Sequences in memory, given by the caller as (pointer, length)
+/// buffers. The buffers are not copied: a long buffer is split into
+/// chunks overlapping by k-1 bases, which point into it.
+struct sequence_buffer {
+  struct batch;
+
+  const char* start;
+  const char* end;
+  batch*      owner;
+
+  /// The buffers added in one call, waiting for their chunks to be
+  /// consumed.
+  struct batch {
+    size_t               pending;
+    locks::pthread::cond cond;
+
+    batch() : pending(0) { }
+    void done() {
+      cond.lock();
+      if(--pending == 0)
+        cond.broadcast();
+      cond.unlock();
+    }
+    void wait() {
+      cond.lock();
+      while(pending > 0)
+        cond.wait();
+      cond.unlock();
+    }
+  };
+
+  sequence_buffer() : start(0), end(0), owner(0) { }
+};
+
+/// Cooperative pool of sequence buffers pushed by any thread. The
+/// pool has one producer, which hands over the chunks of the buffers
+/// in the order they were pushed and waits for more until close() is
+/// called. The consumers add the k-mers to a cooperative hash_counter:
+/// while waiting for buffers, they take part in the size doubling of
+/// the hash, if needed by the other threads.
+template<typename HashCounter>
+class buffer_sequence_pool : public cooperative_pool2<buffer_sequence_pool<HashCounter>, sequence_buffer> {
+  typedef cooperative_pool2<buffer_sequence_pool<HashCounter>, sequence_buffer> super;
+
+  HashCounter&                hash_;
+  const size_t                chunk_size_;
+  std::deque<sequence_buffer> queue_;
+  bool                        closed_;
+  locks::pthread::cond        cond_; // Protects queue_ and closed_
+
+public:
+  /// The chunks handed over to the consumers are at most chunk_size +
+  /// k - 1 bases long. size is the number of chunks in the pool.
+  buffer_sequence_pool(HashCounter& hash, uint32_t size, size_t chunk_size = 4096) :
+    super(1, size),
+    hash_(hash),
+    chunk_size_(std::max(chunk_size, (size_t)1)),
+    closed_(false)
+  { }
+
+  /// A job releases the chunks of the buffers it consumed, so that
+  /// the batches are told when they are entirely consumed.
+  class job : public super::job {
+    void release_chunk() {
+      if(!this->is_empty() && (*this)->owner)
+        (*this)->owner->done();
+    }
+
+  public:
+    explicit job(buffer_sequence_pool& pool) : super::job(pool) { }
+    ~job() { release_chunk(); }
+    void next() {
+      release_chunk();
+      super::job::next();
+    }
+  };
+
+  /// Push nb buffers, then wait until all of their chunks have been
+  /// consumed. The buffers must not change meanwhile.
+  void push(const char* const* seqs, const size_t* lens, size_t nb) {
+    const unsigned int     overlap = mer_dna::k() - 1;
+    sequence_buffer::batch batch;
+    cond_.lock();
+    if(closed_) {
+      cond_.unlock();
+      throw std::logic_error("Sequences pushed to a closed pool");
+    }
+    for(size_t i = 0; i < nb; ++i) {
+      if(lens[i] <= overlap) continue;
+      for(size_t off = 0; off + overlap < lens[i]; off += chunk_size_) {
+        sequence_buffer b;
+        b.start = seqs[i] + off;
+        b.end   = seqs[i] + std::min(lens[i], off + chunk_size_ + overlap);
+        b.owner = &batch;
+        queue_.push_back(b);
+        ++batch.pending;
+      }
+    }
+    cond_.broadcast();
+    cond_.unlock();
+    batch.wait();
+  }
+  void push(const char* seq, size_t len) { push(&seq, &len, 1); }
+
+  /// No more buffers will be pushed. The consumers finish when the
+  /// pool is empty.
+  void close() {
+    cond_.lock();
+    closed_ = true;
+    cond_.broadcast();
+    cond_.unlock();
+  }
+
+  bool produce(uint32_t i, sequence_buffer& e) {
+    cond_.lock();
+    while(queue_.empty() && !closed_) {
+      wait_for_buffer();
+      cond_.unlock();
+      hash_.sync();
+      cond_.lock();
+    }
+    const bool done = queue_.empty();
+    if(!done) {
+      e = queue_.front();
+      queue_.pop_front();
+    }
+    cond_.unlock();
+    return done;
+  }
+
+  /// While the producer waits for buffers, the consumers wait for at
+  /// most a millisecond, or until a buffer is pushed, instead of
+  /// backing off for up to a second.
+  void delay(int iteration) {
+    if(iteration < 16)
+      return;
+    cond_.lock();
+    if(queue_.empty() && !closed_)
+      wait_for_buffer();
+    cond_.unlock();
+    hash_.sync();
+  }
+
+private:
+  // Wait on cond_, locked, for at most a millisecond
+  void wait_for_buffer() {
+    struct timespec deadline;
+#ifdef HAVE_CLOCK_GETTIME
+    clock_gettime(CLOCK_REALTIME, &deadline);
+#else
+    struct timeval timeofday;
+    gettimeofday(&timeofday, 0);
+    deadline.tv_sec  = timeofday.tv_sec;
+    deadline.tv_nsec = timeofday.tv_usec * 1000;
+#endif
+    deadline.tv_nsec += 1000000;
+    if(deadline.tv_nsec >= 1000000000) {
+      deadline.tv_sec  += 1;
+      deadline.tv_nsec -= 1000000000;
+    }
+    cond_.timedwait(&deadline);
+  }
+};
+
+/// Count the k-mers of sequences in memory into a hash_counter on
+/// mer_dna. The buffers are added by any number of threads with
+/// add(), while nb_threads() threads (the number the hash was created
+/// with) count the k-mers. For example:
+///
+/// ~~~{.cc}
+/// mer_hash hash(size, mer_dna::k() * 2, counter_len, nb_threads);
+/// buffer_counter<mer_hash> counter(hash, canonical);
+/// counter.start_counting();
+/// // In any thread(s):
+/// counter.add(seq, len);
+/// // Then:
+/// counter.finish();
+/// // The hash has the counts: dump it or query it.
+/// ~~~
+///
+/// A buffer is one sequence of bases, without header nor new line. A
+/// k-mer with a base other than ACGT is skipped. The dumper of the
+/// hash, if any, is used if the hash is full and cannot double in
+/// size.
+template<typename HashCounter>
+class buffer_counter : public thread_exec {
+  typedef buffer_sequence_pool<HashCounter> pool_type;
+  typedef mer_iterator<pool_type, mer_dna>  mer_iterator_type;
+
+  HashCounter& hash_;
+  pool_type    pool_;
+  const bool   canonical_;
+  bool         started_;
+
+public:
+  /// chunk_size is the length of the pieces a long sequence is split
+  /// into, to be counted in parallel.
+  buffer_counter(HashCounter& hash, bool canonical = false, size_t chunk_size = 4096) :
+    hash_(hash),
+    pool_(hash, 3 * hash.nb_threads(), chunk_size),
+    canonical_(canonical),
+    started_(false)
+  { }
+  ~buffer_counter() { finish(); }
+
+  /// Start the counting threads
+  void start_counting() {
+    if(started_) return;
+    started_ = true;
+    exec(hash_.nb_threads());
+  }
+
+  /// Add the k-mers of the nb sequences seqs[i] of length
+  /// lens[i]. Returns once they are counted: the buffers may then be
+  /// reused. Thread safe.
+  void add(const char* const* seqs, const size_t* lens, size_t nb) { pool_.push(seqs, lens, nb); }
+  void add(const char* seq, size_t len) { pool_.push(seq, len); }
+
+  /// Wait for the counting threads to be done. No buffer can be added
+  /// afterwards.
+  void finish() {
+    if(!started_) return;
+    started_ = false;
+    pool_.close();
+    join();
+  }
+
+  virtual void start(int thid) {
+    for(mer_iterator_type mers(pool_, canonical_); mers; ++mers)
+      hash_.add(*mers, 1);
+    hash_.done();
+  }
+};
+} // namespace jellyfish
+
+#endif /* __JELLYFISH_BUFFER_COUNTER_HPP__ */
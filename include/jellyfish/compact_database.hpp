@@ -0,0 +1,198 @@
+/*  This file is part of Jellyfish.
+
+    Jellyfish is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Jellyfish is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Jellyfish.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef __JELLYFISH_COMPACT_DATABASE_HPP__
+#define __JELLYFISH_COMPACT_DATABASE_HPP__
+
+#include <string.h>
+#include <memory>
+#include <ostream>
+#include <stdexcept>
+
+#include <jellyfish/err.hpp>
+#include <jellyfish/misc.hpp>
+#include <jellyfish/mphf.hpp>
+#include <jellyfish/atomic_bits_array.hpp>
+#include <jellyfish/file_header.hpp>
+#include <jellyfish/binary_dumper.hpp>
+#include <jellyfish/thread_exec.hpp>
+
+namespace jellyfish {
+/// A compact database is static: the k-mers are not stored, only a
+/// minimal perfect hash function (MPHF) over them. The data after the
+/// header is made of, in order:
+///
+/// - the bits of the levels of the MPHF (64-bit words),
+/// - the rank samples of the MPHF (64-bit words),
+/// - the counts, packed on counter_bits() bits,
+/// - the fingerprints of the keys, packed on fingerprint_len() bits (optional).
+///
+/// Without fingerprints, querying a k-mer not in the database returns
+/// the count of a random k-mer, or 0. With f bits of fingerprint, it
+/// returns 0 with probability 1 - 2^-f.
+namespace compact {
+const char* const format = "compact/mphf";
+
+/// Number of bytes used by size entries of bits bits in an atomic_bits_array
+inline size_t packed_bytes(int bits, size_t size) {
+  const size_t per_word = 64 / bits;
+  return (size / per_word + (size % per_word != 0)) * sizeof(uint64_t);
+}
+
+/// Fingerprint of a key, from a hash seed not used by any level of the MPHF.
+template<typename Key>
+inline uint64_t fingerprint(const Key& k, unsigned int bits) {
+  return mphf::hash(k, (uint64_t)-1) >> (64 - bits);
+}
+
+/// Build a compact database from a binary/sorted one and write it.
+template<typename Key, typename Val>
+class builder : public thread_exec {
+  typedef binary_records<Key, Val>           records;
+  typedef atomic_bits_array<uint64_t>        packed_array;
+
+  const records&                   records_;
+  const int                        nb_threads_;
+  const unsigned int               fingerprint_len_;
+  mphf::builder<Key, records>      mphf_;
+  const mphf::query                query_;
+  std::vector<Val>                 max_vals_;
+  std::unique_ptr<packed_array>    counts_;
+  std::unique_ptr<packed_array>    fingerprints_;
+  int                              phase_;
+
+public:
+  builder(const records& recs, unsigned int fingerprint_len = 0, double gamma = 2.0, int nb_threads = 1) :
+    records_(recs),
+    nb_threads_(std::max(1, nb_threads)),
+    fingerprint_len_(std::min(64u, fingerprint_len)),
+    mphf_(recs, gamma, nb_threads_),
+    query_(mphf_.get_query()),
+    max_vals_(nb_threads_, 0)
+  {
+    phase_ = 0;
+    exec_join(nb_threads_);
+    const Val max_val = *std::max_element(max_vals_.cbegin(), max_vals_.cend());
+    counts_.reset(new packed_array(std::max(1, (int)bitsize(max_val)), records_.size()));
+    if(fingerprint_len_ > 0)
+      fingerprints_.reset(new packed_array(fingerprint_len_, records_.size()));
+    phase_ = 1;
+    exec_join(nb_threads_);
+  }
+
+  virtual void start(int thid) {
+    const size_t start = (records_.size() * thid) / nb_threads_;
+    const size_t end   = (records_.size() * (thid + 1)) / nb_threads_;
+    Key          key;
+
+    if(phase_ == 0) {
+      Val& max_val = max_vals_[thid];
+      for(size_t id = start; id < end; ++id)
+        max_val = std::max(max_val, records_.val_at(id));
+      return;
+    }
+
+    for(size_t id = start; id < end; ++id) {
+      records_.key_at(id, key);
+      const uint64_t i = query_(key);
+      uint64_t       v = records_.val_at(id);
+      auto           c = (*counts_)[i];
+      c.get();
+      c.set(v);
+      if(fingerprints_) {
+        uint64_t f = fingerprint(key, fingerprint_len_);
+        auto     e = (*fingerprints_)[i];
+        e.get();
+        e.set(f);
+      }
+    }
+  }
+
+  /// Update the header with the information about this database.
+  void update_header(file_header& header) const {
+    header.format(format);
+    header.size(records_.size());
+    header.mphf_levels(mphf_.sizes());
+    header.counter_bits(counts_->bits());
+    header.fingerprint_len(fingerprint_len_);
+  }
+
+  /// Write data after the header
+  void write(std::ostream& os) const {
+    os.write((const char*)mphf_.bits().data(), mphf_.bits().size() * sizeof(uint64_t));
+    os.write((const char*)mphf_.ranks().data(), mphf_.ranks().size() * sizeof(uint64_t));
+    counts_->write(os);
+    if(fingerprints_)
+      fingerprints_->write(os);
+  }
+};
+
+/// Query a compact database in memory (usually a mapped file). The
+/// memory is only read.
+template<typename Key, typename Val>
+class query {
+  typedef atomic_bits_array_raw<uint64_t> packed_array;
+
+  const size_t                  size_;
+  const unsigned int            fingerprint_len_;
+  std::unique_ptr<mphf::query>  query_;
+  std::unique_ptr<packed_array> counts_;
+  std::unique_ptr<packed_array> fingerprints_;
+
+public:
+  query(const char* data, const file_header& header, size_t length) :
+    size_(header.size()),
+    fingerprint_len_(header.fingerprint_len())
+  {
+    const std::vector<uint64_t> levels      = header.mphf_levels();
+    const size_t                bits_len    = mphf::query::nb_words(levels) * sizeof(uint64_t);
+    const size_t                ranks_len   = mphf::query::nb_ranks(levels) * sizeof(uint64_t);
+    const size_t                counts_len  = packed_bytes(header.counter_bits(), size_);
+    const size_t                fp_len      = fingerprint_len_ ? packed_bytes(fingerprint_len_, size_) : 0;
+    if(length < bits_len + ranks_len + counts_len + fp_len)
+      throw std::length_error(err::msg() << "Size of compact database (" << length << ") is too small, expected "
+                              << (bits_len + ranks_len + counts_len + fp_len));
+    char* ptr = const_cast<char*>(data);
+    query_.reset(new mphf::query(levels, (const uint64_t*)ptr, (const uint64_t*)(ptr + bits_len)));
+    ptr += bits_len + ranks_len;
+    counts_.reset(new packed_array(ptr, counts_len, header.counter_bits(), size_));
+    ptr += counts_len;
+    if(fingerprint_len_)
+      fingerprints_.reset(new packed_array(ptr, fp_len, fingerprint_len_, size_));
+  }
+
+  size_t size() const { return size_; }
+
+  Val operator[](const Key& key) const {
+    const uint64_t id = (*query_)(key);
+    if(id >= size_) return 0;
+    if(fingerprints_ && (uint64_t)(*fingerprints_)[id] != fingerprint(key, fingerprint_len_))
+      return 0;
+    return (uint64_t)(*counts_)[id];
+  }
+  inline Val check(const Key& key) const { return (*this)[key]; }
+
+  /// Prefetch the memory for key. Same interface as
+  /// binary_hash_query.
+  size_t prefetch(const Key& key) const {
+    query_->prefetch(key);
+    return 0;
+  }
+  Val check(const Key& key, size_t pos) const { return (*this)[key]; }
+};
+} // namespace compact
+} // namespace jellyfish
+
+#endif /* __JELLYFISH_COMPACT_DATABASE_HPP__ */
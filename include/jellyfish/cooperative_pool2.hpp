@@ -23,7 +23,10 @@
 
 #include <jellyfish/circular_buffer.hpp>
 #include <jellyfish/compare_and_swap.hpp>
+#include <jellyfish/atomic_cxx11.hpp>
 #include <jellyfish/locks_pthread.hpp>
+#include <jellyfish/thread_stats.hpp>
+#include <jellyfish/trace.hpp>
 
 /// Cooperative pool. Provide a link between many producers and many
 /// consumers. It is cooperative in the sense that there is no
@@ -207,7 +210,22 @@ public:
 
 private:
   enum PRODUCER_STATUS { PRODUCER_PRODUCED, PRODUCER_DONE, PRODUCER_EXISTS };
+
+  // Get an element. If collecting thread statistics, count the time
+  // waiting for it, not counting the time spent producing.
   uint32_t get_element() {
+    thread_stats* stats = thread_stats::current();
+    if(!stats)
+      return dequeue_element();
+    const uint64_t start      = thread_stats::now_ns();
+    const uint64_t produce_ns = stats->produce_ns;
+    const uint32_t res        = dequeue_element();
+    ++stats->consume_calls;
+    stats->consume_ns += (thread_stats::now_ns() - start) - (stats->produce_ns - produce_ns);
+    return res;
+  }
+
+  uint32_t dequeue_element() {
     int iteration = 0;
 
     while(true) {
@@ -229,7 +247,7 @@ private:
       case PRODUCER_DONE:
         return prod_cons_.dequeue();
       case PRODUCER_EXISTS:
-        delay(iteration++); // Already a producer. Wait a bit it adds things to queue
+        static_cast<D*>(this)->delay(iteration++); // Already a producer. Wait a bit it adds things to queue
         break;
       }
     }
@@ -252,7 +270,7 @@ private:
         if(i == cbT::guard)
           return PRODUCER_PRODUCED;
 
-        if(static_cast<D*>(this)->produce(producer_token.token_, elts_[i])) // produce returns true if done
+        if(timed_produce(producer_token.token_, elts_[i])) // produce returns true if done
           break;
 
         prod_cons_.enqueue_no_check(i);
@@ -262,7 +280,7 @@ private:
     // Producing is done for this producer
     cons_prod_.enqueue_no_check(i);
     producer_token.drop();
-    uint32_t is_done = __sync_add_and_fetch(&done_, (uint32_t)1);
+    uint32_t is_done = ::atomic::standard::add_fetch(&done_, (uint32_t)1);
     if(is_done < max_producers_)
       return PRODUCER_PRODUCED;
 
@@ -270,7 +288,17 @@ private:
     return PRODUCER_DONE;
   }
 
-  // First 16 operations -> no delay. Then exponential back-off up to a second.
+  bool timed_produce(uint32_t token, element_type& e) {
+    thread_stats::incr<&thread_stats::produce_calls>();
+    thread_stats::timer<&thread_stats::produce_ns> timer;
+    trace::span                                    span("produce");
+    return static_cast<D*>(this)->produce(token, e);
+  }
+
+protected:
+  // First 16 operations -> no delay. Then exponential back-off up to
+  // a second. The derived class may hide this method to wait
+  // differently.
   void delay(int iteration) {
     if(iteration < 16)
       return;
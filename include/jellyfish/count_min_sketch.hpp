@@ -0,0 +1,235 @@
+/*  This file is part of Jellyfish.
+
+    Jellyfish is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Jellyfish is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Jellyfish.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef __JELLYFISH_COUNT_MIN_SKETCH_HPP__
+#define __JELLYFISH_COUNT_MIN_SKETCH_HPP__
+
+#include <jellyfish/bloom_common.hpp>
+#include <jellyfish/mapped_file.hpp>
+#include <jellyfish/allocators_mmap.hpp>
+#include <jellyfish/atomic_cxx11.hpp>
+#include <jellyfish/err.hpp>
+
+namespace jellyfish {
+/* Count-min sketch with conservative update: a counting bloom filter
+   whose cells are saturating counters of 4 or 8 bits. The estimate of
+   a key is the minimum of its k cells, and an insertion only
+   increments the cells equal to this minimum. The estimate is never
+   lower than the true count (up to saturation). It is thread safe and
+   lock free. Under concurrent insertions, the conservative update is
+   approximate: a cell may be incremented past the new minimum.
+ */
+template<typename Key, typename HashPair = hash_pair<Key>, typename atomic_t = ::atomic::standard>
+class count_min_sketch_base :
+    public bloom_base<Key, count_min_sketch_base<Key, HashPair, atomic_t>, HashPair> {
+  typedef bloom_base<Key, count_min_sketch_base<Key, HashPair, atomic_t>, HashPair> super;
+
+  atomic_t            atomic_;
+  const unsigned int  bits_;
+  const unsigned int  cells_per_byte_;
+  const unsigned char max_;
+
+protected:
+  static size_t nb_bytes__(size_t m, unsigned int bits) {
+    return (m * bits + 7) / 8;
+  }
+
+  static unsigned char cell(unsigned char v, size_t shift, unsigned char max) {
+    return (v >> shift) & max;
+  }
+
+public:
+  count_min_sketch_base(size_t m, unsigned long k, unsigned int bits, unsigned char* ptr,
+                        const HashPair& fns = HashPair()) :
+    super(m, k, ptr, fns),
+    bits_(bits),
+    cells_per_byte_(8 / bits),
+    max_((1 << bits) - 1)
+  {
+    if(bits != 4 && bits != 8)
+      throw std::runtime_error(err::msg() << "Invalid number of bits per cell " << bits << ". Must be 4 or 8");
+  }
+  count_min_sketch_base(count_min_sketch_base&& rhs) :
+    super(std::move(rhs)),
+    bits_(rhs.bits_),
+    cells_per_byte_(rhs.cells_per_byte_),
+    max_(rhs.max_)
+  { }
+  size_t nb_bytes() const {
+    return nb_bytes__(super::d_.d(), bits_);
+  }
+  // Number of bits per cell
+  unsigned int bits() const { return bits_; }
+  // Largest value of a cell
+  unsigned int max_count() const { return max_; }
+
+  // Memory locations of the cells of a key with given hashes. boff
+  // is the shift of the cell in its byte.
+  void positions__(const uint64_t* hashes, typename super::prefetch_info* pinfo) const {
+    const size_t base = super::d_.remainder(hashes[0]);
+    const size_t inc  = super::d_.remainder(hashes[1]);
+    for(unsigned long i = 0; i < super::k_; ++i) {
+      const size_t p = super::d_.remainder(base + i * inc);
+      pinfo[i].boff  = (p % cells_per_byte_) * bits_;
+      pinfo[i].pos   = super::data_ + p / cells_per_byte_;
+    }
+  }
+
+  // Compute and prefetch the cells of a key with given hashes
+  void prefetch_at__(const uint64_t* hashes, typename super::prefetch_info* pinfo, bool write) const {
+    positions__(hashes, pinfo);
+    for(unsigned long i = 0; i < super::k_; ++i) {
+      if(write)
+        __builtin_prefetch(pinfo[i].pos, 1, 0);
+      else
+        __builtin_prefetch(pinfo[i].pos, 0, 0);
+    }
+  }
+
+  // Insert key with given hashes. Returns the previous estimate.
+  unsigned int insert__(const uint64_t* hashes) {
+    static_assert(std::is_pod<typename super::prefetch_info>::value, "prefetch_info must be a POD");
+    typename super::prefetch_info pinfo[super::k_];
+    prefetch_at__(hashes, pinfo, true);
+    return insert_at__(hashes, pinfo);
+  }
+
+  // Insert key whose cells were computed by prefetch_at__
+  unsigned int insert_at__(const uint64_t*, const typename super::prefetch_info* pinfo) {
+    unsigned char res = max_;
+    for(unsigned long i = 0; i < super::k_; ++i) {
+      const unsigned char w = cell(jflib::a_load(pinfo[i].pos), pinfo[i].boff, max_);
+      if(w < res)
+        res = w;
+    }
+    if(res == max_)
+      return res;
+
+    // Conservative update: raise the cells below the new estimate
+    const unsigned char nw = res + 1;
+    for(unsigned long i = 0; i < super::k_; ++i) {
+      const size_t  shift = pinfo[i].boff;
+      unsigned char v     = jflib::a_load(pinfo[i].pos);
+      while(cell(v, shift, max_) < nw) {
+        const unsigned char nv = (v & ~(max_ << shift)) | (nw << shift);
+        if(atomic_.cas_weak(pinfo[i].pos, &v, nv)) break;
+      }
+    }
+    return res;
+  }
+
+  // Estimate of the count of key with given hashes
+  unsigned int check__(const uint64_t* hashes) const {
+    static_assert(std::is_pod<typename super::prefetch_info>::value, "prefetch_info must be a POD");
+    typename super::prefetch_info pinfo[super::k_];
+    prefetch_at__(hashes, pinfo, false);
+    return check_at__(hashes, pinfo);
+  }
+
+  // Estimate of the count of key whose cells were computed by prefetch_at__
+  unsigned int check_at__(const uint64_t*, const typename super::prefetch_info* pinfo) const {
+    unsigned char res = max_;
+    for(unsigned long i = 0; i < super::k_; ++i) {
+      const unsigned char w = cell(jflib::a_load(pinfo[i].pos), pinfo[i].boff, max_);
+      if(w < res)
+        res = w;
+    }
+    return res;
+  }
+};
+
+template<typename Key, typename HashPair = hash_pair<Key>, typename atomic_t = ::atomic::standard,
+         typename mem_block_t = allocators::mmap>
+class count_min_sketch :
+    protected mem_block_t,
+    public count_min_sketch_base<Key, HashPair, atomic_t>
+{
+  typedef count_min_sketch_base<Key, HashPair, atomic_t> super;
+
+public:
+  typedef typename super::key_type key_type;
+
+  /// Memory used for n elements with a false positive rate of fp
+  static size_t mem(const double fp, const size_t n, unsigned int bits) {
+    return super::nb_bytes__(super::opt_m(fp, n), bits);
+  }
+
+  count_min_sketch(const double fp, const size_t n, unsigned int bits, const HashPair& fns = HashPair()) :
+    mem_block_t(super::nb_bytes__(super::opt_m(fp, n), bits)),
+    super(super::opt_m(fp, n), super::opt_k(fp), bits, (unsigned char*)mem_block_t::get_ptr(), fns)
+  {
+    if(!mem_block_t::get_ptr())
+      throw std::runtime_error(err::msg() << "Failed to allocate " << super::nb_bytes__(super::opt_m(fp, n), bits)
+                               << " bytes of memory for count_min_sketch");
+  }
+
+  count_min_sketch(size_t m, unsigned long k, unsigned int bits, const HashPair& fns = HashPair()) :
+    mem_block_t(super::nb_bytes__(m, bits)),
+    super(m, k, bits, (unsigned char*)mem_block_t::get_ptr(), fns)
+  {
+    if(!mem_block_t::get_ptr())
+      throw std::runtime_error(err::msg() << "Failed to allocate " << super::nb_bytes__(m, bits) << " bytes of memory for count_min_sketch");
+  }
+
+  count_min_sketch(size_t m, unsigned long k, unsigned int bits, std::istream& is, const HashPair& fns = HashPair()) :
+    mem_block_t(super::nb_bytes__(m, bits)),
+    super(m, k, bits, (unsigned char*)mem_block_t::get_ptr(), fns)
+  {
+    if(!mem_block_t::get_ptr())
+      throw std::runtime_error(err::msg() << "Failed to allocate " << super::nb_bytes__(m, bits) << " bytes of memory for count_min_sketch");
+
+    is.read((char*)mem_block_t::get_ptr(), super::nb_bytes());
+  }
+
+  count_min_sketch(const count_min_sketch& rhs) = delete;
+  count_min_sketch(count_min_sketch&& rhs) :
+    mem_block_t(std::move(rhs)),
+    super(std::move(rhs))
+  { }
+};
+
+template<typename Key, typename HashPair = hash_pair<Key>, typename atomic_t = ::atomic::standard>
+class count_min_sketch_file :
+    protected mapped_file,
+    public count_min_sketch_base<Key, HashPair, atomic_t>
+{
+  typedef count_min_sketch_base<Key, HashPair, atomic_t> super;
+public:
+  typedef typename super::key_type key_type;
+
+  count_min_sketch_file(size_t m, unsigned long k, unsigned int bits, const char* path,
+                        const HashPair& fns = HashPair(), off_t offset = 0, int map_flags = 0) :
+    mapped_file(path, map_flags),
+    super(m, k, bits, (unsigned char*)mapped_file::base() + offset, fns)
+  {
+    if(mapped_file::length() < offset + super::nb_bytes())
+      throw std::runtime_error(err::msg() << "File '" << path << "' is truncated");
+  }
+
+  /// The mapped file, e.g. to give advice on its use
+  const mapped_file& file() const { return *this; }
+
+  count_min_sketch_file(const count_min_sketch_file& rhs) = delete;
+  count_min_sketch_file(count_min_sketch_file&& rhs) :
+    mapped_file(std::move(rhs)),
+    super(std::move(rhs))
+  { }
+};
+
+} // namespace jellyfish {
+
+#endif // __JELLYFISH_COUNT_MIN_SKETCH_HPP__
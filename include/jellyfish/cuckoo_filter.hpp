@@ -0,0 +1,331 @@
+/*  This file is part of Jellyfish.
+
+    Jellyfish is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Jellyfish is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Jellyfish.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __JELLYFISH_CUCKOO_FILTER_HPP__
+#define __JELLYFISH_CUCKOO_FILTER_HPP__
+
+#include <stdint.h>
+#include <math.h>
+#include <algorithm>
+#include <jellyfish/bloom_common.hpp>
+#include <jellyfish/mapped_file.hpp>
+#include <jellyfish/allocators_mmap.hpp>
+#include <jellyfish/atomic_cxx11.hpp>
+#include <jellyfish/atomic_field.hpp>
+#include <jellyfish/err.hpp>
+
+namespace jellyfish {
+/* Counting cuckoo filter. The array is split in buckets of 32 slots
+   of 16 bits (one cache line). A slot holds a 14 bits fingerprint of a
+   key and a saturating count of 1 to 3 (0 is an empty slot). A key
+   has two candidate buckets: the first is given by the first hash,
+   the second by the fingerprint and the first bucket (partial key
+   cuckoo hashing), hence the two buckets of a slot are known without
+   the key and two filters of the same size and hash functions can be
+   merged. A lookup costs at most two cache misses.
+
+   A new key goes in the least loaded of its two buckets, no entry is
+   ever moved. With buckets this large, a load of 85% is reached with
+   a negligible probability of overflowing both buckets. Then the
+   false positive rate is about 2 * 32 * load / 2^14, i.e. 0.33%. A
+   lower rate is obtained by lowering the load.
+
+   The usual sizing of a cuckoo filter, a load of 95% and a
+   fingerprint of log2(2 * bucket_slots / fp) bits, does not apply:
+   the fingerprint is fixed by the 16 bits slots, and without moving
+   entries the buckets overflow past a load of about 90%. A rate below
+   max_load_fpr() costs memory in inverse proportion: 0.1% needs a
+   load of 26%, i.e. 62 bits per key instead of 19.
+
+   It is thread safe and lock free. Slots are filled in order and
+   never emptied, so a scan of a bucket stops at the first empty
+   slot. Two threads inserting the same new key at the same time may
+   both create a slot. The count of a key is the sum of its slots,
+   hence it is still correct.
+ */
+template<typename Key, typename HashPair = hash_pair<Key>, typename atomic_t = ::atomic::standard>
+class cuckoo_filter_base :
+    public bloom_base<Key, cuckoo_filter_base<Key, HashPair, atomic_t>, HashPair> {
+  typedef bloom_base<Key, cuckoo_filter_base<Key, HashPair, atomic_t>, HashPair> super;
+
+public:
+  typedef uint16_t slot_type;
+  static const size_t       bucket_slots = 32;
+  static const size_t       bucket_bytes = bucket_slots * sizeof(slot_type);
+  static const unsigned int fp_bits      = 14;
+  static const unsigned int max_value    = 3;
+  static const double       max_load;
+
+private:
+  atomic_t               atomic_;
+  const jflib::divisor64 buckets_;
+  size_t                 overflows_;
+
+protected:
+  static size_t nb_buckets__(size_t m) {
+    return std::max((size_t)1, m / bucket_slots + (m % bucket_slots != 0));
+  }
+  static size_t nb_bytes__(size_t m) {
+    return nb_buckets__(m) * bucket_bytes;
+  }
+  // Number of slots, rounded up to a whole number of buckets
+  static size_t round_m__(size_t m) {
+    return nb_buckets__(m) * bucket_slots;
+  }
+
+  static slot_type fingerprint(const uint64_t* hashes) {
+    const slot_type fp = hashes[1] >> (64 - fp_bits);
+    return fp ? fp : 1;
+  }
+  static slot_type slot_fingerprint(slot_type v) { return v >> 2; }
+  static unsigned int value(slot_type v) { return v & max_value; }
+
+  slot_type* bucket(size_t b) const {
+    return (slot_type*)super::data_ + b * bucket_slots;
+  }
+  // The other bucket of a fingerprint in bucket b. alt(alt(b)) == b.
+  size_t alt_bucket(size_t b, slot_type fp) const {
+    const size_t r = buckets_.remainder(fp * 0xc6a4a7935bd1e995ULL);
+    return r >= b ? r - b : r + buckets_.d() - b;
+  }
+
+  struct scan_result {
+    unsigned int value;    // Sum of the counts of the fingerprint
+    slot_type*   inc;      // A slot of the fingerprint which is not saturated
+    slot_type    inc_v;    // and its value
+    size_t       load[2];  // Number of used slots in each bucket
+  };
+
+  // Scan the nb buckets (1 or 2) for a fingerprint
+  void scan(slot_type* const buckets[2], int nb, slot_type fp, scan_result& res) const {
+    res.value   = 0;
+    res.inc     = 0;
+    res.load[1] = bucket_slots;
+    for(int i = 0; i < nb; ++i) {
+      size_t j = 0;
+      for( ; j < bucket_slots; ++j) {
+        const slot_type v = jflib::a_load(buckets[i] + j);
+        if(!v) break;
+        if(slot_fingerprint(v) != fp) continue;
+        res.value += value(v);
+        if(!res.inc && value(v) < max_value) {
+          res.inc   = buckets[i] + j;
+          res.inc_v = v;
+        }
+      }
+      res.load[i] = j;
+    }
+  }
+
+  // Add count to the fingerprint fp in bucket b or its alternate
+  // bucket. Returns the previous value.
+  unsigned int add__(size_t b, slot_type fp, unsigned int count) {
+    slot_type* const buckets[2] = { bucket(b), bucket(alt_bucket(b, fp)) };
+    const int        nb         = buckets[0] == buckets[1] ? 1 : 2;
+    scan_result      sr;
+
+    while(true) {
+      scan(buckets, nb, fp, sr);
+      if(sr.value >= max_value)
+        return max_value;
+      if(sr.inc) {
+        const slot_type nv = (fp << 2) | std::min(max_value, value(sr.inc_v) + count);
+        if(atomic_.cas(sr.inc, sr.inc_v, nv) == sr.inc_v)
+          return sr.value;
+        continue;
+      }
+      const int i = sr.load[0] <= sr.load[1] ? 0 : 1;
+      if(sr.load[i] >= bucket_slots) {
+        atomic_.fetch_add_relaxed(&overflows_, (size_t)1);
+        return 0;
+      }
+      const slot_type nv = (fp << 2) | std::min(max_value, count);
+      if(atomic_.cas(buckets[i] + sr.load[i], (slot_type)0, nv) == 0)
+        return 0;
+    }
+  }
+
+public:
+  cuckoo_filter_base(size_t m, unsigned long k, unsigned char* ptr, const HashPair& fns = HashPair()) :
+    super(round_m__(m), k, ptr, fns),
+    buckets_(nb_buckets__(m)),
+    overflows_(0)
+  { }
+  cuckoo_filter_base(cuckoo_filter_base&& rhs) :
+    super(std::move(rhs)),
+    buckets_(rhs.buckets_),
+    overflows_(rhs.overflows_)
+  { }
+  size_t nb_bytes() const {
+    return nb_bytes__(super::d_.d());
+  }
+  size_t nb_buckets() const { return buckets_.d(); }
+  // Largest count returned by check
+  unsigned int max_count() const { return max_value; }
+  // Number of keys which could not be inserted because both their
+  // buckets were full.
+  size_t overflows() const { return overflows_; }
+
+  // Number of hashes per key. The parameter k of the constructors is
+  // always 2: one hash selects the bucket, the other gives the
+  // fingerprint.
+  static unsigned long opt_k(const double) { return 2; }
+
+  // False positive rate at max_load, the lowest memory per key. A
+  // lookup compares the fingerprint to the slots of two buckets.
+  static double max_load_fpr() { return 2 * bucket_slots * max_load / (1 << fp_bits); }
+
+  // Number of slots for n keys with a false positive rate of fp. The
+  // load is lowered from max_load until the rate is reached.
+  static size_t opt_m(const double fp, const size_t n) {
+    const double load = std::min(max_load, fp * (1 << fp_bits) / (2 * bucket_slots));
+    return round_m__((size_t)ceil(n / load));
+  }
+
+  // Prefetch the buckets of a key with given hashes
+  void prefetch__(const uint64_t* hashes, bool write) const {
+    const size_t b = buckets_.remainder(hashes[0]);
+    const slot_type* const b1 = bucket(b);
+    const slot_type* const b2 = bucket(alt_bucket(b, fingerprint(hashes)));
+    if(write) {
+      __builtin_prefetch(b1, 1, 0);
+      __builtin_prefetch(b2, 1, 0);
+    } else {
+      __builtin_prefetch(b1, 0, 0);
+      __builtin_prefetch(b2, 0, 0);
+    }
+  }
+
+  // Insert key with given hashes. Returns the previous value.
+  unsigned int insert__(const uint64_t* hashes) {
+    return add__(buckets_.remainder(hashes[0]), fingerprint(hashes), 1);
+  }
+
+  unsigned int check__(const uint64_t* hashes) const {
+    const size_t     b           = buckets_.remainder(hashes[0]);
+    const slot_type  fp          = fingerprint(hashes);
+    slot_type* const buckets[2]  = { bucket(b), bucket(alt_bucket(b, fp)) };
+    scan_result      sr;
+    scan(buckets, buckets[0] == buckets[1] ? 1 : 2, fp, sr);
+    return std::min(max_value, sr.value);
+  }
+
+  // Add the counts of rhs, which must have the same size and hash
+  // functions. Returns false if some fingerprints did not fit.
+  bool merge(const cuckoo_filter_base& rhs) {
+    if(super::d_.d() != rhs.d_.d())
+      return false;
+    const size_t prev = overflows_;
+    for(size_t b = 0; b < buckets_.d(); ++b) {
+      const slot_type* const bk = rhs.bucket(b);
+      for(size_t j = 0; j < bucket_slots && bk[j]; ++j)
+        add__(b, slot_fingerprint(bk[j]), value(bk[j]));
+    }
+    return overflows_ == prev;
+  }
+};
+template<typename Key, typename HashPair, typename atomic_t>
+const size_t cuckoo_filter_base<Key, HashPair, atomic_t>::bucket_slots;
+template<typename Key, typename HashPair, typename atomic_t>
+const size_t cuckoo_filter_base<Key, HashPair, atomic_t>::bucket_bytes;
+template<typename Key, typename HashPair, typename atomic_t>
+const unsigned int cuckoo_filter_base<Key, HashPair, atomic_t>::fp_bits;
+template<typename Key, typename HashPair, typename atomic_t>
+const unsigned int cuckoo_filter_base<Key, HashPair, atomic_t>::max_value;
+template<typename Key, typename HashPair, typename atomic_t>
+const double cuckoo_filter_base<Key, HashPair, atomic_t>::max_load = 0.85;
+
+template<typename Key, typename HashPair = hash_pair<Key>, typename atomic_t = ::atomic::standard,
+         typename mem_block_t = allocators::mmap>
+class cuckoo_filter :
+    protected mem_block_t,
+    public cuckoo_filter_base<Key, HashPair, atomic_t>
+{
+  typedef cuckoo_filter_base<Key, HashPair, atomic_t> super;
+
+public:
+  typedef typename super::key_type key_type;
+
+  /// Memory used for n elements with a false positive rate of fp
+  static size_t mem(const double fp, const size_t n) {
+    return super::nb_bytes__(super::opt_m(fp, n));
+  }
+
+  cuckoo_filter(const double fp, const size_t n, const HashPair& fns = HashPair()) :
+    mem_block_t(super::nb_bytes__(super::opt_m(fp, n))),
+    super(super::opt_m(fp, n), super::opt_k(fp), (unsigned char*)mem_block_t::get_ptr(), fns)
+  {
+    if(!mem_block_t::get_ptr())
+      throw std::runtime_error(err::msg() << "Failed to allocate " << super::nb_bytes__(super::opt_m(fp, n))
+                               << " bytes of memory for cuckoo_filter");
+  }
+
+  cuckoo_filter(size_t m, unsigned long k, const HashPair& fns = HashPair()) :
+    mem_block_t(super::nb_bytes__(m)),
+    super(m, k, (unsigned char*)mem_block_t::get_ptr(), fns)
+  {
+    if(!mem_block_t::get_ptr())
+      throw std::runtime_error(err::msg() << "Failed to allocate " << super::nb_bytes__(m) << " bytes of memory for cuckoo_filter");
+  }
+
+  cuckoo_filter(size_t m, unsigned long k, std::istream& is, const HashPair& fns = HashPair()) :
+    mem_block_t(super::nb_bytes__(m)),
+    super(m, k, (unsigned char*)mem_block_t::get_ptr(), fns)
+  {
+    if(!mem_block_t::get_ptr())
+      throw std::runtime_error(err::msg() << "Failed to allocate " << super::nb_bytes__(m) << " bytes of memory for cuckoo_filter");
+
+    is.read((char*)mem_block_t::get_ptr(), super::nb_bytes());
+  }
+
+  cuckoo_filter(const cuckoo_filter& rhs) = delete;
+  cuckoo_filter(cuckoo_filter&& rhs) :
+    mem_block_t(std::move(rhs)),
+    super(std::move(rhs))
+  { }
+};
+
+template<typename Key, typename HashPair = hash_pair<Key>, typename atomic_t = ::atomic::standard>
+class cuckoo_filter_file :
+    protected mapped_file,
+    public cuckoo_filter_base<Key, HashPair, atomic_t>
+{
+  typedef cuckoo_filter_base<Key, HashPair, atomic_t> super;
+public:
+  typedef typename super::key_type key_type;
+
+  cuckoo_filter_file(size_t m, unsigned long k, const char* path, const HashPair& fns = HashPair(), off_t offset = 0,
+                     int map_flags = 0) :
+    mapped_file(path, map_flags),
+    super(m, k, (unsigned char*)mapped_file::base() + offset, fns)
+  {
+    if(mapped_file::length() < offset + super::nb_bytes())
+      throw std::runtime_error(err::msg() << "File '" << path << "' is truncated");
+  }
+
+  /// The mapped file, e.g. to give advice on its use
+  const mapped_file& file() const { return *this; }
+
+  cuckoo_filter_file(const cuckoo_filter_file& rhs) = delete;
+  cuckoo_filter_file(cuckoo_filter_file&& rhs) :
+    mapped_file(std::move(rhs)),
+    super(std::move(rhs))
+  { }
+};
+
+} // namespace jellyfish {
+
+#endif // __JELLYFISH_CUCKOO_FILTER_HPP__
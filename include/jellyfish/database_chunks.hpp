@@ -0,0 +1,128 @@
+/*  This file is part of Jellyfish.
+
+    Jellyfish is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Jellyfish is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Jellyfish.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __JELLYFISH_DATABASE_CHUNKS_HPP__
+#define __JELLYFISH_DATABASE_CHUNKS_HPP__
+
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <vector>
+#include <algorithm>
+
+#include <jellyfish/binary_dumper.hpp>
+
+/// Split a sorted database in memory (usually a mapped file) into
+/// chunks which can be read independently, e.g. by different
+/// threads. A chunk is read with a reader which behaves like
+/// binary_reader and text_reader (has next(), key() and val()
+/// methods). Reading the chunks in order reads the whole database in
+/// order.
+namespace jellyfish {
+template<typename Key, typename Val>
+class binary_chunks {
+  const binary_records<Key, Val> records_;
+  const size_t                   nb_chunks_;
+
+public:
+  class reader {
+    const binary_records<Key, Val>& records_;
+    size_t                          id_, end_;
+    Key                             key_;
+    Val                             val_;
+
+  public:
+    reader(const binary_records<Key, Val>& records, size_t start, size_t end) :
+      records_(records), id_(start), end_(end), val_(0)
+    { }
+
+    const Key& key() const { return key_; }
+    const Val& val() const { return val_; }
+
+    bool next() {
+      if(id_ >= end_) return false;
+      records_.key_at(id_, key_);
+      val_ = records_.val_at(id_);
+      ++id_;
+      return true;
+    }
+  };
+
+  // key_len passed in bits, val_len in bytes (as in binary_query_base).
+  binary_chunks(const char* data, unsigned int key_len, unsigned int val_len, size_t length,
+                size_t records_per_chunk) :
+    records_(data, key_len, val_len, length),
+    nb_chunks_(std::max((size_t)1, (records_.size() + records_per_chunk - 1) / records_per_chunk))
+  { }
+
+  size_t size() const { return nb_chunks_; }
+  reader chunk(size_t i) const {
+    return reader(records_, (records_.size() * i) / nb_chunks_, (records_.size() * (i + 1)) / nb_chunks_);
+  }
+};
+
+template<typename Key, typename Val>
+class text_chunks {
+  std::vector<const char*> bounds_;
+
+public:
+  class reader {
+    const char*       ptr_;
+    const char* const end_;
+    Key               key_;
+    Val               val_;
+
+  public:
+    reader(const char* start, const char* end) : ptr_(start), end_(end), val_(0) { }
+
+    const Key& key() const { return key_; }
+    const Val& val() const { return val_; }
+
+    // A line is 'key count'. A malformed line ends the chunk. The
+    // count is parsed by hand, not with strtoull: the last line of a
+    // mapped dump may have no newline and end at the end of the
+    // mapping.
+    bool next() {
+      while(ptr_ < end_ && isspace(*ptr_)) ++ptr_;
+      if(ptr_ + Key::k() >= end_ || !key_.from_chars(ptr_))
+        return false;
+      ptr_ += Key::k();
+      while(ptr_ < end_ && (*ptr_ == ' ' || *ptr_ == '\t')) ++ptr_;
+      const char* const val_start = ptr_;
+      val_ = 0;
+      for( ; ptr_ < end_ && *ptr_ >= '0' && *ptr_ <= '9'; ++ptr_)
+        val_ = 10 * val_ + (*ptr_ - '0');
+      return ptr_ != val_start;
+    }
+  };
+
+  text_chunks(const char* data, size_t length, size_t bytes_per_chunk) {
+    const char* const end = data + length;
+    bounds_.push_back(data);
+    for(const char* cut = data + bytes_per_chunk; cut < end; cut = bounds_.back() + bytes_per_chunk) {
+      const char* nl = (const char*)memchr(cut, '\n', end - cut);
+      if(!nl || nl + 1 >= end) break;
+      bounds_.push_back(nl + 1);
+    }
+    bounds_.push_back(end);
+  }
+
+  size_t size() const { return bounds_.size() - 1; }
+  reader chunk(size_t i) const { return reader(bounds_[i], bounds_[i + 1]); }
+};
+} // namespace jellyfish
+
+#endif /* __JELLYFISH_DATABASE_CHUNKS_HPP__ */
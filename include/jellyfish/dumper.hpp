@@ -24,6 +24,8 @@
 #include <string>
 #include <jellyfish/err.hpp>
 #include <jellyfish/time.hpp>
+#include <jellyfish/progress.hpp>
+#include <jellyfish/trace.hpp>
 
 /**
  * A dumper is responsible to dump the hash array to permanent storage
@@ -33,6 +35,7 @@ namespace jellyfish {
 template<typename storage_t>
 class dumper_t {
   Time                     writing_time_;
+  std::vector<Time>        dump_times_;
   int                      index_;
   bool                     one_file_;
   std::vector<std::string> file_names_;
@@ -74,10 +77,14 @@ public:
   {}
 
   void dump(storage_t* ary) {
+    trace::span span("dump");
     Time start;
     _dump(ary);
     Time end;
     writing_time_ += end - start;
+    dump_times_.push_back(end - start);
+    progress::add(progress::DUMPS, 1);
+    progress::set(progress::DUMPED_KEYS, progress::get(progress::NEW_KEYS));
   }
 
   bool one_file() const { return one_file_; }
@@ -89,6 +96,8 @@ public:
   uint64_t max() const { return max_; }
   void max(uint64_t m) { max_ = m; }
   Time get_writing_time() const { return writing_time_; }
+  /// Duration of each dump, in order
+  const std::vector<Time>& dump_times() const { return dump_times_; }
   int nb_files() const { return index_; }
   std::vector<std::string> file_names() { return file_names_; }
   std::vector<const char*> file_names_cstr() {
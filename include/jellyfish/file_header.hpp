@@ -18,8 +18,11 @@
 #define __JELLYFISH_FILE_HEADER_HPP__
 
 #include <string>
+#include <vector>
+#include <stdexcept>
 #include <jellyfish/generic_file_header.hpp>
 #include <jellyfish/rectangular_binary_matrix.hpp>
+#include <jellyfish/invertible_hash.hpp>
 
 namespace jellyfish {
 /// A header with jellyfish hash specific entries: size, matrix, etc.
@@ -35,7 +38,7 @@ public:
     this->size(ary.size());
     this->key_len(ary.key_len());
     this->val_len(ary.val_len());
-    this->matrix(ary.matrix());
+    this->hash_function(ary.hash_function());
     this->max_reprobe(ary.max_reprobe());
     this->set_reprobes(ary.reprobes());
   }
@@ -63,6 +66,32 @@ public:
     }
   }
 
+  /// Hash function of a hash array. A matrix (the "matrix1" entry),
+  /// unless the "hash" entry gives another family.
+  invertible_hash hash_function() const {
+    if(!root_.isMember("hash"))
+      return invertible_hash(matrix());
+    const std::string family = root_["hash"]["family"].asString();
+    if(family != "xorshift_mul")
+      throw std::runtime_error(err::msg() << "Unknown hash function family '" << family << "'");
+    return invertible_hash::xorshift_mul(root_["hash"]["r"].asUInt(), root_["hash"]["c"].asUInt(),
+                                         root_["hash"]["seed"].asUInt64());
+  }
+
+  void hash_function(const invertible_hash& h) {
+    if(h.family() == invertible_hash::MATRIX) {
+      root_.removeMember("hash");
+      matrix(h.matrix());
+      return;
+    }
+    root_.removeMember("matrix1");
+    root_["hash"].clear();
+    root_["hash"]["family"] = "xorshift_mul";
+    root_["hash"]["r"]      = h.r();
+    root_["hash"]["c"]      = h.c();
+    root_["hash"]["seed"]   = (Json::UInt64)h.seed();
+  }
+
   size_t size() const { return root_["size"].asLargestUInt(); }
   void size(size_t s) { root_["size"] = (Json::UInt64)s; }
 
@@ -104,6 +133,28 @@ public:
   unsigned int counter_len() const { return root_["counter_len"].asUInt(); }
   void counter_len(unsigned int l) { root_["counter_len"] = (Json::UInt)l; }
 
+  /// Length in bits of the counter field in compact format, or of
+  /// the cells of a count-min sketch
+  unsigned int counter_bits() const { return root_["counter_bits"].asUInt(); }
+  void counter_bits(unsigned int l) { root_["counter_bits"] = (Json::UInt)l; }
+
+  /// Length in bits of the key fingerprints in compact format (0 if none)
+  unsigned int fingerprint_len() const { return root_.get("fingerprint_len", 0).asUInt(); }
+  void fingerprint_len(unsigned int l) { root_["fingerprint_len"] = (Json::UInt)l; }
+
+  /// Sizes in bits of the levels of the minimal perfect hash function
+  std::vector<uint64_t> mphf_levels() const {
+    std::vector<uint64_t> res;
+    for(unsigned int i = 0; i < root_["mphf_levels"].size(); ++i)
+      res.push_back(root_["mphf_levels"][i].asUInt64());
+    return res;
+  }
+  void mphf_levels(const std::vector<uint64_t>& levels) {
+    root_["mphf_levels"].clear();
+    for(auto it = levels.cbegin(); it != levels.cend(); ++it)
+      root_["mphf_levels"].append((Json::UInt64)*it);
+  }
+
   std::string format() const { return root_["format"].asString(); }
   void format(const std::string& s) { root_["format"] = s; }
 };
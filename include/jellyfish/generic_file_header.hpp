@@ -162,6 +162,7 @@ public:
   std::string operator[](const std::string& key) const { return root_.get(key, "").asString(); }
   std::string operator[](const char* key) const { return root_.get(key, "").asString(); }
   int alignment() const { return std::max(0, root_.get("alignment", 0).asInt()); }
+  void alignment(int a) { root_["alignment"] = a; }
   size_t offset() const { return offset_; }
 
   std::vector<std::string> cmdline() const {
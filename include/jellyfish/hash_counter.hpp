@@ -18,10 +18,14 @@
 #define __HASH_COUNTER_HPP__
 
 #include <stdexcept>
+#include <limits>
 
 #include <jellyfish/large_hash_array.hpp>
 #include <jellyfish/locks_pthread.hpp>
 #include <jellyfish/dumper.hpp>
+#include <jellyfish/thread_stats.hpp>
+#include <jellyfish/trace.hpp>
+#include <jellyfish/progress.hpp>
 
 /// Cooperative version of the hash_counter. In this implementation,
 /// it is expected that the given number of threads will call the
@@ -31,7 +35,7 @@
 
 namespace jellyfish{ namespace cooperative {
 
-template<typename Key, typename word = uint64_t, typename atomic_t = ::atomic::gcc, typename mem_block_t = ::allocators::mmap>
+template<typename Key, typename word = uint64_t, typename atomic_t = ::atomic::standard, typename mem_block_t = ::allocators::mmap>
 class hash_counter {
 public:
   typedef typename large_hash::array<Key, word, atomic_t, mem_block_t> array;
@@ -46,13 +50,18 @@ public:
   typedef typename array::lazy_iterator                                lazy_iterator;
 
 protected:
-  array*                  ary_;
-  array*                  new_ary_;
-  uint16_t                nb_threads_;
-  locks::pthread::barrier size_barrier_;
-  volatile uint16_t       size_thid_, done_threads_;
-  bool                    do_size_doubling_;
-  dumper_t<array>*        dumper_;
+  array*                       ary_;
+  array*                       new_ary_;
+  uint16_t                     nb_threads_;
+  const uint16_t               reprobe_limit_; // As given: the array caps it by its size
+  locks::pthread::spin_barrier size_barrier_;
+  volatile uint32_t            size_thid_;
+  volatile uint16_t            done_threads_;
+  volatile bool                full_; // A thread waits for the others to handle a full array
+  volatile bool                copy_failed_; // A key did not fit in the doubled array
+  bool                         do_size_doubling_;
+  size_t                       max_size_;
+  dumper_t<array>*             dumper_;
 
 public:
   hash_counter(size_t size, // Size of hash. To be rounded up to a power of 2
@@ -64,12 +73,18 @@ public:
     ary_(new array(size, key_len, val_len, reprobe_limit, reprobes)),
     new_ary_(0),
     nb_threads_(nb_threads),
+    reprobe_limit_(reprobe_limit),
     size_barrier_(nb_threads),
     size_thid_(0),
     done_threads_(0),
+    full_(false),
+    copy_failed_(false),
     do_size_doubling_(true),
+    max_size_(std::numeric_limits<size_t>::max()),
     dumper_(0)
-  { }
+  {
+    progress::set(progress::HASH_SIZE, ary_->size());
+  }
 
   ~hash_counter() {
     delete ary_;
@@ -80,7 +95,7 @@ public:
   size_t size() const { return ary_->size(); }
   uint16_t key_len() const { return ary_->key_len(); }
   uint16_t val_len() const { return ary_->val_len(); }
-  uint16_t nb_threads() const { return nb_threads; }
+  uint16_t nb_threads() const { return nb_threads_; }
   uint16_t reprobe_limit() const { return ary_->max_reprobe(); }
 
 
@@ -88,10 +103,22 @@ public:
   bool do_size_doubling() const { return do_size_doubling_; }
   /// Set whether we attempt to double the size of the hash when full.
   void do_size_doubling(bool v) { do_size_doubling_ = v; }
+  /// Maximum size reached by doubling. When doubling would go beyond
+  /// it, the hash is dumped instead, as if the allocation failed.
+  size_t max_size() const { return max_size_; }
+  void max_size(size_t s) { max_size_ = s; }
 
   /// Set dumper responsible for cleaning out the array.
   void dumper(dumper_t<array> *d) { dumper_ = d; }
 
+  /// Family of the hash function of the array, kept when the size
+  /// doubles. XORSHIFT_MUL is faster than the default MATRIX, but
+  /// only for keys of at most 64 bits. Set it before adding keys.
+  invertible_hash::family_type hash_family() const { return ary_->hash_function().family(); }
+  void hash_family(invertible_hash::family_type f) {
+    ary_->hash_function(invertible_hash::random(f, ary_->lsize(), ary_->key_len()));
+  }
+
   /// Add `v` to the entry `k`. It returns in `is_new` true if the
   /// entry `k` did not exist in the hash. In `id` is returned the
   /// final position of `k` in the hash array.
@@ -172,15 +199,49 @@ public:
   /// Signify that thread is done and wait for all threads to be done.
   void done() {
     atomic_t::fetch_add(&done_threads_, (uint16_t)1);
-    while(!handle_full_ary()) ;
+    while(!handle_full_ary(false)) ;
+  }
+
+  /// Take part in handling a full array (size doubling or dump), if
+  /// another thread waits for it. A thread which has no key to add
+  /// for a while, but is not done, must call this method regularly,
+  /// or the other threads would wait on it.
+  void sync() {
+    if(full_)
+      handle_full_ary(false);
   }
 
 protected:
+  static const uint32_t copy_slices_per_thread = 4;
+
+  // Wait on the size barrier. Return true for the serial thread.
+  bool barrier_wait() {
+    thread_stats::incr<&thread_stats::barrier_waits>();
+    thread_stats::timer<&thread_stats::barrier_ns> timer;
+    bool parked = false;
+    const bool serial_thread = size_barrier_.wait(&parked);
+    if(parked)
+      thread_stats::incr<&thread_stats::barrier_parks>();
+    return serial_thread;
+  }
+
+  // Wait on the size barrier after doing parts of the work with
+  // help(). The time spent helping is not time waiting.
+  template<typename Help>
+  bool barrier_wait(Help help) {
+    while(help()) ;
+    return barrier_wait();
+  }
+
   // Double the size of the hash and return false. Unless all the
   // thread have reported they are done, in which case do nothing and
-  // return true.
-  bool handle_full_ary() {
-    bool serial_thread = size_barrier_.wait();
+  // return true. full is false if the calling thread did not find the
+  // array full.
+  bool handle_full_ary(bool full = true) {
+    trace::span span("handle_full_ary");
+    if(full)
+      full_ = true;
+    bool serial_thread = barrier_wait();
     if(done_threads_ >= nb_threads_) // All done?
       return true;
 
@@ -189,10 +250,12 @@ protected:
       success = success || double_size(serial_thread);
 
     if(!success && dumper_) {
-      if(serial_thread)
+      if(serial_thread) {
         dumper_->dump(ary_);
+        full_ = false;
+      }
       success = true;
-      size_barrier_.wait();
+      barrier_wait();
     }
 
     if(!success)
@@ -202,40 +265,60 @@ protected:
   }
 
   bool double_size(bool serial_thread) {
-    if(serial_thread) {// Allocate new array for size doubling
+    trace::span span("double_size");
+    if(serial_thread && ary_->size() > max_size_ / 2) {
+      new_ary_ = 0;
+    } else if(serial_thread) {// Allocate new array for size doubling
       try {
-        new_ary_   = new array(ary_->size() * 2, ary_->key_len(), ary_->val_len(),
-                               ary_->max_reprobe(), ary_->reprobes());
+        new_ary_   = new array(ary_->size() * 2, ary_->key_len(), ary_->val_len(), reprobe_limit_,
+                               invertible_hash::random(hash_family(), ary_->lsize() + 1, ary_->key_len()),
+                               ary_->reprobes());
        } catch(typename array::ErrorAllocation e) {
         new_ary_ = 0;
       }
     }
-    size_thid_ = 0;
+    size_thid_   = 0;
+    copy_failed_ = false;
 
-    size_barrier_.wait();
+    barrier_wait();
     array* my_ary = *(array* volatile*)&new_ary_;
     if(!my_ary) // Allocation failed
       return false;
 
-    // Copy data from old to new
-    uint16_t       id = atomic_t::fetch_add(&size_thid_, (uint16_t)1);
-    // Why doesn't the following work? Seems like a bug to
-    // me. Equivalent call works in test_large_hash_array. Or am I
-    // missing something?
-    // eager_iterator it = ary_->iterator_slice<eager_iterator>(id, nb_threads_);
-    eager_iterator it = ary_->eager_slice(id, nb_threads_);
-    while(it.next())
-      my_ary->add(it.key(), it.val());
+    // Copy data from old to new. The array is split in more slices
+    // than threads: the threads arriving first at the barrier copy
+    // more slices.
+    const uint32_t nb_slices = copy_slices_per_thread * nb_threads_;
+    barrier_wait([&]() -> bool {
+        const uint32_t id = atomic_t::fetch_add(&size_thid_, (uint32_t)1);
+        if(id >= nb_slices)
+          return false;
+        eager_iterator it = ary_->eager_slice(id, nb_slices);
+        while(it.next() && !copy_failed_)
+          if(!my_ary->add(it.key(), it.val()))
+            copy_failed_ = true;
+        return true;
+      });
 
-    size_barrier_.wait();
+    if(copy_failed_) { // As if the allocation failed. The old array is unchanged
+      if(serial_thread) {
+        delete new_ary_;
+        new_ary_ = 0;
+      }
+      barrier_wait();
+      return false;
+    }
 
     if(serial_thread) { // Set new ary to be current and free old
       delete ary_;
       ary_ = new_ary_;
+      progress::set(progress::HASH_SIZE, ary_->size());
+      progress::add(progress::DOUBLINGS, 1);
+      full_ = false;
     }
 
     // Done. Last sync point
-    size_barrier_.wait();
+    barrier_wait();
     return true;
   }
 };
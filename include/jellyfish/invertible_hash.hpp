@@ -0,0 +1,180 @@
+/*  This file is part of Jellyfish.
+
+    Jellyfish is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Jellyfish is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Jellyfish.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __JELLYFISH_INVERTIBLE_HASH_HPP__
+#define __JELLYFISH_INVERTIBLE_HASH_HPP__
+
+#include <stdint.h>
+#include <stdexcept>
+#include <algorithm>
+#include <memory>
+#include <jellyfish/misc.hpp>
+#include <jellyfish/err.hpp>
+#include <jellyfish/rectangular_binary_matrix.hpp>
+
+namespace jellyfish {
+/// Hash function of the keys of a large hash array. The hash of a key
+/// of c bits has r bits, where r is the log of the size of the
+/// array. The array stores only the c - r high bits of a key: the low
+/// r bits are recovered from the hash by the pseudo-inverse.
+///
+/// There are two families of hash functions:
+///
+/// - MATRIX: the product by a random pseudo-invertible binary matrix
+///   r x c. For any key length.
+///
+/// - XORSHIFT_MUL: for keys of at most 64 bits (k <= 32). The low r
+///   bits of the key, xored with a hash of the high bits, go through
+///   a xorshift-multiply bijection on r bits. A handful of
+///   multiplications and shifts instead of one operation per column
+///   of the matrix.
+///
+/// In both cases, times() on the pseudo-inverse of a hash, given a
+/// vector with the hash in the r low bits and the high bits of the
+/// key above, returns the r low bits of the key.
+class invertible_hash {
+public:
+  enum family_type { MATRIX, XORSHIFT_MUL };
+
+  invertible_hash(const RectangularBinaryMatrix& m) :
+    family_(MATRIX), inverse_(false), seed_(0), r_(m.r()), c_(m.c()),
+    matrix_(std::make_shared<const RectangularBinaryMatrix>(m))
+  { init_masks(); }
+  invertible_hash(RectangularBinaryMatrix&& m) :
+    family_(MATRIX), inverse_(false), seed_(0), r_(m.r()), c_(m.c()),
+    matrix_(std::make_shared<const RectangularBinaryMatrix>(std::move(m)))
+  { init_masks(); }
+
+  /// Hash of the XORSHIFT_MUL family from r bits to c bits, given its
+  /// seed. 0 < r <= c <= 64, as for a matrix.
+  static invertible_hash xorshift_mul(unsigned int r, unsigned int c, uint64_t seed) {
+    if(c > 64)
+      throw std::out_of_range(err::msg() << "Key length " << c << " too large for the xorshift-multiply hash (max 64 bits)");
+    if(r == 0 || r > c)
+      throw std::out_of_range(err::msg() << "Invalid xorshift-multiply hash size " << r << "x" << c);
+    return invertible_hash(XORSHIFT_MUL, false, seed, r, c);
+  }
+
+  /// A random hash of the family from r bits to c bits
+  static invertible_hash random(family_type family, unsigned int r, unsigned int c) {
+    if(family == XORSHIFT_MUL)
+      return xorshift_mul(r, c, random_bits());
+    RectangularBinaryMatrix m(r, c);
+    m.randomize_pseudo_inverse();
+    return invertible_hash(std::move(m));
+  }
+
+  family_type family() const { return family_; }
+  unsigned int r() const { return r_; }
+  unsigned int c() const { return c_; }
+  /// Seed of a XORSHIFT_MUL hash
+  uint64_t seed() const { return seed_; }
+  /// Matrix of a MATRIX hash. Raise std::logic_error for the other
+  /// families, which have none.
+  const RectangularBinaryMatrix& matrix() const {
+    if(family_ != MATRIX)
+      throw std::logic_error("Hash function is not a matrix");
+    return *matrix_;
+  }
+
+  bool operator==(const invertible_hash& rhs) const {
+    if(family_ != rhs.family_ || r_ != rhs.r_ || c_ != rhs.c_)
+      return false;
+    if(family_ == MATRIX)
+      return *matrix_ == *rhs.matrix_;
+    return inverse_ == rhs.inverse_ && seed_ == rhs.seed_;
+  }
+  bool operator!=(const invertible_hash& rhs) const { return !(*this == rhs); }
+
+  /// Hash of the vector v. Type T supports the operator v[i] to
+  /// return the i-th 64 bit word of v.
+  template<typename T>
+  inline uint64_t times(const T& v) const {
+    if(family_ == MATRIX)
+      return matrix_->times(v);
+    return inverse_ ? xorshift_inverse(v[0] & cmask_) : xorshift(v[0] & cmask_);
+  }
+
+  /// The pseudo-inverse of this hash. Raise std::domain_error if the
+  /// matrix is singular.
+  invertible_hash pseudo_inverse() const {
+    if(family_ == MATRIX)
+      return invertible_hash(matrix_->pseudo_inverse());
+    return invertible_hash(family_, !inverse_, seed_, r_, c_);
+  }
+
+private:
+  // Multipliers of the bijection (from the finalizer of MurmurHash3)
+  // and their inverses modulo 2^64.
+  static const uint64_t mul1     = 0xff51afd7ed558ccdULL;
+  static const uint64_t mul2     = 0xc4ceb9fe1a85ec53ULL;
+  static const uint64_t mul1_inv = 0x4f74430c22a54005ULL;
+  static const uint64_t mul2_inv = 0x9cb4b2f8129337dbULL;
+
+  family_type  family_;
+  bool         inverse_;
+  uint64_t     seed_;
+  unsigned int r_, c_;
+  // Matrix of the MATRIX family, shared by the copies. Null otherwise.
+  std::shared_ptr<const RectangularBinaryMatrix> matrix_;
+  uint64_t     rmask_, cmask_;
+  unsigned int shift_; // At least r / 2 + 1: x ^= x >> shift_ is its own inverse on r bits
+
+  invertible_hash(family_type family, bool inverse, uint64_t seed, unsigned int r, unsigned int c) :
+    family_(family), inverse_(inverse), seed_(seed), r_(r), c_(c)
+  { init_masks(); }
+
+  // The masks are used only by the XORSHIFT_MUL family, where
+  // 0 < r <= c <= 64. The matrix constructor enforces 0 < r <= 64.
+  void init_masks() {
+    rmask_ = ~(uint64_t)0 >> (64 - r_);
+    cmask_ = ~(uint64_t)0 >> (64 - std::min(c_, 64u));
+    shift_ = r_ / 2 + 1;
+  }
+
+  // Hash of the c - r high bits of the key, to mix into the low bits
+  uint64_t high_hash(uint64_t x) const {
+    x   = (x >> (r_ - 1)) >> 1; // 0 < r <= 64
+    x  ^= seed_;
+    x  ^= x >> 33;
+    x  *= mul1;
+    x  ^= x >> 33;
+    x  *= mul2;
+    x  ^= x >> 33;
+    return x & rmask_;
+  }
+
+  uint64_t xorshift(uint64_t key) const {
+    uint64_t x = (key & rmask_) ^ high_hash(key);
+    x  = (x * mul1) & rmask_;
+    x ^= x >> shift_;
+    x  = (x * mul2) & rmask_;
+    x ^= x >> shift_;
+    return x;
+  }
+
+  uint64_t xorshift_inverse(uint64_t v) const {
+    uint64_t x = v & rmask_;
+    x ^= x >> shift_;
+    x  = (x * mul2_inv) & rmask_;
+    x ^= x >> shift_;
+    x  = (x * mul1_inv) & rmask_;
+    return x ^ high_hash(v);
+  }
+};
+} // namespace jellyfish
+
+#endif /* __JELLYFISH_INVERTIBLE_HASH_HPP__ */
@@ -22,6 +22,8 @@
 #include <jellyfish/hash_counter.hpp>
 #include <jellyfish/text_dumper.hpp>
 #include <jellyfish/binary_dumper.hpp>
+#include <jellyfish/binary_hash_query.hpp>
+#include <jellyfish/compact_database.hpp>
 
 typedef jellyfish::cooperative::hash_counter<jellyfish::mer_dna> mer_hash;
 typedef mer_hash::array mer_array;
@@ -30,6 +32,10 @@ typedef jellyfish::text_reader<jellyfish::mer_dna, uint64_t> text_reader;
 typedef jellyfish::binary_dumper<mer_array> binary_dumper;
 typedef jellyfish::binary_reader<jellyfish::mer_dna, uint64_t> binary_reader;
 typedef jellyfish::binary_query_base<jellyfish::mer_dna, uint64_t> binary_query;
+typedef jellyfish::binary_hash_query<jellyfish::mer_dna, uint64_t> binary_hash_query;
+typedef jellyfish::compact::query<jellyfish::mer_dna, uint64_t> compact_query;
+typedef jellyfish::compact::builder<jellyfish::mer_dna, uint64_t> compact_builder;
+typedef jellyfish::binary_records<jellyfish::mer_dna, uint64_t> binary_records;
 typedef jellyfish::binary_writer<jellyfish::mer_dna, uint64_t> binary_writer;
 typedef jellyfish::text_writer<jellyfish::mer_dna, uint64_t> text_writer;
 
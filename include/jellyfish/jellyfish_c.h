@@ -0,0 +1,109 @@
+/*  This file is part of Jellyfish.
+
+    Jellyfish is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Jellyfish is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Jellyfish.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __JELLYFISH_JELLYFISH_C_H__
+#define __JELLYFISH_JELLYFISH_C_H__
+
+/* C interface to the counting and query engines of the library, for
+ * programs in C or in languages with a C foreign function
+ * interface. Unlike the C++ templates, it does not depend on the
+ * compiler nor on the template parameters used to build the library.
+ *
+ * The k-mer length is a property of each handle. Handles with
+ * different k-mer lengths can be used at the same time, up to
+ * JELLYFISH_MAX_K_VALUES different lengths in a process. The k-mer
+ * length of the C++ API (jellyfish::mer_dna::k()) is not changed.
+ *
+ * A handle must not be used by more than one thread at a time; the
+ * calls are multi-threaded internally. Functions returning an int
+ * return 0 on success and -1 on error, pointers are NULL on
+ * error. jellyfish_last_error() describes the last error of the
+ * calling thread.
+ *
+ * The sequences are arrays of nb buffers seqs[i] of length lens[i],
+ * not necessarily NUL terminated. A k-mer containing a character
+ * other than ACGT (upper or lower case), be it an N or a newline, is
+ * skipped by the counter, and its count is 0 in a query. The queries return the count of every k-mer
+ * position of every sequence, in order: counts must have
+ * jellyfish_nb_positions(k, seqs, lens, nb) entries.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define JELLYFISH_MAX_K_VALUES 4
+
+typedef struct jellyfish_counter jellyfish_counter;
+typedef struct jellyfish_db      jellyfish_db;
+
+/* Description of the last error in the calling thread */
+const char* jellyfish_last_error(void);
+
+/* Total number of k-mer positions in the sequences */
+size_t jellyfish_nb_positions(unsigned int k, const char* const* seqs, const size_t* lens, size_t nb);
+
+/* Hash counting k-mers of length k, with initial size (number of
+ * k-mers) size, counter_len bits per entry and threads threads. The
+ * hash doubles in size when full. If canonical is not 0, a k-mer and
+ * its reverse complement are counted together. */
+jellyfish_counter* jellyfish_counter_new(unsigned int k, uint64_t size, unsigned int counter_len,
+                                         unsigned int threads, int canonical);
+void jellyfish_counter_free(jellyfish_counter* counter);
+unsigned int jellyfish_counter_k(const jellyfish_counter* counter);
+/* Current size of the hash */
+uint64_t jellyfish_counter_size(const jellyfish_counter* counter);
+
+/* Add 1 for every k-mer of the sequences. Returns the number of
+ * k-mers added, -1 on error. */
+int64_t jellyfish_counter_add(jellyfish_counter* counter, const char* const* seqs, const size_t* lens,
+                              size_t nb);
+
+/* Count of every k-mer of the sequences in the counter */
+int jellyfish_counter_query(const jellyfish_counter* counter, const char* const* seqs, const size_t* lens,
+                            size_t nb, unsigned int threads, uint64_t* counts);
+
+/* Write the content of the counter to path as a binary database, as
+ * 'jellyfish count' does, with out_counter_len bytes per count. Only
+ * the k-mers with a count in [lower, upper] are written (0 and
+ * UINT64_MAX to write all). The counter is not changed. */
+int jellyfish_counter_dump(jellyfish_counter* counter, const char* path, unsigned int out_counter_len,
+                           uint64_t lower, uint64_t upper);
+
+/* Open a database in binary format, written by 'jellyfish count',
+ * 'jellyfish merge' or jellyfish_counter_dump. The file is memory
+ * mapped. */
+jellyfish_db* jellyfish_db_open(const char* path);
+void jellyfish_db_close(jellyfish_db* db);
+unsigned int jellyfish_db_k(const jellyfish_db* db);
+/* Whether the k-mers are canonical. If so, the queries canonicalize
+ * the k-mers. */
+int jellyfish_db_canonical(const jellyfish_db* db);
+/* Number of k-mers in the database */
+uint64_t jellyfish_db_size(const jellyfish_db* db);
+
+/* Count of every k-mer of the sequences in the database */
+int jellyfish_db_query(const jellyfish_db* db, const char* const* seqs, const size_t* lens, size_t nb,
+                       unsigned int threads, uint64_t* counts);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __JELLYFISH_JELLYFISH_C_H__ */
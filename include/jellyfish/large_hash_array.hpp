@@ -18,15 +18,16 @@
 #define __JELLYFISH_LARGE_HASH_ARRAY_HPP__
 
 #include <jellyfish/storage.hpp>
-#include <jellyfish/atomic_gcc.hpp>
+#include <jellyfish/atomic_cxx11.hpp>
 #include <jellyfish/allocators_mmap.hpp>
 #include <jellyfish/offsets_key_value.hpp>
 #include <jellyfish/misc.hpp>
 #include <jellyfish/err.hpp>
 #include <jellyfish/mer_dna.hpp>
-#include <jellyfish/rectangular_binary_matrix.hpp>
+#include <jellyfish/invertible_hash.hpp>
 #include <jellyfish/simple_circular_buffer.hpp>
 #include <jellyfish/large_hash_iterator.hpp>
+#include <jellyfish/thread_stats.hpp>
 
 namespace jellyfish { namespace large_hash {
 /* Contains an integer, the reprobe limit. It is capped based on the
@@ -97,8 +98,8 @@ protected:
   word * const             data_;
   atomic_t                 atomic_;
   const size_t            *reprobes_;
-  RectangularBinaryMatrix  hash_matrix_;
-  RectangularBinaryMatrix  hash_inverse_matrix_;
+  invertible_hash          hash_;
+  invertible_hash          hash_inverse_;
 
 public:
   /// Give information about memory usage and array size.
@@ -159,7 +160,7 @@ public:
              uint16_t key_len, // Size of key in bits
              uint16_t val_len, // Size of val in bits
              uint16_t reprobe_limit, // Maximum reprobe
-             RectangularBinaryMatrix m,
+             const invertible_hash& h,
              const size_t* reprobes = quadratic_reprobes) : // Reprobing policy
     lsize_(ceilLog2(size)),
     size_((size_t)1 << lsize_),
@@ -171,8 +172,8 @@ public:
     size_bytes_(div_ceil(size_, (size_t)offsets_.block_len()) * offsets_.block_word_len() * sizeof(word)),
     data_(static_cast<Derived*>(this)->alloc_data(size_bytes_)),
     reprobes_(reprobes),
-    hash_matrix_(m),
-    hash_inverse_matrix_(hash_matrix_.pseudo_inverse())
+    hash_(h),
+    hash_inverse_(hash_.pseudo_inverse())
   {
     if(!data_)
       throw ErrorAllocation(err::msg() << "Failed to allocate "
@@ -191,8 +192,8 @@ public:
     size_bytes_(ary.size_bytes_),
     data_(ary.data_),
     reprobes_(ary.reprobes_),
-    hash_matrix_(std::move(ary.hash_matrix_)),
-    hash_inverse_matrix_(std::move(ary.hash_inverse_matrix_))
+    hash_(std::move(ary.hash_)),
+    hash_inverse_(std::move(ary.hash_inverse_))
   { }
 
   array_base& operator=(const array_base& rhs) = delete;
@@ -208,12 +209,16 @@ public:
   uint_t max_reprobe() const { return reprobe_limit_.val(); }
   size_t max_reprobe_offset() const { return reprobes_[reprobe_limit_.val()]; }
 
-  const RectangularBinaryMatrix& matrix() const { return hash_matrix_; }
-  const RectangularBinaryMatrix& inverse_matrix() const { return hash_inverse_matrix_; }
-  void matrix(const RectangularBinaryMatrix& m) {
-    hash_inverse_matrix_ = m.pseudo_inverse();
-    hash_matrix_         = m;
+  const invertible_hash& hash_function() const { return hash_; }
+  const invertible_hash& inverse_hash_function() const { return hash_inverse_; }
+  void hash_function(const invertible_hash& h) {
+    hash_inverse_ = h.pseudo_inverse();
+    hash_         = h;
   }
+  // The matrices of a hash function of the MATRIX family
+  const RectangularBinaryMatrix& matrix() const { return hash_.matrix(); }
+  const RectangularBinaryMatrix& inverse_matrix() const { return hash_inverse_.matrix(); }
+  void matrix(const RectangularBinaryMatrix& m) { hash_function(m); }
 
   /**
    * Clear hash table. Not thread safe.
@@ -296,7 +301,7 @@ public:
    * contain the proper information.
    */
   inline bool add(const key_type& key, mapped_type val, unsigned int* carry_shift, bool* is_new, size_t* id) {
-    uint64_t hash = hash_matrix_.times(key);
+    uint64_t hash = hash_.times(key);
     *carry_shift  = 0;
     return add_rec(hash & size_mask_, key, val, false, is_new, id, carry_shift);
   }
@@ -321,7 +326,7 @@ public:
     word*           w;
     const offset_t* o;
 
-    *id = hash_matrix_.times(key) & size_mask_;
+    *id = hash_.times(key) & size_mask_;
     return claim_key(key, is_new, id, &o, &w);
   }
 
@@ -437,7 +442,20 @@ public:
   // information where the key was found. These can be used later one
   // to fetch the value associated with the key.
   inline bool get_key_id(const key_type& key, size_t* id, key_type& tmp_key, const word** w, const offset_t** o) const {
-    return get_key_id(key, id, tmp_key, w, o, hash_matrix_.times(key) & size_mask_);
+    return get_key_id(key, id, tmp_key, w, o, hash_.times(key) & size_mask_);
+  }
+
+  // Compute the position of key in the hash (first probe) and
+  // prefetch the memory holding it. The returned value can be passed
+  // as oid to get_key_id, to overlap the memory access for key with
+  // other work.
+  size_t prefetch_key(const key_type& key) const {
+    const size_t    oid = hash_.times(key) & size_mask_;
+    const offset_t *o, *lo;
+    const word*     w   = offsets_.word_offset(oid, &o, &lo, data_);
+    __builtin_prefetch(w + o->key.woff, 0, 1);
+    __builtin_prefetch(o, 0, 3);
+    return oid;
   }
 
   // Find the actual id of the key in the hash, starting at oid.
@@ -493,8 +511,8 @@ public:
   template<typename Iterator>
   Iterator iterator_all() const { return iterator_slice<Iterator>(0, 1); }
 
-  // See hash_counter.hpp for why we added this method. It should not
-  // be needed, but I can't get the thing to compile without :(.
+  // Same as iterator_slice<eager_iterator>, which a caller in a
+  // template must spell ary->template iterator_slice<eager_iterator>().
   eager_iterator eager_slice(size_t index, size_t nb_slices) const {
     return iterator_slice<eager_iterator>(index, nb_slices);
   }
@@ -587,6 +605,7 @@ public:
         key_claimed = set_key(kw, nkey, o->key.mask1, o->key.mask1, is_new);
       }
       if(!key_claimed) { // reprobe
+        thread_stats::incr<&thread_stats::reprobes>();
         if(++reprobe > reprobe_limit_.val())
           return false;
         cid = (*id + reprobes_[reprobe]) & size_mask_;
@@ -634,6 +653,7 @@ public:
         key_claimed = set_key(kw, nkey, o->key.mask1, lo->key.mask1);
       }
       if(!key_claimed) { //reprobe
+        thread_stats::incr<&thread_stats::reprobes>();
         if(++reprobe > reprobe_limit_.val())
           return false;
         cid  = (*id + reprobes_[reprobe]) & size_mask_;
@@ -715,6 +735,7 @@ public:
         *is_new = true;
         return true;
       }
+      thread_stats::incr<&thread_stats::cas_failures>();
       ow = nw;
       okey = ow & free_mask;
     }
@@ -731,14 +752,24 @@ public:
   // particular part of the word in which the value is stored. The
   // return value is the carry.
   inline word add_val(word *w, word val, uint_t shift, word mask) {
-    word now = *w, ow, nw, nval;
+    word ow, nw, nval;
 
-    do {
-      ow = now;
+    if((mask >> shift) == (~(word)0 >> shift)) {
+      // The value is in the high bits of the word: a plain add
+      // overflows out of the word, leaving the other bits unchanged.
+      ow   = atomic_.fetch_add_relaxed(w, val << shift);
       nval = ((ow & mask) >> shift) + val;
-      nw = (ow & ~mask) | ((nval << shift) & mask);
-      now = atomic_.cas(w, ow, nw);
-    } while(now != ow);
+      return nval & (~(mask >> shift));
+    }
+
+    ow = *w;
+    while(true) {
+      nval = ((ow & mask) >> shift) + val;
+      nw   = (ow & ~mask) | ((nval << shift) & mask);
+      if(atomic_.cas_weak(w, &ow, nw))
+        break;
+      thread_stats::incr<&thread_stats::cas_failures>();
+    }
 
     return nval & (~(mask >> shift));
   }
@@ -930,7 +961,7 @@ public:
 
 };
 
-template<typename Key, typename word = uint64_t, typename atomic_t = ::atomic::gcc, typename mem_block_t = ::allocators::mmap>
+template<typename Key, typename word = uint64_t, typename atomic_t = ::atomic::standard, typename mem_block_t = ::allocators::mmap>
 class array :
     protected mem_block_t,
     public array_base<Key, word, atomic_t, array<Key, word, atomic_t, mem_block_t> >
@@ -949,6 +980,19 @@ public:
           reprobes)
   { }
 
+  // Use the given hash function instead of a random matrix (a
+  // RectangularBinaryMatrix converts to a hash function). It must be
+  // pseudo-invertible and map key_len bits to ceilLog2(size) bits.
+  array(size_t size, // Size of hash. To be rounded up to a power of 2
+        uint16_t key_len, // Size of key in bits
+        uint16_t val_len, // Size of val in bits
+        uint16_t reprobe_limit, // Maximum reprobe
+        const invertible_hash& h,
+        const size_t* reprobes = quadratic_reprobes) : // Reprobing policy
+    mem_block_t(),
+    super(size, key_len, val_len, reprobe_limit, h, reprobes)
+  { }
+
 protected:
   word* alloc_data(size_t s) {
     mem_block_t::realloc(s);
@@ -961,7 +1005,7 @@ struct ptr_info {
   size_t bytes_;
   ptr_info(void* ptr, size_t bytes) : ptr_(ptr), bytes_(bytes) { }
 };
-template<typename Key, typename word = uint64_t, typename atomic_t = ::atomic::gcc>
+template<typename Key, typename word = uint64_t, typename atomic_t = ::atomic::standard>
 class array_raw :
     protected ptr_info,
     public array_base<Key, word, atomic_t, array_raw<Key, word, atomic_t> >
@@ -976,10 +1020,10 @@ public:
             uint16_t key_len, // Size of key in bits
             uint16_t val_len, // Size of val in bits
             uint16_t reprobe_limit, // Maximum reprobe
-            RectangularBinaryMatrix m,
+            const invertible_hash& h,
             const size_t* reprobes = quadratic_reprobes) : // Reprobing policy
     ptr_info(ptr, bytes),
-    super(size, key_len, val_len, reprobe_limit, m, reprobes)
+    super(size, key_len, val_len, reprobe_limit, h, reprobes)
   { }
 
 protected:
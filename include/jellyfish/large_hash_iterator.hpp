@@ -58,7 +58,7 @@ public:
     while(success != array::FILLED && id_ < end_id_)
       success = ary_->get_key_val_at_id(id_++, key_, val_);
     if(success == array::FILLED)
-      key_.set_bits(0, ary_->lsize(), ary_->inverse_matrix().times(key_));
+      key_.set_bits(0, ary_->lsize(), ary_->inverse_hash_function().times(key_));
 
     return success == array::FILLED;
   }
@@ -97,7 +97,7 @@ public:
   uint64_t end() const { return end_id_; }
   const key_type& key() {
     if(!reversed_key_) {
-      key_.set_bits(0, ary_->lsize(), ary_->inverse_matrix().times(key_));
+      key_.set_bits(0, ary_->lsize(), ary_->inverse_hash_function().times(key_));
       reversed_key_ = true;
     }
     return key_;
@@ -171,7 +171,7 @@ public:
 
   const key_type& key() {
     if(!reversed_key_) {
-      key_->set_bits(0, ary_->lsize(), ary_->inverse_matrix().times(*key_));
+      key_->set_bits(0, ary_->lsize(), ary_->inverse_hash_function().times(*key_));
       reversed_key_ = true;
     }
     return *key_;
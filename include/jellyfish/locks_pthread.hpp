@@ -19,8 +19,10 @@
 #define __JELLYFISH_LOCKS_PTHREAD_HPP__
 
 #include <time.h>
+#include <unistd.h>
 #include <sys/time.h>
 #include <pthread.h>
+#include <algorithm>
 #ifdef HAVE_CONFIG_H
 #include <config.h>
 #endif
@@ -201,6 +203,97 @@ public:
 };
 
 #endif
+
+/// Hint to the processor that the thread busy waits.
+inline void cpu_relax() {
+#if defined(__i386__) || defined(__x86_64__)
+  __asm__ __volatile__("pause" ::: "memory");
+#else
+  __asm__ __volatile__("" ::: "memory");
+#endif
+}
+
+/// Default number of spins before blocking: none on a single
+/// processor, where the thread waited for cannot run while spinning.
+inline unsigned int default_spins() {
+  static const unsigned int spins = sysconf(_SC_NPROCESSORS_ONLN) > 1 ? 1 << 14 : 0;
+  return spins;
+}
+
+/// Busy wait until pred() is true, with exponential back-off, for at
+/// most about `spins` cpu_relax(). Returns false if pred() is still
+/// false. On success, the writes made before pred() became true are
+/// visible.
+template<typename Pred>
+bool spin_until(Pred pred, unsigned int spins = default_spins()) {
+  unsigned int backoff = 1;
+  for(unsigned int total = 0; total < spins; total += backoff) {
+    if(pred()) {
+      __sync_synchronize();
+      return true;
+    }
+    for(unsigned int i = 0; i < backoff; ++i)
+      cpu_relax();
+    backoff = std::min(2 * backoff, 1024u);
+  }
+  if(!pred())
+    return false;
+  __sync_synchronize();
+  return true;
+}
+
+/// Sense reversing barrier. A waiting thread spins for a while, as a
+/// barrier is usually short when all the threads run, then it blocks
+/// on a condition variable. Unlike barrier, there is no wake up of all
+/// the threads at once when the waits are short.
+class spin_barrier
+{
+  const unsigned int    count_;
+  const unsigned int    spins_;
+  volatile unsigned int arrived_;
+  volatile bool         sense_;
+  cond                  cond_;
+
+public:
+  explicit spin_barrier(unsigned int count, unsigned int spins = default_spins()) :
+    count_(count), spins_(spins), arrived_(0), sense_(false)
+  { }
+
+  /// Return true for the serial thread (the last one to arrive). If
+  /// parked is not null, it is set to true if the thread blocked.
+  bool wait(bool* parked = 0) {
+    const bool sense = !sense_; // Does not change until this thread arrives
+    if(__sync_add_and_fetch(&arrived_, 1) == count_) {
+      // The reset must be visible before the new sense_: a thread
+      // released by it may arrive at the next round right away.
+      __atomic_store_n(&arrived_, 0, __ATOMIC_RELEASE);
+      cond_.lock();
+      __atomic_store_n(&sense_, sense, __ATOMIC_RELEASE);
+      cond_.broadcast();
+      cond_.unlock();
+      return true;
+    }
+
+    if(!spin_until([&]() { return __atomic_load_n(&sense_, __ATOMIC_ACQUIRE) == sense; }, spins_)) {
+      if(parked)
+        *parked = true;
+      cond_.lock();
+      while(sense_ != sense)
+        cond_.wait();
+      cond_.unlock();
+    }
+    return false;
+  }
+
+  /// Wait on the barrier after helping with the work done before
+  /// it. help() does a part of the work and returns false when no part
+  /// is left. The threads arriving first do more of the work.
+  template<typename Help>
+  bool wait(Help help, bool* parked = 0) {
+    while(help()) ;
+    return wait(parked);
+  }
+};
 } //namespace pthread {
 
 typedef pthread::cond cond;
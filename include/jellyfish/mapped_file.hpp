@@ -35,13 +35,13 @@ protected:
   char        *_base, *_end;
   size_t       _length;
 
-  void map_(int fd) {
+  void map_(int fd, int flags = 0) {
     struct stat stat;
     if(fstat(fd, &stat) < 0)
       throw ErrorMMap(err::msg() << "Can't stat file '" << _path << "'" << err::no);
 
     _length = stat.st_size;
-    _base = (char*)mmap(NULL, _length, PROT_READ, MAP_SHARED, fd, 0);
+    _base = (char*)mmap(NULL, _length, PROT_READ, MAP_SHARED | flags, fd, 0);
     if(_base == MAP_FAILED) {
       _base = 0;
       throw ErrorMMap(err::msg() << "Can't mmap file '" << _path << "'" << err::no);
@@ -49,11 +49,11 @@ protected:
     _end = _base + _length;
   }
 
-  void map_(const char *filename) {
+  void map_(const char *filename, int flags = 0) {
     int fd = open(filename, O_RDONLY);
     if(fd < 0)
       throw ErrorMMap(err::msg() << "Can't open file '" << filename << "'" << err::no);
-    map_(fd);
+    map_(fd, flags);
     close(fd);
   }
 
@@ -61,10 +61,12 @@ protected:
 public:
   define_error_class(ErrorMMap);
   mapped_file() : _path(), _base(0), _end(0), _length(0) { }
-  explicit mapped_file(const char *filename)
+  /// Map the file read only. The flags are added to the flags passed
+  /// to mmap, e.g. populate_flag() to read the whole file now.
+  explicit mapped_file(const char *filename, int flags = 0)
   : _path(filename), _base(0), _end(0), _length(0)
   {
-    map_(filename);
+    map_(filename, flags);
   }
   explicit mapped_file(int fd)
   : _path(), _base(0), _end(0), _length()
@@ -117,6 +119,15 @@ public:
     std::swap(_length, rhs._length);
   }
 
+  /// Flag to pre-fault the mapping (MAP_POPULATE), 0 if not supported
+  static int populate_flag() {
+#ifdef MAP_POPULATE
+    return MAP_POPULATE;
+#else
+    return 0;
+#endif
+  }
+
   char *base() const { return _base; }
   char *end() const { return _end; }
   size_t length() const { return _length; }
@@ -135,6 +146,14 @@ public:
     madvise(_base, _length, MADV_RANDOM);
     return *this;
   }
+  // Ask for transparent huge pages. Only honored by some file
+  // systems (e.g. tmpfs), ignored otherwise.
+  const mapped_file & huge_pages() const {
+#ifdef MADV_HUGEPAGE
+    madvise(_base, _length, MADV_HUGEPAGE);
+#endif
+    return *this;
+  }
   const mapped_file & lock() const {
     if(mlock(_base, _length) < 0)
       throw ErrorMMap(err::msg() << "Can't lock map in memory" << err::no);
@@ -19,6 +19,9 @@
 
 #include <jellyfish/mer_dna.hpp>
 #include <jellyfish/bloom_counter2.hpp>
+#include <jellyfish/bloom_counter2_blocked.hpp>
+#include <jellyfish/count_min_sketch.hpp>
+#include <jellyfish/cuckoo_filter.hpp>
 #include <jellyfish/bloom_filter.hpp>
 #include <jellyfish/rectangular_binary_matrix.hpp>
 #include <jellyfish/misc.hpp>
@@ -43,6 +46,12 @@ struct hash_pair<mer_dna> {
 
 typedef bloom_counter2<mer_dna> mer_dna_bloom_counter;
 typedef bloom_counter2_file<mer_dna> mer_dna_bloom_counter_file;
+typedef bloom_counter2_blocked<mer_dna> mer_dna_blocked_bloom_counter;
+typedef bloom_counter2_blocked_file<mer_dna> mer_dna_blocked_bloom_counter_file;
+typedef count_min_sketch<mer_dna> mer_dna_count_min_sketch;
+typedef count_min_sketch_file<mer_dna> mer_dna_count_min_sketch_file;
+typedef cuckoo_filter<mer_dna> mer_dna_cuckoo_filter;
+typedef cuckoo_filter_file<mer_dna> mer_dna_cuckoo_filter_file;
 typedef bloom_filter<mer_dna> mer_dna_bloom_filter;
 typedef bloom_filter_file<mer_dna> mer_dna_bloom_filter_file;
 }
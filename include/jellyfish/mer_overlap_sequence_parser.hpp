@@ -24,6 +24,7 @@
 #include <jellyfish/err.hpp>
 #include <jellyfish/cooperative_pool2.hpp>
 #include <jellyfish/cpp_array.hpp>
+#include <jellyfish/progress.hpp>
 
 namespace jellyfish {
 
@@ -158,6 +159,7 @@ protected:
       memcpy(buff.start, st.seam, mer_len_ - 1);
       read = mer_len_ - 1;
     }
+    const size_t seam = read;
 
     // Here, the current stream is assumed to always point to some
     // sequence (or EOF). Never at header.
@@ -170,6 +172,7 @@ protected:
       }
     }
     buff.end = buff.start + read;
+    progress::add(progress::INPUT_BASES, read - seam);
 
     st.have_seam = read >= (size_t)(mer_len_ - 1);
     if(st.have_seam)
@@ -182,6 +185,7 @@ protected:
       memcpy(buff.start, st.seam, mer_len_ - 1);
       read = mer_len_ - 1;
     }
+    const size_t seam = read;
 
     // Here, the st.stream is assumed to always point to some
     // sequence (or EOF). Never at header.
@@ -200,6 +204,7 @@ protected:
       }
     }
     buff.end = buff.start + read;
+    progress::add(progress::INPUT_BASES, read - seam);
 
     st.have_seam = read >= (size_t)(mer_len_ - 1);
     if(st.have_seam)
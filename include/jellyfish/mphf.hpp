@@ -0,0 +1,233 @@
+/*  This file is part of Jellyfish.
+
+    Jellyfish is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Jellyfish is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Jellyfish.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef __JELLYFISH_MPHF_HPP__
+#define __JELLYFISH_MPHF_HPP__
+
+#include <stdint.h>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+
+#include <jellyfish/err.hpp>
+#include <jellyfish/thread_exec.hpp>
+
+namespace jellyfish {
+/// Minimal perfect hash function (MPHF) in the style of BBHash. Each
+/// level is a bit array of about gamma * n bits, where n is the number
+/// of keys not yet placed. A key hashed to a position where no other
+/// key collides sets its bit and is placed. The others go to the next
+/// level. The index of a key is the rank of its bit in the
+/// concatenation of all the levels.
+namespace mphf {
+inline uint64_t mix(uint64_t h) {
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return h;
+}
+
+/// Hash of a key for a given level. For a key of one word, it is a
+/// bijection. Hence two distinct keys never collide on every level.
+template<typename Key>
+inline uint64_t hash(const Key& k, uint64_t level) {
+  uint64_t h = (level + 1) * 0x9e3779b97f4a7c15ULL;
+  for(unsigned int i = 0; i < k.nb_words(); ++i)
+    h = mix(h ^ k.word(i));
+  return h;
+}
+
+/// Position in [0, size) from a hash, without a division.
+inline uint64_t reduce(uint64_t h, uint64_t size) {
+  return ((unsigned __int128)h * size) >> 64;
+}
+
+/// Query side of the MPHF. The bit arrays of the levels are
+/// concatenated in bits, and ranks holds the number of bits set
+/// before each block of 512 bits (one cache line). The memory is not
+/// owned (it may be in a mapped file). A lookup of a key placed in the
+/// first level touches one block of bits and one rank sample.
+class query {
+  std::vector<uint64_t> offsets_; // Offset in bits of each level, plus total
+  const uint64_t*       bits_;
+  const uint64_t*       ranks_;
+
+public:
+  static const uint64_t not_found   = (uint64_t)-1;
+  static const int      block_words = 8;
+
+  query(const std::vector<uint64_t>& sizes, const uint64_t* bits, const uint64_t* ranks) :
+    offsets_(1, 0), bits_(bits), ranks_(ranks)
+  {
+    for(auto it = sizes.cbegin(); it != sizes.cend(); ++it)
+      offsets_.push_back(offsets_.back() + *it);
+  }
+
+  /// Number of 64-bit words in the bit arrays of levels of sizes
+  static size_t nb_words(const std::vector<uint64_t>& sizes) {
+    size_t res = 0;
+    for(auto it = sizes.cbegin(); it != sizes.cend(); ++it)
+      res += *it / 64;
+    return res;
+  }
+  /// Number of rank samples for levels of sizes
+  static size_t nb_ranks(const std::vector<uint64_t>& sizes) {
+    return (nb_words(sizes) + block_words - 1) / block_words + 1;
+  }
+
+  size_t nb_levels() const { return offsets_.size() - 1; }
+  size_t size() const { return ranks_[nb_ranks_() - 1]; }
+
+  /// Index of key in [0, size()), or not_found. A key not in the set
+  /// the MPHF was built from may be given the index of another key.
+  template<typename Key>
+  uint64_t operator()(const Key& k) const {
+    for(size_t l = 0; l < nb_levels(); ++l) {
+      const uint64_t pos = offsets_[l] + reduce(hash(k, l), offsets_[l + 1] - offsets_[l]);
+      if(bits_[pos / 64] & ((uint64_t)1 << (pos % 64)))
+        return rank(pos);
+    }
+    return not_found;
+  }
+
+  /// Prefetch the memory to lookup a key in the first level
+  template<typename Key>
+  void prefetch(const Key& k) const {
+    if(nb_levels() == 0) return;
+    const uint64_t pos = reduce(hash(k, 0), offsets_[1]);
+    __builtin_prefetch(bits_ + pos / 64);
+    __builtin_prefetch(ranks_ + pos / (64 * block_words));
+  }
+
+  /// Number of bits set before position pos
+  uint64_t rank(uint64_t pos) const {
+    const uint64_t w   = pos / 64;
+    uint64_t       res = ranks_[w / block_words];
+    for(uint64_t i = w - w % block_words; i < w; ++i)
+      res += __builtin_popcountll(bits_[i]);
+    return res + __builtin_popcountll(bits_[w] & (((uint64_t)1 << (pos % 64)) - 1));
+  }
+
+private:
+  size_t nb_ranks_() const { return (offsets_.back() / 64 + block_words - 1) / block_words + 1; }
+};
+
+/// Build the MPHF over the keys of source, in parallel. Source must
+/// provide `size_t size() const` and `void key_at(size_t id, Key&)
+/// const`. The levels are built one after the other, each thread
+/// handling a slice of the keys left. A bit is set atomically in the
+/// seen array and, if it was already set, in the collide array.
+template<typename Key, typename Source>
+class builder : public thread_exec {
+  const Source&                      source_;
+  const double                       gamma_;
+  const int                          nb_threads_;
+  std::vector<uint64_t>              sizes_;
+  std::vector<uint64_t>              bits_;
+  std::vector<uint64_t>              ranks_;
+
+  // State of the level being built
+  const std::vector<uint64_t>*       ids_; // Keys left. All of them if NULL
+  uint64_t                           level_;
+  uint64_t                           level_size_;
+  std::vector<uint64_t>              seen_;
+  std::vector<uint64_t>              collide_;
+  std::vector<std::vector<uint64_t>> left_; // Keys left for the next level, per thread
+  int                                phase_;
+
+public:
+  static const uint64_t max_levels = 64;
+  define_error_class(ErrorBuilding);
+
+  builder(const Source& source, double gamma = 2.0, int nb_threads = 1) :
+    source_(source), gamma_(std::max(1.0, gamma)), nb_threads_(std::max(1, nb_threads))
+  {
+    build();
+  }
+
+  const std::vector<uint64_t>& sizes() const { return sizes_; }
+  const std::vector<uint64_t>& bits() const { return bits_; }
+  const std::vector<uint64_t>& ranks() const { return ranks_; }
+  query get_query() const { return query(sizes_, bits_.data(), ranks_.data()); }
+
+  virtual void start(int thid) {
+    const size_t n     = ids_ ? ids_->size() : source_.size();
+    const size_t start = (n * thid) / nb_threads_;
+    const size_t end   = (n * (thid + 1)) / nb_threads_;
+    Key          key;
+
+    for(size_t i = start; i < end; ++i) {
+      const uint64_t id = ids_ ? (*ids_)[i] : i;
+      source_.key_at(id, key);
+      const uint64_t pos = reduce(hash(key, level_), level_size_);
+      const uint64_t bit = (uint64_t)1 << (pos % 64);
+      if(phase_ == 0) {
+        if((__sync_fetch_and_or(&seen_[pos / 64], bit) & bit) && !(collide_[pos / 64] & bit))
+          __sync_fetch_and_or(&collide_[pos / 64], bit);
+      } else if(!(seen_[pos / 64] & bit)) {
+        left_[thid].push_back(id);
+      }
+    }
+  }
+
+private:
+  void build() {
+    std::vector<uint64_t> ids;
+    ids_ = 0;
+    for(level_ = 0; ids_ == 0 || !ids_->empty(); ++level_) {
+      const size_t n = ids_ ? ids_->size() : source_.size();
+      if(n == 0) break;
+      if(level_ >= max_levels)
+        throw ErrorBuilding(err::msg() << "Failed to place " << n << " keys after " << max_levels << " levels");
+      level_size_ = std::max((uint64_t)1, (uint64_t)std::ceil(gamma_ * n / 64)) * 64;
+      seen_.assign(level_size_ / 64, 0);
+      collide_.assign(level_size_ / 64, 0);
+      phase_ = 0;
+      exec_join(nb_threads_);
+
+      for(size_t i = 0; i < seen_.size(); ++i)
+        seen_[i] &= ~collide_[i];
+      left_.assign(nb_threads_, std::vector<uint64_t>());
+      phase_ = 1;
+      exec_join(nb_threads_);
+
+      sizes_.push_back(level_size_);
+      bits_.insert(bits_.end(), seen_.cbegin(), seen_.cend());
+      std::vector<uint64_t> next;
+      for(auto it = left_.cbegin(); it != left_.cend(); ++it)
+        next.insert(next.end(), it->cbegin(), it->cend());
+      ids.swap(next);
+      ids_ = &ids;
+    }
+    std::vector<uint64_t>().swap(seen_);
+    std::vector<uint64_t>().swap(collide_);
+
+    ranks_.resize(query::nb_ranks(sizes_));
+    uint64_t total = 0;
+    for(size_t i = 0; i < bits_.size(); ++i) {
+      if(i % query::block_words == 0)
+        ranks_[i / query::block_words] = total;
+      total += __builtin_popcountll(bits_[i]);
+    }
+    ranks_.back() = total;
+  }
+};
+} // namespace mphf
+} // namespace jellyfish
+
+#endif /* __JELLYFISH_MPHF_HPP__ */
@@ -0,0 +1,155 @@
+/*  This file is part of Jellyfish.
+
+    Jellyfish is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Jellyfish is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Jellyfish.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __JELLYFISH_PROGRESS_HPP__
+#define __JELLYFISH_PROGRESS_HPP__
+
+#include <stdint.h>
+#include <pthread.h>
+#include <string>
+#include <chrono>
+
+#include <jellyfish/err.hpp>
+
+namespace jellyfish {
+/// Live counters of the progress of a command, for the whole
+/// process. They are updated with atomic operations, in batches (see
+/// progress_batch) on the hot paths, and published by a
+/// progress_reporter.
+class progress {
+public:
+  enum counter {
+    INPUT_FILES,      // Input files and pipes opened
+    INPUT_FILE_BYTES, // Size of the regular input files opened
+    INPUT_BASES,      // Bases parsed from the input
+    MERS,             // k-mers parsed
+    NEW_KEYS,         // k-mers inserted in the hash for the first time
+    DUMPED_KEYS,      // NEW_KEYS at the time of the last dump
+    HASH_SIZE,        // Current size of the hash
+    DOUBLINGS,        // Doublings of the size of the hash
+    DUMPS,            // Dumps of the hash to disk
+    RECORDS_READ,     // Records read from databases
+    RECORDS_WRITTEN,  // Records written to the output
+    NB_COUNTERS
+  };
+
+private:
+  uint64_t values_[NB_COUNTERS];
+
+  progress() {
+    for(int i = 0; i < NB_COUNTERS; ++i)
+      values_[i] = 0;
+  }
+  static progress& global() {
+    static progress p;
+    return p;
+  }
+
+public:
+  static void add(counter c, uint64_t x) { __sync_fetch_and_add(&global().values_[c], x); }
+  static void set(counter c, uint64_t x) { __atomic_store_n(&global().values_[c], x, __ATOMIC_RELAXED); }
+  static uint64_t get(counter c) { return __atomic_load_n(&global().values_[c], __ATOMIC_RELAXED); }
+};
+
+/// Add to a progress counter in batches, to keep the atomic
+/// operations off the hot path. The remainder is added on
+/// destruction.
+class progress_batch {
+  static const uint64_t batch_size = 4096;
+  const progress::counter c_;
+  uint64_t                n_;
+
+public:
+  explicit progress_batch(progress::counter c) : c_(c), n_(0) { }
+  ~progress_batch() { flush(); }
+
+  void add(uint64_t x) {
+    n_ += x;
+    if(n_ >= batch_size)
+      flush();
+  }
+  progress_batch& operator++() {
+    add(1);
+    return *this;
+  }
+  void flush() {
+    if(n_) {
+      progress::add(c_, n_);
+      n_ = 0;
+    }
+  }
+};
+
+/// Publish the progress counters in the Prometheus text format, from
+/// a background thread:
+///
+/// - every `interval` seconds to the file `path`, if not null. The
+///   file is replaced atomically. It is also written on SIGUSR1 and
+///   when the reporter is destroyed.
+///
+/// - to every client connecting to the Unix socket `socket_path`, if
+///   not null, as an HTTP response (e.g. `curl --unix-socket path
+///   http://localhost/metrics`).
+///
+/// Without a file, SIGUSR1 writes the metrics to stderr.
+class progress_reporter {
+  const std::string command_;
+  const std::string path_;
+  const std::string socket_path_;
+  const double      interval_;
+  int               socket_;
+  int               wake_[2]; // Pipe to wake up the thread: 'u' on SIGUSR1, 's' to stop
+  pthread_t         thread_;
+
+  typedef std::chrono::steady_clock clock;
+  const clock::time_point start_;
+  clock::time_point       last_time_; // Time and k-mers of the last publication, for the rate
+  uint64_t                last_mers_;
+  double                  rate_;
+
+  static void* start_routine(void* self);
+  void run();
+  void write_file();
+  void serve_client();
+
+public:
+  define_error_class(Error);
+
+  progress_reporter(const char* command, const char* path, double interval, const char* socket_path);
+  ~progress_reporter();
+
+  /// The metrics in the Prometheus text format
+  std::string metrics();
+};
+
+/// The progress reporter requested by the switches --metrics,
+/// --metrics-interval and --metrics-socket of a subcommand, or null
+/// if none is requested. Dies on error.
+template<typename Args>
+progress_reporter* make_progress_reporter(const char* command, const Args& args) {
+  if(!args.metrics_given && !args.metrics_socket_given)
+    return 0;
+  try {
+    return new progress_reporter(command, args.metrics_given ? args.metrics_arg : 0, args.metrics_interval_arg,
+                                 args.metrics_socket_given ? args.metrics_socket_arg : 0);
+  } catch(progress_reporter::Error& e) {
+    err::die(err::msg() << e.what());
+  }
+  return 0;
+}
+} // namespace jellyfish
+
+#endif /* __JELLYFISH_PROGRESS_HPP__ */
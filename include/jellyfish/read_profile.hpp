@@ -0,0 +1,113 @@
+/*  This file is part of Jellyfish.
+
+    Jellyfish is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Jellyfish is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Jellyfish.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __JELLYFISH_READ_PROFILE_HPP__
+#define __JELLYFISH_READ_PROFILE_HPP__
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <istream>
+#include <ostream>
+#include <algorithm>
+
+namespace jellyfish {
+/// Profile of a read: the counts of its k-mers, in order. In binary
+/// format, after the file header, each read is a record made of:
+///
+/// - the length of the header of the read (uint32_t),
+/// - the header of the read,
+/// - the number of k-mers n (uint32_t),
+/// - n counts, each on counter_len bytes (saturated).
+namespace profile {
+const char* const format = "profile/binary";
+
+/// Summary statistics of the counts of the k-mers of a read
+struct summary {
+  uint64_t nb_mers;
+  uint64_t min;
+  uint64_t median;
+  double   below;               // Fraction of k-mers with count < threshold
+
+  /// Compute the summary of counts. tmp is a scratch buffer, reused
+  /// between calls to avoid allocations. The median of an even number
+  /// of counts is the lower of the two middle counts.
+  summary(const std::vector<uint64_t>& counts, uint64_t threshold, std::vector<uint64_t>& tmp) :
+    nb_mers(counts.size()), min(0), median(0), below(0.0)
+  {
+    if(counts.empty()) return;
+    tmp.assign(counts.cbegin(), counts.cend());
+    auto mid = tmp.begin() + (tmp.size() - 1) / 2;
+    std::nth_element(tmp.begin(), mid, tmp.end());
+    median = *mid;
+    min    = *std::min_element(tmp.begin(), mid + 1);
+    const size_t nb_below = std::count_if(counts.cbegin(), counts.cend(),
+                                          [=](uint64_t c) { return c < threshold; });
+    below  = (double)nb_below / nb_mers;
+  }
+};
+
+class writer {
+  const unsigned int val_len_;  // In bytes
+  const uint64_t     max_val_;
+
+public:
+  writer(unsigned int val_len) :
+    val_len_(std::min(8u, val_len)),
+    max_val_(val_len_ >= 8 ? (uint64_t)-1 : ((uint64_t)1 << (8 * val_len_)) - 1)
+  { }
+
+  unsigned int val_len() const { return val_len_; }
+
+  void write(std::ostream& out, const std::string& header, const std::vector<uint64_t>& counts) const {
+    const uint32_t header_len = header.size();
+    const uint32_t nb_mers    = counts.size();
+    out.write((const char*)&header_len, sizeof(header_len));
+    out.write(header.data(), header_len);
+    out.write((const char*)&nb_mers, sizeof(nb_mers));
+    for(auto it = counts.cbegin(); it != counts.cend(); ++it) {
+      const uint64_t v = std::min(max_val_, *it);
+      out.write((const char*)&v, val_len_);
+    }
+  }
+};
+
+class reader {
+  const unsigned int val_len_;  // In bytes
+
+public:
+  reader(unsigned int val_len) : val_len_(std::min(8u, val_len)) { }
+
+  /// Read the next record. Returns false at the end of the stream or
+  /// if the record is truncated.
+  bool read(std::istream& in, std::string& header, std::vector<uint64_t>& counts) const {
+    uint32_t header_len, nb_mers;
+    if(!in.read((char*)&header_len, sizeof(header_len))) return false;
+    header.resize(header_len);
+    if(header_len > 0 && !in.read(&header[0], header_len)) return false;
+    if(!in.read((char*)&nb_mers, sizeof(nb_mers))) return false;
+    counts.resize(nb_mers);
+    for(uint32_t i = 0; i < nb_mers; ++i) {
+      counts[i] = 0;
+      if(!in.read((char*)&counts[i], val_len_)) return false;
+    }
+    return true;
+  }
+};
+} // namespace profile
+} // namespace jellyfish
+
+#endif /* __JELLYFISH_READ_PROFILE_HPP__ */
@@ -14,12 +14,16 @@
     along with Jellyfish.  If not, see <http://www.gnu.org/licenses/>.
 */
 
-#ifndef __SEQUENCE_MERS_H__
-#define __SEQUENCE_MERS_H__
+#ifndef __JELLYFISH_SEQUENCE_MERS_HPP__
+#define __JELLYFISH_SEQUENCE_MERS_HPP__
 
+#include <string.h>
 #include <iterator>
 #include <jellyfish/mer_dna.hpp>
 
+namespace jellyfish {
+/// Iterator over the k-mers of a sequence in memory. K-mers containing
+/// a non-ACGT base are skipped.
 class sequence_mers : public std::iterator<std::input_iterator_tag, jellyfish::mer_dna> {
 public:
   typedef jellyfish::mer_dna mer_type;
@@ -44,7 +48,7 @@ public:
 
   sequence_mers(sequence_mers&& rhs) :
     cseq_(rhs.cseq_), eseq_(rhs.eseq_), canonical_(rhs.canonical_), filled_(rhs.filled_),
-    m_(std::move(rhs.m_)), rcm_(std::move(rcm_))
+    m_(std::move(rhs.m_)), rcm_(std::move(rhs.rcm_))
   { }
 
   void reset(const char* seq, const char* seqe) {
@@ -86,6 +90,8 @@ public:
       } else
         filled_ = 0;
     } while(filled_ < jellyfish::mer_dna::k() && cseq_ < eseq_);
+    if(filled_ < jellyfish::mer_dna::k()) // Reached the end without a full mer
+      cseq_ = eseq_ = 0;
 
     return *this;
   }
@@ -95,5 +101,6 @@ public:
     return res;
   }
 };
+} // namespace jellyfish
 
-#endif /* __SEQUENCE_MERS_H__ */
+#endif /* __JELLYFISH_SEQUENCE_MERS_HPP__ */
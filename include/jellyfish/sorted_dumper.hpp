@@ -27,6 +27,7 @@
 #include <jellyfish/token_ring.hpp>
 #include <jellyfish/locks_pthread.hpp>
 #include <jellyfish/file_header.hpp>
+#include <jellyfish/trace.hpp>
 
 namespace jellyfish {
 /// Sorted dumper. Write mers according to the hash order. It
@@ -85,6 +86,7 @@ public:
     typename storage_t::key_type key;
 
     for(size_t id = i; id * block_info.second < ary_->size(); id += nb_threads_) {
+      trace::span span("dump_block");
       // Fill buffer
       iterator it(ary_, id * block_info.second, (id + 1) * block_info.second, key);
       heap.fill(it);
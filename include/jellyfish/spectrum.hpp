@@ -0,0 +1,132 @@
+/*  This file is part of Jellyfish.
+
+    Jellyfish is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Jellyfish is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Jellyfish.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __JELLYFISH_SPECTRUM_HPP__
+#define __JELLYFISH_SPECTRUM_HPP__
+
+#include <stdint.h>
+#include <vector>
+#include <limits>
+#include <ostream>
+#include <algorithm>
+
+#include <jellyfish/thread_exec.hpp>
+
+namespace jellyfish {
+/// Histogram and statistics of the counts of k-mers. The histogram
+/// has buckets of width inc. In bucket 'i' are tallied the k-mers
+/// with count 'c' satisfying 'base+i*inc <= c < base+(i+1)*inc',
+/// where base is low-inc (or 0). The first and last buckets are
+/// catchall. The output is the same as for the histo and stats
+/// subcommands.
+class spectrum {
+  uint64_t              base_, ceil_, inc_;
+  std::vector<uint64_t> histo_;
+  uint64_t              uniq_, distinct_, total_, max_;
+
+public:
+  spectrum(uint64_t low = 1, uint64_t high = 10000, uint64_t inc = 1) :
+    base_(inc >= low ? 0 : low - inc),
+    ceil_(high + inc),
+    inc_(inc),
+    histo_((ceil_ + inc_ - base_) / inc_, 0),
+    uniq_(0), distinct_(0), total_(0), max_(0)
+  { }
+
+  void add(uint64_t val) {
+    if(val < base_)
+      ++histo_[0];
+    else if(val > ceil_)
+      ++histo_.back();
+    else
+      ++histo_[(val - base_) / inc_];
+    uniq_  += val == 1;
+    total_ += val;
+    max_    = std::max(max_, val);
+    ++distinct_;
+  }
+
+  /// Add the counts of rhs. It must have the same buckets.
+  spectrum& operator+=(const spectrum& rhs) {
+    for(size_t i = 0; i < histo_.size(); ++i)
+      histo_[i] += rhs.histo_[i];
+    uniq_     += rhs.uniq_;
+    distinct_ += rhs.distinct_;
+    total_    += rhs.total_;
+    max_       = std::max(max_, rhs.max_);
+    return *this;
+  }
+
+  const std::vector<uint64_t>& histo() const { return histo_; }
+  uint64_t uniq() const { return uniq_; }
+  uint64_t distinct() const { return distinct_; }
+  uint64_t total() const { return total_; }
+  uint64_t max() const { return max_; }
+
+  /// Write histogram, skipping empty buckets unless full is true.
+  void write_histo(std::ostream& out, bool full = false) const {
+    uint64_t col = base_;
+    for(size_t i = 0; i < histo_.size(); ++i, col += inc_)
+      if(histo_[i] > 0 || full)
+        out << col << " " << histo_[i] << "\n";
+  }
+
+  void write_stats(std::ostream& out) const {
+    out << "Unique:    " << uniq_ << "\n"
+        << "Distinct:  " << distinct_ << "\n"
+        << "Total:     " << total_ << "\n"
+        << "Max_count: " << max_ << "\n";
+  }
+};
+
+/// Compute the spectrum of a hash array in parallel. Each thread
+/// fills its own spectrum from a slice of the array, which are added
+/// at the end. Only the values are read, the keys are not computed.
+template<typename storage_t>
+class spectrum_computer : public thread_exec {
+  typedef typename storage_t::lazy_iterator iterator;
+
+  const storage_t&      ary_;
+  const int             nb_threads_;
+  const uint64_t        min_, max_;
+  std::vector<spectrum> spectra_;
+
+public:
+  spectrum_computer(const storage_t& ary, int nb_threads, uint64_t min = 0,
+                    uint64_t max = std::numeric_limits<uint64_t>::max()) :
+    ary_(ary), nb_threads_(nb_threads), min_(min), max_(max), spectra_(nb_threads)
+  { }
+
+  virtual void start(int thid) {
+    spectrum& s = spectra_[thid];
+    iterator  it = ary_.template iterator_slice<iterator>(thid, nb_threads_);
+    while(it.next()) {
+      const uint64_t val = it.val();
+      if(val >= min_ && val <= max_)
+        s.add(val);
+    }
+  }
+
+  /// Compute the spectrum and add it to res
+  void compute(spectrum& res) {
+    exec_join(nb_threads_);
+    for(auto it = spectra_.cbegin(); it != spectra_.cend(); ++it)
+      res += *it;
+  }
+};
+} // namespace jellyfish
+
+#endif /* __JELLYFISH_SPECTRUM_HPP__ */
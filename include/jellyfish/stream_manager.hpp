@@ -22,8 +22,12 @@
 #include <list>
 #include <set>
 
+#include <sys/types.h>
+#include <sys/stat.h>
+
 #include <jellyfish/locks_pthread.hpp>
 #include <jellyfish/err.hpp>
+#include <jellyfish/progress.hpp>
 
 namespace jellyfish {
 template<typename PathIterator>
@@ -112,8 +116,13 @@ protected:
       std::string path = *paths_cur_;
       ++paths_cur_;
       res.reset(new file_stream(path.c_str(), *this));
-      if(res->good())
+      if(res->good()) {
+        struct stat st;
+        progress::add(progress::INPUT_FILES, 1);
+        if(!stat(path.c_str(), &st) && S_ISREG(st.st_mode))
+          progress::add(progress::INPUT_FILE_BYTES, st.st_size);
         return;
+      }
       res.reset();
       throw std::runtime_error(err::msg() << "Can't open file '" << path << "'");
     }
@@ -126,6 +135,7 @@ protected:
       res.reset(new pipe_stream(path, *this));
       if(res->good()) {
         busy_pipes_.insert(path);
+        progress::add(progress::INPUT_FILES, 1);
         return;
       }
       // The pipe failed to open, so it is not marked as busy. This
@@ -61,7 +61,7 @@ class text_reader {
   char* buffer_;
   Key key_;
   Val val_;
-  const RectangularBinaryMatrix m_;
+  const invertible_hash         m_;
   const size_t                  size_mask_;
 
 public:
@@ -70,7 +70,7 @@ public:
     is_(is),
     buffer_(new char[header->key_len() / 2 + 1]),
     key_(header->key_len() / 2),
-    m_(header->matrix()),
+    m_(header->hash_function()),
     size_mask_(header->size() - 1)
   { }
 
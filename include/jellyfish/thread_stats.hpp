@@ -0,0 +1,123 @@
+/*  This file is part of Jellyfish.
+
+    Jellyfish is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Jellyfish is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Jellyfish.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __JELLYFISH_THREAD_STATS_HPP__
+#define __JELLYFISH_THREAD_STATS_HPP__
+
+#include <stdint.h>
+#include <chrono>
+
+namespace jellyfish {
+/// Counters and timers of the hot paths of one thread. A thread only
+/// updates its own thread_stats, with plain (non atomic) operations,
+/// and the thread_stats of all the threads are summed after they are
+/// joined.
+///
+/// The thread_stats of the current thread is found with `current()`,
+/// a thread local pointer set by a `thread_stats::scope`. It is null
+/// unless statistics are collected, and it is only looked at on the
+/// slow paths (reprobe, failed CAS, barrier, once per buffer in the
+/// cooperative pool). Hence the cost is negligible when not
+/// collecting.
+struct thread_stats {
+  uint64_t mers;          // k-mers parsed
+  uint64_t adds;          // k-mers passed to the hash (not filtered out)
+  uint64_t reprobes;      // Reprobes while claiming a key in the hash
+  uint64_t cas_failures;  // Failed compare and swap in the hash
+  uint64_t barrier_waits; // Waits on the size barrier of the hash
+  uint64_t barrier_ns;    // Time waiting on the size barrier
+  uint64_t barrier_parks; // Waits which blocked after spinning
+  uint64_t produce_calls; // Elements produced in the cooperative pool
+  uint64_t produce_ns;    // Time producing (reading and parsing input)
+  uint64_t consume_calls; // Elements obtained from the cooperative pool
+  uint64_t consume_ns;    // Time waiting for elements, not producing
+  uint64_t total_ns;      // Time of the thread
+  char     padding_[64];  // Keep the counters of two threads on different cache lines
+
+  thread_stats() { clear(); }
+  void clear() {
+    mers = adds = reprobes = cas_failures = 0;
+    barrier_waits = barrier_ns = barrier_parks = produce_calls = produce_ns = 0;
+    consume_calls = consume_ns = total_ns = 0;
+  }
+
+  thread_stats& operator+=(const thread_stats& rhs) {
+    mers          += rhs.mers;
+    adds          += rhs.adds;
+    reprobes      += rhs.reprobes;
+    cas_failures  += rhs.cas_failures;
+    barrier_waits += rhs.barrier_waits;
+    barrier_ns    += rhs.barrier_ns;
+    barrier_parks += rhs.barrier_parks;
+    produce_calls += rhs.produce_calls;
+    produce_ns    += rhs.produce_ns;
+    consume_calls += rhs.consume_calls;
+    consume_ns    += rhs.consume_ns;
+    total_ns      += rhs.total_ns;
+    return *this;
+  }
+
+  static thread_stats*& current() {
+    static __thread thread_stats* stats = 0;
+    return stats;
+  }
+
+  static uint64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+  /// Set the thread_stats of the current thread for the lifetime of
+  /// the object, and add the time elapsed to its total_ns. Does
+  /// nothing if stats is null.
+  class scope {
+    thread_stats* prev_;
+    uint64_t      start_;
+  public:
+    explicit scope(thread_stats* stats) : prev_(current()), start_(stats ? now_ns() : 0) {
+      current() = stats;
+    }
+    ~scope() {
+      if(current())
+        current()->total_ns += now_ns() - start_;
+      current() = prev_;
+    }
+  };
+
+  /// Add the time elapsed during the lifetime of the object to the
+  /// field `Field` of the thread_stats of the current thread, if any.
+  template<uint64_t thread_stats::*Field>
+  class timer {
+    thread_stats* stats_;
+    uint64_t      start_;
+  public:
+    timer() : stats_(current()), start_(stats_ ? now_ns() : 0) { }
+    ~timer() {
+      if(stats_)
+        stats_->*Field += now_ns() - start_;
+    }
+  };
+
+  /// Increment the counter `Field` of the current thread, if any.
+  template<uint64_t thread_stats::*Field>
+  static void incr(uint64_t x = 1) {
+    thread_stats* stats = current();
+    if(stats)
+      stats->*Field += x;
+  }
+};
+} // namespace jellyfish
+
+#endif /* __JELLYFISH_THREAD_STATS_HPP__ */
@@ -80,6 +80,7 @@ class Time {
     return Time() - *this;
   }
 
+  double seconds() const { return tv.tv_sec + tv.tv_usec / (double)max_useconds; }
 
   std::string str() const {
     std::ostringstream res;
@@ -25,13 +25,17 @@ template<class cond_t = locks::pthread::cond>
 class token_ring {
 public:
   class token {
-    bool   val;
-    cond_t cond;
-    token* next;
+    volatile bool val;
+    cond_t        cond;
+    token*        next;
     friend class token_ring;
 
   public:
+    /// Wait for the token. Spin a while, as the token is often passed
+    /// quickly, before blocking.
     void wait() {
+      if(locks::pthread::spin_until([this]() { return val; }))
+        return;
       cond.lock();
       while(!val) { cond.wait(); }
       cond.unlock();
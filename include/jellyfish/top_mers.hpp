@@ -0,0 +1,138 @@
+/*  This file is part of Jellyfish.
+
+    Jellyfish is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Jellyfish is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Jellyfish.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __JELLYFISH_TOP_MERS_HPP__
+#define __JELLYFISH_TOP_MERS_HPP__
+
+#include <stdint.h>
+#include <vector>
+#include <utility>
+#include <ostream>
+#include <algorithm>
+#include <limits>
+
+#include <jellyfish/thread_exec.hpp>
+
+namespace jellyfish {
+/// Keep the n k-mers with the highest counts. Ties are broken by the
+/// k-mers, smallest first, so the result does not depend on the order
+/// of insertion. The k-mers are kept in a bounded heap whose head is
+/// the worst of the n k-mers. Memory usage is O(n).
+template<typename Key, typename Val>
+class top_mers {
+public:
+  typedef std::pair<Key, Val> element_type;
+
+private:
+  size_t                    n_;
+  std::vector<element_type> heap_;
+
+  // True if a ranks before b. The heap is a max heap for this order,
+  // hence its head is the last.
+  struct before {
+    bool operator()(const element_type& a, const element_type& b) const {
+      return a.second > b.second || (a.second == b.second && a.first < b.first);
+    }
+  };
+
+public:
+  explicit top_mers(size_t n = 0) : n_(n) { heap_.reserve(n); }
+
+  size_t capacity() const { return n_; }
+  size_t size() const { return heap_.size(); }
+
+  void add(const Key& key, const Val& val) {
+    if(n_ == 0) return;
+    if(heap_.size() < n_) {
+      heap_.push_back(std::make_pair(key, val));
+      std::push_heap(heap_.begin(), heap_.end(), before());
+      return;
+    }
+    const element_type& last = heap_.front();
+    if(val < last.second || (val == last.second && !(key < last.first)))
+      return;
+    std::pop_heap(heap_.begin(), heap_.end(), before());
+    heap_.back().first  = key;
+    heap_.back().second = val;
+    std::push_heap(heap_.begin(), heap_.end(), before());
+  }
+
+  /// Add the k-mers kept by rhs
+  top_mers& operator+=(const top_mers& rhs) {
+    for(auto it = rhs.heap_.cbegin(); it != rhs.heap_.cend(); ++it)
+      add(it->first, it->second);
+    return *this;
+  }
+
+  /// The k-mers kept, highest count first
+  std::vector<element_type> sorted() const {
+    std::vector<element_type> res(heap_);
+    std::sort(res.begin(), res.end(), before());
+    return res;
+  }
+
+  /// Write the k-mers kept, highest count first, in column format
+  void write(std::ostream& os, char spacer = ' ') const {
+    const std::vector<element_type> res = sorted();
+    for(auto it = res.cbegin(); it != res.cend(); ++it)
+      os << it->first << spacer << it->second << "\n";
+  }
+};
+
+/// Find the k-mers with the highest counts in a hash, in
+/// parallel. Each thread keeps its own top_mers over a slice of the
+/// hash, and they are added at the end. Only the k-mers with a count
+/// in [min, max] are considered.
+template<typename storage_t>
+class top_mers_computer : public thread_exec {
+  typedef typename storage_t::lazy_iterator iterator;
+  typedef typename storage_t::key_type      key_type;
+
+public:
+  typedef jellyfish::top_mers<key_type, uint64_t> top_type;
+
+private:
+  const storage_t&      ary_;
+  const int             nb_threads_;
+  const uint64_t        min_, max_;
+  std::vector<top_type> tops_;
+
+public:
+  top_mers_computer(const storage_t& ary, int nb_threads, size_t n, uint64_t min = 0,
+                    uint64_t max = std::numeric_limits<uint64_t>::max()) :
+    ary_(ary), nb_threads_(nb_threads), min_(min), max_(max), tops_(nb_threads, top_type(n))
+  { }
+
+  virtual void start(int thid) {
+    top_type& top = tops_[thid];
+    iterator  it  = ary_.template iterator_slice<iterator>(thid, nb_threads_);
+    while(it.next()) {
+      const uint64_t val = it.val();
+      if(val >= min_ && val <= max_)
+        top.add(it.key(), val);
+    }
+  }
+
+  /// Compute the top k-mers and add them to res
+  void compute(top_type& res) {
+    exec_join(nb_threads_);
+    for(auto it = tops_.cbegin(); it != tops_.cend(); ++it)
+      res += *it;
+  }
+};
+} // namespace jellyfish
+
+#endif /* __JELLYFISH_TOP_MERS_HPP__ */
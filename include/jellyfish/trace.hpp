@@ -0,0 +1,167 @@
+/*  This file is part of Jellyfish.
+
+    Jellyfish is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Jellyfish is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Jellyfish.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __JELLYFISH_TRACE_HPP__
+#define __JELLYFISH_TRACE_HPP__
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdint.h>
+#include <vector>
+#include <string>
+#include <memory>
+#include <chrono>
+#include <ostream>
+
+#include <jellyfish/err.hpp>
+
+// Static probes (USDT), for perf, bpftrace or systemtap. Every span
+// fires jellyfish:span__begin and jellyfish:span__end with its name
+// as argument, whether or not a trace is recorded. They are no-ops
+// unless a tracer is attached.
+#ifdef HAVE_SYS_SDT_H
+#include <sys/sdt.h>
+#define JELLYFISH_PROBE1(name, arg) DTRACE_PROBE1(jellyfish, name, arg)
+#else
+#define JELLYFISH_PROBE1(name, arg)
+#endif
+
+namespace jellyfish {
+/// Timeline of the phases of a command (thread, producer turn, hash
+/// doubling, dump, etc.), written in the Chrome trace-event format,
+/// readable by chrome://tracing or Perfetto.
+///
+/// Spans are recorded in per-thread ring buffers, without locking,
+/// only while a trace object exists. When a buffer is full, the
+/// oldest events are overwritten. The trace is written when the
+/// trace object is destroyed, and there must be no span recording at
+/// that time (i.e. all the worker threads are joined).
+class trace {
+public:
+  struct event {
+    const char* name; // Static string
+    uint64_t    begin_ns;
+    uint64_t    end_ns;
+  };
+
+  class buffer {
+    std::vector<event> events_;
+    uint64_t           nb_;  // Total number of events recorded
+    const int          tid_;
+
+  public:
+    buffer(size_t capacity, int tid) : events_(capacity), nb_(0), tid_(tid) { }
+    void record(const char* name, uint64_t begin_ns, uint64_t end_ns) {
+      event& e   = events_[nb_++ % events_.size()];
+      e.name     = name;
+      e.begin_ns = begin_ns;
+      e.end_ns   = end_ns;
+    }
+    int tid() const { return tid_; }
+    uint64_t recorded() const { return nb_; }
+    uint64_t dropped() const { return nb_ > events_.size() ? nb_ - events_.size() : 0; }
+    // The events kept, oldest first
+    template<typename F>
+    void for_each(F f) const {
+      for(uint64_t i = dropped(); i < nb_; ++i)
+        f(events_[i % events_.size()]);
+    }
+  };
+
+  static const size_t default_capacity = 1 << 16;
+
+private:
+  const std::string                    path_;
+  const std::string                    command_;
+  const size_t                         capacity_;
+  const uint64_t                       generation_;
+  const uint64_t                       start_ns_;
+  std::vector<std::unique_ptr<buffer> > buffers_;
+
+  static trace*& active() {
+    static trace* t = 0;
+    return t;
+  }
+  static trace* get() { return __atomic_load_n(&active(), __ATOMIC_ACQUIRE); }
+
+  buffer& thread_buffer() {
+    static __thread buffer*  buf = 0;
+    static __thread uint64_t gen = 0;
+    if(gen != generation_) {
+      buf = new_buffer();
+      gen = generation_;
+    }
+    return *buf;
+  }
+  buffer* new_buffer(); // Thread safe
+
+public:
+  define_error_class(Error);
+
+  trace(const char* path, const char* command, size_t capacity = default_capacity);
+  ~trace();
+
+  static bool enabled() { return get() != 0; }
+  static uint64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+  /// Record an event for the current thread, if a trace is active.
+  static void record(const char* name, uint64_t begin_ns, uint64_t end_ns) {
+    trace* t = get();
+    if(t)
+      t->thread_buffer().record(name, begin_ns, end_ns);
+  }
+
+  /// Write the events recorded so far in the Chrome trace-event
+  /// (JSON) format.
+  void write(std::ostream& os) const;
+
+  /// Record the lifetime of the object as an event named `name`,
+  /// which must be a static string.
+  class span {
+    const char* const name_;
+    const uint64_t    start_;
+  public:
+    explicit span(const char* name) : name_(name), start_(enabled() ? now_ns() : 0) {
+      JELLYFISH_PROBE1(span__begin, name);
+    }
+    ~span() {
+      JELLYFISH_PROBE1(span__end, name_);
+      if(start_)
+        record(name_, start_, now_ns());
+    }
+  };
+};
+
+/// The trace requested by the switch --trace of a subcommand, or null
+/// if none is requested. Dies on error.
+template<typename Args>
+trace* make_trace(const char* command, const Args& args) {
+  if(!args.trace_given)
+    return 0;
+  try {
+    return new trace(args.trace_arg, command);
+  } catch(trace::Error& e) {
+    err::die(err::msg() << e.what());
+  }
+  return 0;
+}
+} // namespace jellyfish
+
+#endif /* __JELLYFISH_TRACE_HPP__ */
@@ -7,6 +7,7 @@
 #include <jellyfish/err.hpp>
 #include <jellyfish/cooperative_pool2.hpp>
 #include <jellyfish/cpp_array.hpp>
+#include <jellyfish/progress.hpp>
 
 namespace jellyfish {
 struct header_sequence_qual {
@@ -113,6 +114,7 @@ protected:
   void read_fasta(stream_status& st, sequence_list& buff) {
     size_t&      nb_filled = buff.nb_filled;
     const size_t data_size = buff.data.size();
+    size_t       bases     = 0;
 
     for(nb_filled = 0; nb_filled < data_size && st.stream->peek() != EOF; ++nb_filled) {
       ++reads_read_;
@@ -124,12 +126,15 @@ protected:
         std::getline(*st.stream, st.buffer); // Wish there was an easy way to combine the
         fill_buff.seq.append(st.buffer);             // two lines avoiding copying
       }
+      bases += fill_buff.seq.size();
     }
+    progress::add(progress::INPUT_BASES, bases);
   }
 
   void read_fastq(stream_status& st, sequence_list& buff) {
     size_t&      nb_filled = buff.nb_filled;
     const size_t data_size = buff.data.size();
+    size_t       bases     = 0;
 
     for(nb_filled = 0; nb_filled < data_size && st.stream->peek() != EOF; ++nb_filled) {
       ++reads_read_;
@@ -153,7 +158,9 @@ protected:
         throw std::runtime_error("Invalid fastq file: wrong number of quals");
       if(st.stream->peek() != EOF && st.stream->peek() != '@')
         throw std::runtime_error("Invalid fastq file: header missing");
+      bases += fill_buff.seq.size();
     }
+    progress::add(progress::INPUT_BASES, bases);
   }
 };
 } // namespace jellyfish
@@ -0,0 +1,358 @@
+/*  This file is part of Jellyfish.
+
+    Jellyfish is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Jellyfish is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Jellyfish.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <unistd.h>
+#include <stdint.h>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <limits>
+#include <algorithm>
+
+#include <jellyfish/err.hpp>
+#include <jellyfish/misc.hpp>
+#include <jellyfish/json.h>
+#include <jellyfish/thread_exec.hpp>
+#include <jellyfish/mapped_file.hpp>
+#include <jellyfish/file_header.hpp>
+#include <jellyfish/stream_manager.hpp>
+#include <jellyfish/mer_overlap_sequence_parser.hpp>
+#include <jellyfish/mer_iterator.hpp>
+#include <jellyfish/mer_dna_bloom_counter.hpp>
+#include <jellyfish/jellyfish.hpp>
+#include <jellyfish/merge_files.hpp>
+#include <jellyfish/bench_cmdline.hpp>
+
+namespace err = jellyfish::err;
+
+using std::chrono::system_clock;
+using std::chrono::duration;
+using std::chrono::duration_cast;
+
+template<typename DtnType>
+inline double as_seconds(DtnType dtn) { return duration_cast<duration<double>>(dtn).count(); }
+
+using jellyfish::mer_dna;
+typedef std::vector<const char*> file_vector;
+typedef jellyfish::mer_overlap_sequence_parser<jellyfish::stream_manager<file_vector::const_iterator> > sequence_parser;
+typedef jellyfish::mer_iterator<sequence_parser, mer_dna> mer_iterator;
+
+static bench_args args;
+
+// Collect the results as JSON. A benchmark is run only if its name
+// contains one of the --bench strings (or if none is given).
+class bench_results {
+  Json::Value root_;
+
+public:
+  bench_results() {
+    root_["mer_len"]  = args.mer_len_arg;
+    root_["items"]    = (Json::UInt64)args.items_arg;
+    root_["threads"]  = args.threads_arg;
+    root_["benchmarks"] = Json::Value(Json::arrayValue);
+  }
+
+  static bool enabled(const std::string& name) {
+    if(args.bench_arg.empty()) return true;
+    for(auto it = args.bench_arg.cbegin(); it != args.bench_arg.cend(); ++it)
+      if(name.find(*it) != std::string::npos) return true;
+    return false;
+  }
+
+  void add(const std::string& name, uint64_t items, double seconds) {
+    Json::Value res;
+    res["name"]             = name;
+    res["items"]            = (Json::UInt64)items;
+    res["seconds"]          = seconds;
+    res["items_per_second"] = seconds > 0 ? items / seconds : 0.0;
+    std::cerr << name << ": " << res["items_per_second"].asDouble() << " items/s\n";
+    root_["benchmarks"].append(res);
+  }
+
+  void write(std::ostream& os) const {
+    Json::StyledStreamWriter writer("  ");
+    writer.write(os, root_);
+  }
+};
+
+// Run the benchmark fn() if enabled, time it and add it to the results
+template<typename Fn>
+void run(bench_results& res, const std::string& name, uint64_t items, Fn fn) {
+  if(!bench_results::enabled(name)) return;
+  const auto start = system_clock::now();
+  fn();
+  res.add(name, items, as_seconds(system_clock::now() - start));
+}
+
+// Name of a benchmark with parameters
+struct bench_name {
+  std::ostringstream os;
+  explicit bench_name(const char* name) { os << name; }
+  template<typename T>
+  bench_name& operator()(const char* param, const T& val) { os << '/' << param << '=' << val; return *this; }
+  operator std::string() const { return os.str(); }
+};
+
+// Keep the compiler from optimizing away the computation of a value
+static volatile uint64_t sink;
+
+std::string tmp_path(const char* name) {
+  std::ostringstream res;
+  res << args.tmp_dir_arg << "/bench_" << getpid() << "_" << name;
+  return res.str();
+}
+
+// A fasta file with a random sequence containing nb_mers k-mers
+std::string random_fasta(size_t nb_mers) {
+  static const char letters[4] = { 'A', 'C', 'G', 'T' };
+  const std::string path = tmp_path("seq.fa");
+  std::ofstream     out(path.c_str());
+  out << ">bench\n";
+  const size_t len = nb_mers + mer_dna::k() - 1;
+  for(size_t i = 0; i < len; i += 32) {
+    uint64_t bits = jellyfish::random_bits();
+    for(size_t j = i; j < len && j < i + 32; ++j, bits >>= 2)
+      out << letters[bits & 0x3];
+    if(i % 2048 == 2016)
+      out << '\n';
+  }
+  out << '\n';
+  if(!out.good())
+    err::die(err::msg() << "Failed to write temporary file '" << path << "'");
+  return path;
+}
+
+void bench_mer_iterator(bench_results& res) {
+  if(!bench_results::enabled("mer_iterator")) return;
+  const size_t        n    = args.items_arg;
+  const std::string   path = random_fasta(n);
+  const file_vector   files(1, path.c_str());
+  for(int canonical = 0; canonical < 2; ++canonical) {
+    run(res, bench_name("mer_iterator")("canonical", canonical), n, [&]() {
+        jellyfish::stream_manager<file_vector::const_iterator> streams(files.cbegin(), files.cend());
+        sequence_parser parser(mer_dna::k(), streams.nb_streams(), 3, 4096, streams);
+        uint64_t        acc = 0;
+        for(mer_iterator mers(parser, canonical); mers; ++mers)
+          acc += mers->word(0);
+        sink = acc;
+      });
+  }
+  unlink(path.c_str());
+}
+
+void bench_matrix_times(bench_results& res, const std::vector<mer_dna>& keys) {
+  jellyfish::RectangularBinaryMatrix m(64, 2 * mer_dna::k());
+  m.randomize(jellyfish::random_bits);
+  run(res, bench_name("matrix_times")("backend", "loop"), keys.size(), [&]() {
+      uint64_t acc = 0;
+      for(auto it = keys.cbegin(); it != keys.cend(); ++it)
+        acc ^= m.times_loop(*it);
+      sink = acc;
+    });
+#ifdef HAVE_SSE
+  run(res, bench_name("matrix_times")("backend", "sse"), keys.size(), [&]() {
+      uint64_t acc = 0;
+      for(auto it = keys.cbegin(); it != keys.cend(); ++it)
+        acc ^= m.times_sse(*it);
+      sink = acc;
+    });
+#endif
+#ifdef HAVE_INT128
+  run(res, bench_name("matrix_times")("backend", "int128"), keys.size(), [&]() {
+      uint64_t acc = 0;
+      for(auto it = keys.cbegin(); it != keys.cend(); ++it)
+        acc ^= m.times_128(*it);
+      sink = acc;
+    });
+#endif
+  if(2 * mer_dna::k() <= 64) {
+    // Shape of the hash of a large hash array holding the keys: the
+    // hash has fewer bits than the keys.
+    const unsigned int r = std::min((unsigned int)jellyfish::ceilLog2(keys.size()), 2 * mer_dna::k());
+    const jellyfish::invertible_hash h = jellyfish::invertible_hash::xorshift_mul(r, 2 * mer_dna::k(), jellyfish::random_bits());
+    run(res, bench_name("matrix_times")("backend", "xorshift_mul"), keys.size(), [&]() {
+        uint64_t acc = 0;
+        for(auto it = keys.cbegin(); it != keys.cend(); ++it)
+          acc ^= h.times(*it);
+        sink = acc;
+      });
+  }
+}
+
+// Each thread adds its share of the keys to the hash
+class hash_adder : public jellyfish::thread_exec {
+  mer_array&                  ary_;
+  const std::vector<mer_dna>& keys_;
+  const size_t                nb_keys_, nb_adds_;
+  const int                   nb_threads_;
+
+public:
+  hash_adder(mer_array& ary, const std::vector<mer_dna>& keys, size_t nb_keys, size_t nb_adds, int nb_threads) :
+    ary_(ary), keys_(keys), nb_keys_(nb_keys), nb_adds_(nb_adds), nb_threads_(nb_threads)
+  { }
+
+  virtual void start(int thid) {
+    for(size_t i = thid; i < nb_adds_; i += nb_threads_)
+      ary_.add(keys_[i % nb_keys_], 1);
+  }
+};
+
+// Add the first nb_keys keys to the hash. Then time adding them again,
+// nb_adds times in total, at this load. The hash is no larger than the
+// number of keys so that every load is reached. The name records the
+// actual load.
+void bench_hash_add(bench_results& res, const std::vector<mer_dna>& keys) {
+  const size_t  size     = (size_t)1 << jellyfish::floorLog2(keys.size());
+  const double  loads[]  = { 0.25, 0.5, 0.75, 0.9 };
+  for(const double load : loads) {
+    const size_t nb_keys = (size_t)(load * size);
+    for(unsigned int t = 1; t <= args.threads_arg; t *= 2) {
+      const std::string name = bench_name("hash_add")("load", (double)nb_keys / size)("threads", t);
+      if(!bench_results::enabled(name)) continue;
+      mer_array ary(size, 2 * mer_dna::k(), 7, 126);
+      hash_adder(ary, keys, nb_keys, nb_keys, 1).exec_join(1);
+      hash_adder adder(ary, keys, nb_keys, args.items_arg, t);
+      run(res, name, args.items_arg, [&]() { adder.exec_join(t); });
+    }
+  }
+}
+
+template<typename BloomCounter>
+void bench_bloom_counter(bench_results& res, const char* name, const std::vector<mer_dna>& keys) {
+  BloomCounter bc(0.01, keys.size());
+  run(res, bench_name(name)("op", "insert"), keys.size(), [&]() {
+      for(auto it = keys.cbegin(); it != keys.cend(); ++it)
+        bc.insert(*it);
+    });
+  run(res, bench_name(name)("op", "check"), keys.size(), [&]() {
+      uint64_t acc = 0;
+      for(auto it = keys.cbegin(); it != keys.cend(); ++it)
+        acc += bc.check(*it);
+      sink = acc;
+    });
+}
+
+// Dump the keys in [first, last) to path, from a hash of the given
+// size and hash matrix. Databases are mergeable only if they have the
+// same size and matrix.
+void dump_keys(const std::string& path, std::vector<mer_dna>::const_iterator first,
+               std::vector<mer_dna>::const_iterator last, size_t size,
+               const jellyfish::RectangularBinaryMatrix& matrix) {
+  mer_array ary(size, 2 * mer_dna::k(), 7, 126, matrix);
+  for( ; first != last; ++first)
+    ary.add(*first, 1);
+  jellyfish::file_header header;
+  binary_dumper          dumper(4, ary.key_len(), 1, path.c_str(), &header);
+  dumper.one_file(true);
+  dumper.dump(&ary);
+}
+
+void bench_dump_query_merge(bench_results& res, const std::vector<mer_dna>& keys) {
+  const size_t      n     = keys.size();
+  const std::string path1 = tmp_path("dump1.jf");
+  const std::string path2 = tmp_path("dump2.jf");
+  const std::string path3 = tmp_path("merged.jf");
+
+  // Time the dump only, not the filling of the hash
+  for(unsigned int t = 1; t <= args.threads_arg; t *= 2) {
+    const std::string name = bench_name("sorted_dumper")("threads", t);
+    if(!bench_results::enabled(name)) continue;
+    mer_array ary((size_t)1 << jellyfish::ceilLog2(2 * n), 2 * mer_dna::k(), 7, 126);
+    for(auto it = keys.cbegin(); it != keys.cend(); ++it)
+      ary.add(*it, 1);
+    jellyfish::file_header header;
+    binary_dumper          dumper(4, ary.key_len(), t, path1.c_str(), &header);
+    dumper.one_file(true);
+    run(res, name, n, [&]() { dumper.dump(&ary); });
+  }
+
+  const bool query = bench_results::enabled("binary_query");
+  const bool merge = bench_results::enabled("merge");
+  if(!query && !merge) return;
+  const size_t size = (size_t)1 << jellyfish::ceilLog2(2 * n);
+  const jellyfish::RectangularBinaryMatrix matrix =
+    jellyfish::RectangularBinaryMatrix(jellyfish::ceilLog2(size), 2 * mer_dna::k()).randomize_pseudo_inverse();
+  dump_keys(path1, keys.cbegin(), keys.cbegin() + n / 2 + n / 4, size, matrix);
+  dump_keys(path2, keys.cbegin() + n / 4, keys.cend(), size, matrix);
+
+  if(query) {
+    std::ifstream in(path1.c_str());
+    jellyfish::file_header header(in);
+    in.close();
+    jellyfish::mapped_file map(path1.c_str());
+    map.load();
+    binary_query bq(map.base() + header.offset(), header.key_len(), header.counter_len(), header.hash_function(),
+                    header.size() - 1, map.length() - header.offset());
+    // The database has the keys [0, 3n/4): 75% of the queries are hits
+    run(res, "binary_query", n, [&]() {
+        uint64_t acc = 0;
+        for(auto it = keys.cbegin(); it != keys.cend(); ++it)
+          acc += bq.check(*it);
+        sink = acc;
+      });
+  }
+
+  if(merge) {
+    const file_vector      files = { path1.c_str(), path2.c_str() };
+    jellyfish::file_header header;
+    run(res, "merge", n + n / 2, [&]() {
+        try {
+          merge_files(files, path3.c_str(), header, 0, std::numeric_limits<uint64_t>::max());
+        } catch(MergeError& e) {
+          err::die(err::msg() << e.what());
+        }
+      });
+    unlink(path3.c_str());
+  }
+  unlink(path1.c_str());
+  unlink(path2.c_str());
+}
+
+int main(int argc, char *argv[])
+{
+  args.parse(argc, argv);
+  if(args.threads_arg < 1)
+    bench_args::error("The number of threads must be at least 1");
+  if(args.items_arg < 8)
+    bench_args::error("The number of items must be at least 8");
+  mer_dna::k(args.mer_len_arg);
+
+  std::ofstream out;
+  if(args.output_given) {
+    out.open(args.output_arg);
+    if(!out.good())
+      err::die(err::msg() << "Failed to open output file '" << args.output_arg << "'");
+  }
+
+  std::vector<mer_dna> keys(args.items_arg);
+  for(auto it = keys.begin(); it != keys.end(); ++it)
+    it->randomize();
+
+  bench_results res;
+  bench_mer_iterator(res);
+  bench_matrix_times(res, keys);
+  bench_hash_add(res, keys);
+  bench_bloom_counter<jellyfish::mer_dna_bloom_counter>(res, "bloom_counter2", keys);
+  bench_bloom_counter<jellyfish::mer_dna_blocked_bloom_counter>(res, "bloom_counter2_blocked", keys);
+  bench_bloom_counter<jellyfish::mer_dna_cuckoo_filter>(res, "cuckoo_filter", keys);
+  bench_dump_query_merge(res, keys);
+
+  res.write(args.output_given ? out : std::cout);
+  return 0;
+}
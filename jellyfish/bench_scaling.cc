@@ -0,0 +1,330 @@
+/*  This file is part of Jellyfish.
+
+    Jellyfish is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Jellyfish is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Jellyfish.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <chrono>
+#include <algorithm>
+
+#include <jellyfish/err.hpp>
+#include <jellyfish/json.h>
+#include <jellyfish/bench_scaling_cmdline.hpp>
+
+namespace err = jellyfish::err;
+
+using std::chrono::system_clock;
+using std::chrono::duration;
+using std::chrono::duration_cast;
+
+template<typename DtnType>
+inline double as_seconds(DtnType dtn) { return duration_cast<duration<double>>(dtn).count(); }
+
+static bench_scaling_args args;
+
+// Resource usage of one command
+struct run_stats {
+  double   wall_seconds;
+  double   cpu_seconds;
+  long     max_rss_kb;
+  uint64_t bytes_read;
+  uint64_t bytes_written;
+};
+
+inline double tv_seconds(const struct timeval& tv) { return tv.tv_sec + tv.tv_usec / 1e6; }
+
+// Read the I/O counters of a process. They are still available while
+// it is a zombie. They stay at 0 where /proc is not available.
+static void read_proc_io(pid_t pid, run_stats& stats) {
+  std::ostringstream path;
+  path << "/proc/" << pid << "/io";
+  std::ifstream is(path.str().c_str());
+  std::string   field;
+  uint64_t      val;
+  while(is >> field >> val) {
+    if(field == "rchar:") stats.bytes_read = val;
+    else if(field == "wchar:") stats.bytes_written = val;
+  }
+}
+
+// Run a command to completion, its standard output discarded. Die if
+// it fails.
+static run_stats run_command(const std::vector<std::string>& cmd) {
+  std::vector<char*> argv;
+  for(auto it = cmd.cbegin(); it != cmd.cend(); ++it)
+    argv.push_back(const_cast<char*>(it->c_str()));
+  argv.push_back(0);
+
+  run_stats  stats = { 0.0, 0.0, 0, 0, 0 };
+  const auto start = system_clock::now();
+  const pid_t pid  = fork();
+  if(pid == -1)
+    err::die(err::msg() << "Fork failed: " << err::no);
+  if(pid == 0) {
+    const int fd = open("/dev/null", O_WRONLY);
+    if(fd != -1) dup2(fd, 1);
+    execv(argv[0], argv.data());
+    std::cerr << "Failed to exec '" << argv[0] << "': " << strerror(errno) << std::endl;
+    _exit(127);
+  }
+
+  siginfo_t info;
+  if(waitid(P_PID, pid, &info, WEXITED | WNOWAIT) == -1)
+    err::die(err::msg() << "Wait failed: " << err::no);
+  stats.wall_seconds = as_seconds(system_clock::now() - start);
+  read_proc_io(pid, stats);
+
+  int           status;
+  struct rusage usage;
+  if(wait4(pid, &status, 0, &usage) == -1)
+    err::die(err::msg() << "Wait failed: " << err::no);
+  if(!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+    std::ostringstream line;
+    for(auto it = cmd.cbegin(); it != cmd.cend(); ++it)
+      line << (it == cmd.cbegin() ? "" : " ") << *it;
+    err::die(err::msg() << "Command failed: " << line.str());
+  }
+  stats.cpu_seconds = tv_seconds(usage.ru_utime) + tv_seconds(usage.ru_stime);
+  stats.max_rss_kb  = usage.ru_maxrss;
+  return stats;
+}
+
+// Path to a program installed next to this one, unless given
+static std::string program_path(const char* given, const char* argv0, const char* name) {
+  if(given) return given;
+  const std::string self(argv0);
+  const size_t      slash = self.rfind('/');
+  return (slash == std::string::npos ? std::string(".") : self.substr(0, slash)) + "/" + name;
+}
+
+template<typename T>
+static std::string to_string(const T& x) {
+  std::ostringstream os;
+  os << x;
+  return os.str();
+}
+
+class scaling_bench {
+  const std::string jellyfish_;
+  const std::string generate_sequence_;
+  const std::string prefix_;
+  Json::Value       root_;
+
+  std::string path(const std::string& name) const { return prefix_ + name; }
+
+  std::vector<std::string> jf(const char* subcmd) const {
+    return std::vector<std::string>({ jellyfish_, subcmd });
+  }
+
+  // Run a command --repeat times, keep the fastest and add it to the
+  // results.
+  void record(const char* command, const Json::Value& params, const std::vector<std::string>& cmd) {
+    run_stats best = run_command(cmd);
+    for(uint32_t i = 1; i < args.repeat_arg; ++i) {
+      const run_stats stats = run_command(cmd);
+      if(stats.wall_seconds < best.wall_seconds)
+        best = stats;
+    }
+
+    Json::Value res;
+    std::ostringstream name;
+    name << command;
+    for(auto it = params.begin(); it != params.end(); ++it)
+      name << '/' << it.key().asString() << '=' << (*it).asUInt64();
+    res["name"]          = name.str();
+    res["command"]       = command;
+    res["params"]        = params;
+    res["wall_seconds"]  = best.wall_seconds;
+    res["cpu_seconds"]   = best.cpu_seconds;
+    res["max_rss_kb"]    = (Json::Int64)best.max_rss_kb;
+    res["bytes_read"]    = (Json::UInt64)best.bytes_read;
+    res["bytes_written"] = (Json::UInt64)best.bytes_written;
+    std::cerr << res["name"].asString() << ": " << best.wall_seconds << " s wall, "
+              << best.cpu_seconds << " s cpu, " << best.max_rss_kb << " kB rss\n";
+    root_["runs"].append(res);
+  }
+
+  // Reads sampled from a random genome in two files of about equal
+  // size. Return the paths of the two files.
+  std::vector<std::string> generate(uint64_t input_size) {
+    const std::string prefix = path("seq_" + to_string(input_size));
+    const uint64_t    genome = std::max((uint64_t)args.read_length_arg,
+                                        (uint64_t)(input_size / args.coverage_arg));
+    run_command({ generate_sequence_, "-q", "-s", to_string(args.seed_arg), "-g", to_string(genome),
+          "-e", to_string(args.error_rate_arg), "-r", to_string(args.read_length_arg),
+          "-o", prefix, to_string(input_size / 2), to_string(input_size - input_size / 2) });
+    return std::vector<std::string>({ prefix + "_0.fq", prefix + "_1.fq" });
+  }
+
+public:
+  scaling_bench(const std::string& jellyfish, const std::string& generate_sequence) :
+    jellyfish_(jellyfish), generate_sequence_(generate_sequence),
+    prefix_(std::string(args.tmp_dir_arg) + "/bench_scaling_" + to_string(getpid()) + "_")
+  {
+    root_["jellyfish"]   = jellyfish_;
+    root_["mer_len"]     = args.mer_len_arg;
+    root_["coverage"]    = args.coverage_arg;
+    root_["error_rate"]  = args.error_rate_arg;
+    root_["read_length"] = args.read_length_arg;
+    root_["seed"]        = (Json::Int64)args.seed_arg;
+    root_["nb_cpus"]     = (Json::Int64)sysconf(_SC_NPROCESSORS_ONLN);
+    root_["runs"]        = Json::Value(Json::arrayValue);
+  }
+
+  void run() {
+    const std::string mer_len = to_string(args.mer_len_arg);
+    const std::string all     = path("all.jf");
+    const std::string parts[2] = { path("part0.jf"), path("part1.jf") };
+    const std::string merged  = path("merged.jf");
+    const std::string output  = path("output");
+
+    for(auto input = args.input_size_arg.cbegin(); input != args.input_size_arg.cend(); ++input) {
+      const std::vector<std::string> files = generate(*input);
+      for(auto size = args.size_arg.cbegin(); size != args.size_arg.cend(); ++size) {
+        for(auto cl = args.counter_len_arg.cbegin(); cl != args.counter_len_arg.cend(); ++cl) {
+          for(auto th = args.threads_arg.cbegin(); th != args.threads_arg.cend(); ++th) {
+            Json::Value params;
+            params["input_size"]  = (Json::UInt64)*input;
+            params["size"]        = (Json::UInt64)*size;
+            params["counter_len"] = *cl;
+            params["threads"]     = *th;
+            const std::string s = to_string(*size), c = to_string(*cl), t = to_string(*th);
+
+            std::vector<std::string> count = jf("count");
+            count.insert(count.end(), { "-C", "-m", mer_len, "-s", s, "-c", c, "-t", t, "-o", all });
+            count.insert(count.end(), files.begin(), files.end());
+            record("count", params, count);
+
+            record("histo", params, { jellyfish_, "histo", "-t", t, "-o", output, all });
+            record("query", params, { jellyfish_, "query", "-t", t, "-s", files[0], "-o", output, all });
+
+            // Merge needs parts of the same size and hash function: no
+            // doubling, a full hash is dumped to disk instead.
+            for(int i = 0; i < 2; ++i)
+              run_command({ jellyfish_, "count", "-C", "-m", mer_len, "-s", s, "-c", c, "-t", t,
+                    "--disk", "-o", parts[i], files[i] });
+            record("merge", params, { jellyfish_, "merge", "-o", merged, parts[0], parts[1] });
+
+            for(const std::string& p : { all, parts[0], parts[1], merged, output })
+              unlink(p.c_str());
+          }
+        }
+      }
+      for(auto it = files.cbegin(); it != files.cend(); ++it)
+        unlink(it->c_str());
+    }
+  }
+
+  void write(std::ostream& os) const {
+    Json::StyledStreamWriter writer("  ");
+    writer.write(os, root_);
+  }
+};
+
+static Json::Value read_results(const char* path) {
+  std::ifstream is(path);
+  if(!is.good())
+    err::die(err::msg() << "Failed to open '" << path << "'");
+  Json::Value  root;
+  Json::Reader reader;
+  if(!reader.parse(is, root) || !root["runs"].isArray())
+    err::die(err::msg() << "Invalid results file '" << path << "'");
+  return root;
+}
+
+// Compare the runs of current to the runs of the same name in
+// baseline. Return the number of regressions.
+static int compare(const Json::Value& baseline, const Json::Value& current, double threshold) {
+  static const char* metrics[] = { "wall_seconds", "cpu_seconds", "max_rss_kb" };
+
+  std::map<std::string, Json::Value> base_runs;
+  for(auto it = baseline["runs"].begin(); it != baseline["runs"].end(); ++it)
+    base_runs[(*it)["name"].asString()] = *it;
+
+  int nb_regressions = 0;
+  for(auto it = current["runs"].begin(); it != current["runs"].end(); ++it) {
+    const std::string name = (*it)["name"].asString();
+    auto base = base_runs.find(name);
+    if(base == base_runs.end()) {
+      std::cout << name << ": not in baseline\n";
+      continue;
+    }
+    for(const char* metric : metrics) {
+      const double old_val = base->second[metric].asDouble();
+      const double new_val = (*it)[metric].asDouble();
+      if(old_val <= 0) continue;
+      const double change     = new_val / old_val - 1;
+      const bool   regression = change > threshold;
+      nb_regressions += regression;
+      std::cout << name << " " << metric << " " << old_val << " " << new_val << " "
+                << (change >= 0 ? "+" : "") << (100 * change) << "%"
+                << (regression ? " REGRESSION" : "") << "\n";
+    }
+  }
+  return nb_regressions;
+}
+
+int main(int argc, char *argv[])
+{
+  args.parse(argc, argv);
+
+  if(args.compare_flag) {
+    if(args.file_arg.size() != 2)
+      bench_scaling_args::error("--compare requires a baseline and a current results file");
+    const int nb = compare(read_results(args.file_arg[0]), read_results(args.file_arg[1]),
+                           args.threshold_arg);
+    if(nb > 0)
+      std::cout << nb << " regression(s) beyond " << (100 * args.threshold_arg) << "%\n";
+    return nb > 0 ? 1 : 0;
+  }
+
+  if(!args.file_arg.empty())
+    bench_scaling_args::error("Files are only accepted with --compare");
+  if(args.input_size_arg.empty()) args.input_size_arg.push_back(10000000);
+  if(args.threads_arg.empty()) args.threads_arg.push_back(1);
+  if(args.size_arg.empty()) args.size_arg.push_back(1000000);
+  if(args.counter_len_arg.empty()) args.counter_len_arg.push_back(7);
+  if(args.coverage_arg <= 0)
+    bench_scaling_args::error("The coverage must be positive");
+  if(args.repeat_arg < 1)
+    bench_scaling_args::error("The number of repeats must be at least 1");
+
+  std::ofstream out;
+  if(args.output_given) {
+    out.open(args.output_arg);
+    if(!out.good())
+      err::die(err::msg() << "Failed to open output file '" << args.output_arg << "'");
+  }
+
+  scaling_bench bench(program_path(args.jellyfish_arg, argv[0], "jellyfish"),
+                      program_path(args.generate_sequence_arg, argv[0], "generate_sequence"));
+  bench.run();
+  bench.write(args.output_given ? out : std::cout);
+  return 0;
+}
@@ -15,7 +15,10 @@
 */
 
 #include <stdlib.h>
+#include <string>
 #include <vector>
+#include <algorithm>
+#include <memory>
 #include <iostream>
 #include <fstream>
 
@@ -99,6 +102,14 @@ void create_path(char *path, unsigned int path_size, const char *ext, bool many,
 
 generate_sequence_args args;
 
+// Length of the reads: as given, else 70 bases for fastq and for
+// reads sampled from a genome, the whole sequence for fasta.
+size_t read_length(size_t length) {
+  if(args.read_length_given)
+    return args.read_length_arg;
+  return args.fastq_flag || args.genome_size_given ? 70 : length;
+}
+
 void output_fastq(size_t length, const char* path, CRandomMersenne& rng) {
   rDNAg_t rDNAg(&rng);
   std::ofstream fd(path);
@@ -107,15 +118,16 @@ void output_fastq(size_t length, const char* path, CRandomMersenne& rng) {
   if(args.verbose_flag)
     std::cout << "Creating fastq file '" << path << "'\n";
 
+  const size_t  read_len  = read_length(length);
   size_t        total_len = 0;
   unsigned long read_id   = 0;
   while(total_len < length) {
     fd << "@read_" << (read_id++) << "\n";
-    int base;
-    for(base = 0; base < 70 && total_len < length; base++, total_len++)
+    size_t base;
+    for(base = 0; base < read_len && total_len < length; base++, total_len++)
       fd << rDNAg.letter();
     fd << "\n+\n";
-    for(int j = 0; j < base; j++)
+    for(size_t j = 0; j < base; j++)
       fd << rDNAg.qual_Illumina();
     fd << "\n";
   }
@@ -132,20 +144,20 @@ void output_fasta(size_t length, const char* path, CRandomMersenne& rng) {
   if(args.verbose_flag)
     std::cout << "Creating fasta file '" << path << "'\n";
 
-  size_t read_length = args.read_length_given ? args.read_length_arg : length;
-  size_t total_len   = 0;
-  size_t read        = 0;
-  long   rid         = 0;
+  const size_t read_len  = read_length(length);
+  size_t       total_len = 0;
+  size_t       read      = 0;
+  long         rid       = 0;
   fd << ">read" << ++rid << "\n";
   while(total_len < length) {
-    for(int base = 0; base < 70 && total_len < length && read < read_length;
+    for(int base = 0; base < 70 && total_len < length && read < read_len;
         base++) {
       fd << rDNAg.letter();
       total_len++;
       read++;
     }
     fd << "\n";
-    if(read >= read_length) {
+    if(read >= read_len) {
       fd << ">read" << ++rid << "\n";
       read = 0;
     }
@@ -155,6 +167,78 @@ void output_fasta(size_t length, const char* path, CRandomMersenne& rng) {
   fd.close();
 }
 
+// A random genome to sample reads from, on either strand and with
+// substitution errors. The erroneous bases get the lowest quality.
+class genome_sampler {
+  CRandomMersenne& rng;
+  std::string      genome;
+  const double     error_rate;
+
+  static int code(char base) {
+    switch(base) {
+    case 'A': return 0;
+    case 'C': return 1;
+    case 'G': return 2;
+    default:  return 3;
+    }
+  }
+  static const char letters[4];
+
+public:
+  genome_sampler(size_t size, double error_rate_, CRandomMersenne& rng_) :
+    rng(rng_), genome(size, 'A'), error_rate(error_rate_)
+  {
+    rDNAg_t rDNAg(&rng);
+    for(size_t i = 0; i < size; ++i)
+      genome[i] = rDNAg.letter();
+  }
+
+  size_t size() const { return genome.size(); }
+
+  void sample(size_t len, std::string& seq, std::string& qual) {
+    const uint64_t r   = ((uint64_t)rng.BRandom() << 32) | rng.BRandom();
+    const size_t   pos = r % (genome.size() - len + 1);
+    const bool     rev = rng.BRandom() & 1;
+    seq.resize(len);
+    qual.resize(len);
+    for(size_t i = 0; i < len; ++i) {
+      int c = rev ? 3 - code(genome[pos + len - 1 - i]) : code(genome[pos + i]);
+      qual[i] = rng.IRandom(66, 104);
+      if(error_rate > 0 && rng.Random() < error_rate) {
+        c       = (c + rng.IRandom(1, 3)) & 0x3;
+        qual[i] = 66;
+      }
+      seq[i] = letters[c];
+    }
+  }
+};
+const char genome_sampler::letters[4] = { 'A', 'C', 'G', 'T' };
+
+void output_reads(size_t length, const char* path, genome_sampler& genome) {
+  std::ofstream fd(path);
+  if(!fd.good())
+    die(err::msg() << "Can't open read file '" << path << "': " << jellyfish::err::no);
+  if(args.verbose_flag)
+    std::cout << "Creating read file '" << path << "'\n";
+
+  const size_t  read_len  = read_length(length);
+  std::string   seq, qual;
+  size_t        total_len = 0;
+  unsigned long read_id   = 0;
+  while(total_len < length) {
+    const size_t len = std::min(read_len, length - total_len);
+    genome.sample(len, seq, qual);
+    if(args.fastq_flag)
+      fd << "@read_" << read_id++ << "\n" << seq << "\n+\n" << qual << "\n";
+    else
+      fd << ">read_" << read_id++ << "\n" << seq << "\n";
+    total_len += len;
+  }
+  if(!fd.good())
+    die(err::msg() << "Error while writing read file '" << path << "': " << jellyfish::err::no);
+  fd.close();
+}
+
 int main(int argc, char *argv[])
 {
   args.parse(argc, argv);
@@ -163,13 +247,29 @@ int main(int argc, char *argv[])
     std::cout << "Seed: " << args.seed_arg << "\n";
   CRandomMersenne rng(args.seed_arg);
 
+  if(args.read_length_given && args.read_length_arg == 0)
+    die(err::msg() << "Read length must be positive");
+
+  // Reads sampled from a genome have a k-mer spectrum peaked at the
+  // coverage, plus the erroneous k-mers.
+  std::unique_ptr<genome_sampler> genome;
+  if(args.genome_size_given) {
+    if(args.error_rate_arg < 0 || args.error_rate_arg > 1)
+      die(err::msg() << "Error rate (" << args.error_rate_arg << ") must be between 0 and 1");
+    if(args.genome_size_arg < read_length(0)) // Never the whole sequence here
+      die(err::msg() << "Genome size (" << args.genome_size_arg << ") must be at least the read length (" << read_length(0) << ")");
+    genome.reset(new genome_sampler(args.genome_size_arg, args.error_rate_arg, rng));
+  }
 
   // Output sequence
   char path[4096];
   bool many = args.length_arg.size() > 1;
 
   for(unsigned int i = 0; i < args.length_arg.size(); ++i) {
-    if(args.fastq_flag) {
+    if(genome) {
+      create_path(path, sizeof(path), args.fastq_flag ? "fq" : "fa", many, i, args.output_arg);
+      output_reads(args.length_arg[i], path, *genome);
+    } else if(args.fastq_flag) {
       create_path(path, sizeof(path), "fq", many, i, args.output_arg);
       output_fastq(args.length_arg[i], path, rng);
     } else {
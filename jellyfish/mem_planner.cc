@@ -0,0 +1,155 @@
+/*  This file is part of Jellyfish.
+
+    Jellyfish is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Jellyfish is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Jellyfish.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+#include <iomanip>
+
+#include <jellyfish/mer_dna.hpp>
+#include <jellyfish/large_hash_array.hpp>
+#include <jellyfish/mer_dna_bloom_counter.hpp>
+#include <jellyfish/mem_planner.hpp>
+
+namespace {
+typedef jellyfish::large_hash::array<jellyfish::mer_dna> mer_array;
+
+// Code, libraries, stacks and small allocations of the program
+const uint64_t program_bytes             = 4 << 20;
+// Sequence parsers of count and bc: 3 buffers per thread
+const uint64_t parser_buffers_per_thread = 3;
+const uint64_t parser_buffer_bytes       = 4096;
+// The parser with quality values keeps 100 reads per buffer. Estimate
+// of a read (header, sequence and qualities) of a few hundred bases.
+const uint64_t qual_reads_per_buffer     = 100;
+const uint64_t qual_read_bytes           = 1024;
+// The sorted dumper keeps a heap of max reprobe offset entries and
+// buffers about 5 times as many records, in each thread.
+const uint64_t dump_records_factor       = 5;
+const uint64_t heap_item_bytes           = sizeof(jellyfish::mer_dna) + 4 * sizeof(uint64_t);
+
+void add_input(mem_plan& plan, uint32_t threads, uint32_t files, uint32_t mer_len, bool qual) {
+  if(qual) {
+    plan.add("parser buffers", threads * parser_buffers_per_thread * qual_reads_per_buffer * qual_read_bytes);
+  } else {
+    plan.add("parser buffers", threads * parser_buffers_per_thread * parser_buffer_bytes);
+    plan.add("seam buffers", (uint64_t)files * (mer_len - 1));
+  }
+  plan.add("input streams", (uint64_t)files * BUFSIZ);
+  plan.add("program", program_bytes);
+}
+} // namespace
+
+uint64_t mem_plan::total() const {
+  uint64_t res = 0;
+  for(auto it = items_.cbegin(); it != items_.cend(); ++it)
+    res += it->bytes;
+  return res;
+}
+
+void mem_plan::print(std::ostream& os) const {
+  for(auto it = items_.cbegin(); it != items_.cend(); ++it)
+    os << "  " << std::left << std::setw(20) << it->name << std::right << std::setw(16) << it->bytes
+       << " (" << mem_with_suffix(it->bytes) << ")\n";
+  os << "  " << std::left << std::setw(20) << "total" << std::right << std::setw(16) << total()
+     << " (" << mem_with_suffix(total()) << ")\n";
+}
+
+std::string mem_with_suffix(uint64_t x) {
+  static const char* suffixes = "kMGTPE";
+  const int          max_i    = strlen(suffixes);
+  int                i        = 0;
+  while(x >= 1024 && i < max_i) {
+    x /= 1024;
+    ++i;
+  }
+  std::ostringstream res;
+  res << x;
+  if(i > 0)
+    res << suffixes[i - 1];
+  return res.str();
+}
+
+mem_plan count_mem_plan(const count_mem_params& p, uint64_t size) {
+  mem_plan             plan;
+  mer_array::usage_info usage(p.mer_len * 2, p.counter_len, p.reprobes);
+  plan.add("hash", usage.mem(size));
+  if(p.doubling)
+    plan.add("hash doubling", usage.mem(2 * usage.asize(size)));
+  if(p.bf_size)
+    plan.add("bloom filter", jellyfish::mer_dna_bloom_filter::mem(p.bf_fp, p.bf_size));
+  if(p.bc_bytes)
+    plan.add("bloom counter", p.bc_bytes);
+  add_input(plan, p.threads, p.files, p.mer_len, p.qual);
+
+  const jellyfish::large_hash::reprobe_limit_t limit(p.reprobes, jellyfish::quadratic_reprobes, usage.asize(size));
+  const uint64_t max_offset = jellyfish::quadratic_reprobes[limit.val()];
+  const uint64_t record     = p.text
+    ? p.mer_len + 12                              // k-mer, space, count and new line
+    : (p.mer_len * 2 + 7) / 8 + p.out_counter_len;
+  plan.add("dump buffers", p.threads * max_offset * (dump_records_factor * record + heap_item_bytes));
+  return plan;
+}
+
+uint64_t count_max_size(const count_mem_params& p, uint64_t budget) {
+  uint64_t res = 0;
+  for(int i = 0; i < 56; ++i) {
+    const uint64_t size = (uint64_t)1 << i;
+    if(count_mem_plan(p, size).total() > budget)
+      break;
+    res = size;
+  }
+  return res;
+}
+
+mem_plan bc_mem_plan(const bc_mem_params& p, uint64_t size) {
+  mem_plan plan;
+  switch(p.variant) {
+  case bc_mem_params::STANDARD:
+    plan.add("bloom counter", jellyfish::mer_dna_bloom_counter::mem(p.fpr, size));
+    break;
+  case bc_mem_params::BLOCKED:
+    plan.add("bloom counter", jellyfish::mer_dna_blocked_bloom_counter::mem(p.fpr, size));
+    break;
+  case bc_mem_params::COUNT_MIN:
+    plan.add("count-min sketch", jellyfish::mer_dna_count_min_sketch::mem(p.fpr, size, p.bits));
+    break;
+  case bc_mem_params::CUCKOO:
+    plan.add("cuckoo filter", p.like_bytes ? p.like_bytes : jellyfish::mer_dna_cuckoo_filter::mem(p.fpr, size));
+    break;
+  }
+  add_input(plan, p.threads, p.files, p.mer_len, false);
+  return plan;
+}
+
+uint64_t bc_max_size(const bc_mem_params& p, uint64_t budget) {
+  if(bc_mem_plan(p, 1).total() > budget)
+    return 0;
+  // The memory grows with the size: double then bisect
+  uint64_t low = 1, high = 2;
+  while(high < ((uint64_t)1 << 56) && bc_mem_plan(p, high).total() <= budget) {
+    low   = high;
+    high *= 2;
+  }
+  while(high - low > 1) {
+    const uint64_t mid = low + (high - low) / 2;
+    if(bc_mem_plan(p, mid).total() <= budget)
+      low = mid;
+    else
+      high = mid;
+  }
+  return low;
+}
@@ -0,0 +1,133 @@
+/*  This file is part of Jellyfish.
+
+    Jellyfish is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Jellyfish is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Jellyfish.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __JELLYFISH_MEM_PLANNER_HPP__
+#define __JELLYFISH_MEM_PLANNER_HPP__
+
+#include <stdint.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include <string>
+#include <vector>
+#include <ostream>
+
+/// Breakdown of the peak memory of a command, allocation by
+/// allocation.
+class mem_plan {
+public:
+  struct item {
+    std::string name;
+    uint64_t    bytes;
+  };
+
+  void add(const std::string& name, uint64_t bytes) {
+    item i = { name, bytes };
+    items_.push_back(i);
+  }
+  const std::vector<item>& items() const { return items_; }
+  uint64_t total() const;
+
+  /// Write one line per allocation and the total
+  void print(std::ostream& os) const;
+
+private:
+  std::vector<item> items_;
+};
+
+/// Number with a binary suffix (k, M, G, etc.)
+std::string mem_with_suffix(uint64_t x);
+
+/// Size of a file, 0 if it does not exist
+inline uint64_t mem_file_size(const char* path) {
+  struct stat st;
+  return stat(path, &st) == -1 ? 0 : st.st_size;
+}
+
+/// The switches of count which change its memory usage. The mem
+/// subcommand accepts the same switches.
+struct count_mem_params {
+  uint32_t mer_len;
+  uint32_t counter_len;
+  uint32_t out_counter_len;
+  uint32_t reprobes;
+  uint32_t threads;
+  uint32_t files;     // Files open simultaneously
+  bool     qual;      // Parse the quality values (-Q)
+  bool     doubling;  // Double the size of the hash when full (not --disk)
+  bool     text;      // Dump in text format
+  uint64_t bf_size;   // Elements in the bloom filter (--bf-size), 0 if none
+  double   bf_fp;
+  uint64_t bc_bytes;  // Size of the bloom counter file (--bc), 0 if none
+
+  template<typename Args>
+  explicit count_mem_params(const Args& args) :
+    mer_len(args.mer_len_arg),
+    counter_len(args.counter_len_arg),
+    out_counter_len(args.out_counter_len_arg),
+    reprobes(args.reprobes_arg),
+    threads(args.threads_arg),
+    files(args.Files_arg),
+    qual(args.min_qual_char_given),
+    doubling(!args.disk_flag),
+    text(args.text_flag),
+    bf_size(args.bf_size_given ? args.bf_size_arg : 0),
+    bf_fp(args.bf_fp_arg),
+    bc_bytes(args.bc_given ? mem_file_size(args.bc_arg) : 0)
+  { }
+};
+
+/// Plan of count with an initial hash of `size` entries. If the size
+/// of the hash is doubled, the new hash of twice the size is
+/// allocated while the current one is still in use: the plan
+/// includes it.
+mem_plan count_mem_plan(const count_mem_params& p, uint64_t size);
+
+/// Largest size (a power of 2) of the hash for which the plan of
+/// count fits in `budget` bytes. 0 if none fits.
+uint64_t count_max_size(const count_mem_params& p, uint64_t budget);
+
+/// The switches of bc which change its memory usage.
+struct bc_mem_params {
+  enum variant_type { STANDARD, BLOCKED, COUNT_MIN, CUCKOO };
+  uint32_t     mer_len;
+  uint32_t     threads;
+  uint32_t     files;
+  variant_type variant;
+  uint32_t     bits;       // Bits per cell of the count-min sketch
+  double       fpr;
+  uint64_t     like_bytes; // Size of the filter given to --like, 0 if none
+
+  template<typename Args>
+  explicit bc_mem_params(const Args& args) :
+    mer_len(args.mer_len_arg),
+    threads(args.threads_arg),
+    files(args.Files_arg),
+    variant(args.bits_given ? COUNT_MIN : (args.cuckoo_flag ? CUCKOO : (args.blocked_flag ? BLOCKED : STANDARD))),
+    bits(args.bits_given ? args.bits_arg : 0),
+    fpr(args.fpr_arg),
+    like_bytes(args.like_given ? mem_file_size(args.like_arg) : 0)
+  { }
+};
+
+/// Plan of bc for `size` expected k-mers
+mem_plan bc_mem_plan(const bc_mem_params& p, uint64_t size);
+
+/// Largest number of expected k-mers for which the plan of bc fits in
+/// `budget` bytes. 0 if none fits.
+uint64_t bc_max_size(const bc_mem_params& p, uint64_t budget);
+
+#endif /* __JELLYFISH_MEM_PLANNER_HPP__ */
@@ -26,13 +26,15 @@
 #include <jellyfish/misc.hpp>
 #include <jellyfish/mer_heap.hpp>
 #include <jellyfish/jellyfish.hpp>
-#include <jellyfish/rectangular_binary_matrix.hpp>
+#include <jellyfish/invertible_hash.hpp>
 #include <jellyfish/cpp_array.hpp>
+#include <jellyfish/progress.hpp>
+#include <jellyfish/trace.hpp>
 
 namespace err = jellyfish::err;
 
 using jellyfish::file_header;
-using jellyfish::RectangularBinaryMatrix;
+using jellyfish::invertible_hash;
 using jellyfish::mer_dna;
 using jellyfish::cpp_array;
 typedef std::auto_ptr<binary_reader> binary_reader_ptr;
@@ -47,11 +49,13 @@ struct file_info {
   header(is)
   { }
 };
-typedef std::auto_ptr<RectangularBinaryMatrix> matrix_ptr;
+typedef std::auto_ptr<invertible_hash> hash_function_ptr;
 
 template<typename reader_type, typename writer_type>
-void do_merge(cpp_array<file_info>& files, std::ostream& out, writer_type& writer,
-              uint64_t min, uint64_t max) {
+void do_merge(cpp_array<file_info>& files, std::ostream* out, writer_type& writer,
+              uint64_t min, uint64_t max, jellyfish::spectrum* spectrum,
+              jellyfish::top_mers<mer_dna, uint64_t>* top) {
+  jellyfish::trace::span span("merge");
   cpp_array<reader_type> readers(files.size());
   typedef jellyfish::mer_heap::heap<mer_dna, reader_type> heap_type;
   typedef typename heap_type::const_item_t heap_item;
@@ -63,6 +67,8 @@ void do_merge(cpp_array<file_info>& files, std::ostream& out, writer_type& write
       heap.push(readers[i]);
   }
 
+  jellyfish::progress_batch read_progress(jellyfish::progress::RECORDS_READ);
+  jellyfish::progress_batch written_progress(jellyfish::progress::RECORDS_WRITTEN);
   heap_item head = heap.head();
   mer_dna   key;
   while(heap.is_not_empty()) {
@@ -70,13 +76,21 @@ void do_merge(cpp_array<file_info>& files, std::ostream& out, writer_type& write
     uint64_t sum = 0;
     do {
       sum += head->val_;
+      ++read_progress;
       heap.pop();
       if(head->it_->next())
         heap.push(*head->it_);
       head = heap.head();
     } while(head->key_ == key && heap.is_not_empty());
-    if(sum >= min && sum <= max)
-      writer.write(out, key, sum);
+    if(sum < min || sum > max) continue;
+    if(spectrum)
+      spectrum->add(sum);
+    if(top)
+      top->add(key, sum);
+    if(out) {
+      writer.write(*out, key, sum);
+      ++written_progress;
+    }
   }
 }
 
@@ -84,13 +98,15 @@ void do_merge(cpp_array<file_info>& files, std::ostream& out, writer_type& write
 void merge_files(std::vector<const char*> input_files,
                  const char* out_file,
                  file_header& out_header,
-                 uint64_t min, uint64_t max) {
-  unsigned int key_len            = 0;
-  size_t       max_reprobe_offset = 0;
-  size_t       size               = 0;
-  unsigned int out_counter_len    = std::numeric_limits<unsigned int>::max();
-  std::string  format;
-  matrix_ptr   matrix;
+                 uint64_t min, uint64_t max,
+                 jellyfish::spectrum* spectrum,
+                 jellyfish::top_mers<mer_dna, uint64_t>* top) {
+  unsigned int      key_len            = 0;
+  size_t            max_reprobe_offset = 0;
+  size_t            size               = 0;
+  unsigned int      out_counter_len    = std::numeric_limits<unsigned int>::max();
+  std::string       format;
+  hash_function_ptr hash_function;
 
   cpp_array<file_info> files(input_files.size());
 
@@ -105,11 +121,11 @@ void merge_files(std::vector<const char*> input_files,
       key_len            = h.key_len();
       max_reprobe_offset = h.max_reprobe_offset();
       size               = h.size();
-      matrix.reset(new RectangularBinaryMatrix(h.matrix()));
+      hash_function.reset(new invertible_hash(h.hash_function()));
       out_header.size(size);
       out_header.key_len(key_len);
       format = h.format();
-      out_header.matrix(*matrix);
+      out_header.hash_function(*hash_function);
       out_header.max_reprobe(h.max_reprobe());
       size_t reprobes[h.max_reprobe() + 1];
       h.get_reprobes(reprobes);
@@ -124,28 +140,30 @@ void merge_files(std::vector<const char*> input_files,
         throw MergeError("Can't merge hashes with different reprobing strategies");
       if(h.size() != size)
         throw MergeError(err::msg() << "Can't merge hash with different size (" << size << ", " << h.size() << ")");
-      if(h.matrix() != *matrix)
+      if(h.hash_function() != *hash_function)
         throw MergeError("Can't merge hash with different hash function");
     }
   }
   mer_dna::k(key_len / 2);
 
-  std::ofstream out(out_file);
-  if(!out.good())
-    throw MergeError(err::msg() << "Can't open out file '" << out_file << "'");
+  std::unique_ptr<std::ofstream> out;
+  if(out_file) {
+    out.reset(new std::ofstream(out_file));
+    if(!out->good())
+      throw MergeError(err::msg() << "Can't open out file '" << out_file << "'");
+  }
   out_header.format(format);
 
   if(!format.compare(binary_dumper::format)) {
     out_header.counter_len(out_counter_len);
-    out_header.write(out);
+    if(out) out_header.write(*out);
     binary_writer writer(out_counter_len, key_len);
-    do_merge<binary_reader, binary_writer>(files, out, writer, min, max);
+    do_merge<binary_reader, binary_writer>(files, out.get(), writer, min, max, spectrum, top);
   } else if(!format.compare(text_dumper::format)) {
-    out_header.write(out);
+    if(out) out_header.write(*out);
     text_writer writer;
-    do_merge<text_reader, text_writer>(files, out, writer, min, max);
+    do_merge<text_reader, text_writer>(files, out.get(), writer, min, max, spectrum, top);
   } else {
     throw MergeError(err::msg() << "Unknown format '" << format << "'");
   }
-  out.close();
 }
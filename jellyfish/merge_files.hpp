@@ -20,11 +20,19 @@
 #include <vector>
 #include <jellyfish/err.hpp>
 #include <jellyfish/file_header.hpp>
+#include <jellyfish/spectrum.hpp>
+#include <jellyfish/top_mers.hpp>
+#include <jellyfish/mer_dna.hpp>
 
 define_error_class(MergeError);
 
-/// Merge files. Throw a MergeError in case of error.
+/// Merge files. Throw a MergeError in case of error. If out_file is
+/// NULL, nothing is written. If spectrum is not NULL, the merged
+/// counts are added to it. If top is not NULL, the merged k-mers are
+/// added to it.
 void merge_files(std::vector<const char*> input_files, const char* out_file,
-                 jellyfish::file_header& h, uint64_t min, uint64_t max);
+                 jellyfish::file_header& h, uint64_t min, uint64_t max,
+                 jellyfish::spectrum* spectrum = 0,
+                 jellyfish::top_mers<jellyfish::mer_dna, uint64_t>* top = 0);
 
 #endif /* __JELLYFISH_MERGE_FILES_HPP__ */
@@ -0,0 +1,465 @@
+/*  This file is part of Jellyfish.
+
+    Jellyfish is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Jellyfish is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Jellyfish.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+
+#include <string.h>
+
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+
+#include <jellyfish/jellyfish_c.h>
+#include <jellyfish/mer_dna.hpp>
+#include <jellyfish/hash_counter.hpp>
+#include <jellyfish/binary_dumper.hpp>
+#include <jellyfish/file_header.hpp>
+#include <jellyfish/mapped_file.hpp>
+#include <jellyfish/thread_exec.hpp>
+#include <jellyfish/locks_pthread.hpp>
+
+namespace {
+__thread char last_error[1024];
+
+void set_error(const char* msg) {
+  strncpy(last_error, msg, sizeof(last_error) - 1);
+  last_error[sizeof(last_error) - 1] = '\0';
+}
+
+// Call f() and return its result. On exception, set the error of the
+// thread and return error_value.
+template<typename R, typename F>
+R guard(R error_value, F f) {
+  try {
+    return f();
+  } catch(std::exception& e) {
+    set_error(e.what());
+  } catch(...) {
+    set_error("Unknown error");
+  }
+  return error_value;
+}
+
+// The k-mer length of a mer_base_static is a static variable of its
+// class. The handles use the classes of index 1 to
+// JELLYFISH_MAX_K_VALUES (the slots), not mer_dna (index 0). A slot is
+// shared by the handles with the same k, and its k is set when the
+// first of these handles is created.
+template<int S>
+using slot_mer = jellyfish::mer_dna_ns::mer_base_static<uint64_t, S + 1>;
+
+struct slot_info {
+  unsigned int k;
+  unsigned int users;
+};
+slot_info                        slots[JELLYFISH_MAX_K_VALUES];
+jellyfish::locks::pthread::mutex slots_mutex;
+
+template<int S>
+void set_slot_k(unsigned int k) { slot_mer<S>::k(k); }
+void (* const set_slot_ks[JELLYFISH_MAX_K_VALUES])(unsigned int) = {
+  set_slot_k<0>, set_slot_k<1>, set_slot_k<2>, set_slot_k<3>
+};
+
+// A slot with k-mer length k, held for the lifetime of the object
+class k_slot {
+  int slot_;
+
+public:
+  explicit k_slot(unsigned int k) : slot_(-1) {
+    if(k == 0)
+      throw std::invalid_argument("The k-mer length must be positive");
+    jellyfish::locks::pthread::mutex_lock lock(slots_mutex);
+    for(int i = 0; i < JELLYFISH_MAX_K_VALUES; ++i) {
+      if(slots[i].users > 0 && slots[i].k == k) {
+        slot_ = i;
+        break;
+      }
+      if(slots[i].users == 0 && slot_ == -1)
+        slot_ = i;
+    }
+    if(slot_ == -1)
+      throw std::runtime_error("Too many different k-mer lengths in use");
+    if(slots[slot_].users++ == 0) {
+      slots[slot_].k = k;
+      set_slot_ks[slot_](k);
+    }
+  }
+  ~k_slot() {
+    jellyfish::locks::pthread::mutex_lock lock(slots_mutex);
+    --slots[slot_].users;
+  }
+  int operator()() const { return slot_; }
+};
+
+// Call f(m, i) for every k-mer m of the sequence without a character
+// other than ACGT, where i is the position of the k-mer in the
+// sequence. Any other character, newlines included, breaks the k-mers
+// as an N does: the positions are those of the buffer. Same rule as
+// string_mers::for_each of the SWIG bindings. If canonical is true, m
+// is the canonical representation of the k-mer.
+template<typename mer_type, typename F>
+void for_each_mer(const char* seq, size_t len, bool canonical, F f) {
+  const unsigned int k = mer_type::k();
+  mer_type           m, rc;
+  unsigned int       filled = 0;
+  for(size_t i = 0; i < len; ++i) {
+    const int code = mer_type::code(seq[i]);
+    if(code < 0) {
+      filled = 0;
+      continue;
+    }
+    m.shift_left(code);
+    if(canonical)
+      rc.shift_right(mer_type::complement(code));
+    if(++filled >= k)
+      f(canonical && rc < m ? rc : m, i + 1 - k);
+  }
+}
+
+size_t nb_positions(unsigned int k, size_t len) {
+  return len >= k ? len - k + 1 : 0;
+}
+
+// Counts of every k-mer of the sequences, with threads threads taking
+// the next sequence in turn. count(m, tmp) gives the count of the k-mer
+// m, where tmp is a k-mer private to the thread.
+template<typename mer_type, typename Count>
+class query_all : public jellyfish::thread_exec {
+  const char* const* const seqs_;
+  const size_t* const      lens_;
+  const size_t             nb_;
+  const bool               canonical_;
+  uint64_t* const          counts_;
+  const Count&             count_;
+  std::vector<uint64_t*>   outs_;
+  size_t                   next_;
+
+public:
+  query_all(const char* const* seqs, const size_t* lens, size_t nb, bool canonical, uint64_t* counts,
+            const Count& count) :
+    seqs_(seqs), lens_(lens), nb_(nb), canonical_(canonical), counts_(counts), count_(count), outs_(nb), next_(0)
+  {
+    uint64_t* out = counts;
+    for(size_t i = 0; i < nb; ++i) {
+      outs_[i]  = out;
+      out      += nb_positions(mer_type::k(), lens[i]);
+    }
+  }
+
+  virtual void start(int thid) {
+    mer_type tmp;
+    for(size_t i = __sync_fetch_and_add(&next_, 1); i < nb_; i = __sync_fetch_and_add(&next_, 1)) {
+      uint64_t* const out = outs_[i];
+      std::fill(out, out + nb_positions(mer_type::k(), lens_[i]), (uint64_t)0);
+      for_each_mer<mer_type>(seqs_[i], lens_[i], canonical_, [&](const mer_type& m, size_t pos) {
+          out[pos] = count_(m, tmp);
+        });
+    }
+  }
+
+  void run(unsigned int threads) {
+    if(threads > 1 && nb_ > 1)
+      exec_join(std::min((size_t)threads, nb_));
+    else
+      start(0);
+  }
+};
+
+template<typename mer_type, typename Count>
+void query_sequences(const char* const* seqs, const size_t* lens, size_t nb, bool canonical, unsigned int threads,
+                     uint64_t* counts, const Count& count) {
+  query_all<mer_type, Count> all(seqs, lens, nb, canonical, counts, count);
+  all.run(threads);
+}
+
+struct counter_engine {
+  virtual ~counter_engine() { }
+  virtual uint64_t size() const = 0;
+  virtual uint64_t add(const char* const* seqs, const size_t* lens, size_t nb) = 0;
+  virtual void query(const char* const* seqs, const size_t* lens, size_t nb, unsigned int threads,
+                     uint64_t* counts) const = 0;
+  virtual void dump(const char* path, unsigned int out_counter_len, uint64_t lower, uint64_t upper) = 0;
+};
+
+template<int S>
+class counter : public counter_engine {
+  typedef slot_mer<S> mer_type;
+
+  class hash_type : public jellyfish::cooperative::hash_counter<mer_type> {
+    typedef jellyfish::cooperative::hash_counter<mer_type> super;
+  public:
+    hash_type(uint64_t size, unsigned int counter_len, unsigned int threads) :
+      super(size, mer_type::k() * 2, counter_len, threads)
+    { }
+    // Ready for the next batch, after all threads are done
+    void reset_done() { super::done_threads_ = 0; }
+  };
+
+  // Add the k-mers of the sequences. The threads of the hash take the
+  // next sequence in turn.
+  class adder : public jellyfish::thread_exec {
+    hash_type&                       hash_;
+    const char* const* const         seqs_;
+    const size_t* const              lens_;
+    const size_t                     nb_;
+    const bool                       canonical_;
+    size_t                           next_;
+    uint64_t                         added_;
+    jellyfish::locks::pthread::mutex error_mutex_;
+    std::string                      error_;
+
+  public:
+    adder(hash_type& hash, const char* const* seqs, const size_t* lens, size_t nb, bool canonical) :
+      hash_(hash), seqs_(seqs), lens_(lens), nb_(nb), canonical_(canonical), next_(0), added_(0)
+    { }
+    uint64_t added() const { return added_; }
+    const std::string& error() const { return error_; }
+
+    virtual void start(int thid) {
+      uint64_t added = 0;
+      try {
+        for(size_t i = __sync_fetch_and_add(&next_, 1); i < nb_; i = __sync_fetch_and_add(&next_, 1)) {
+          for_each_mer<mer_type>(seqs_[i], lens_[i], canonical_, [&](const mer_type& m, size_t pos) {
+              hash_.add(m, 1);
+              ++added;
+            });
+        }
+        hash_.done();
+      } catch(std::exception& e) { // Thrown by all the threads at the barrier
+        jellyfish::locks::pthread::mutex_lock lock(error_mutex_);
+        error_ = e.what();
+      }
+      __sync_fetch_and_add(&added_, added);
+    }
+  };
+
+  hash_type          hash_;
+  const unsigned int threads_;
+  const bool         canonical_;
+
+public:
+  counter(uint64_t size, unsigned int counter_len, unsigned int threads, bool canonical) :
+    hash_(size, counter_len, threads),
+    threads_(threads),
+    canonical_(canonical)
+  { }
+
+  virtual uint64_t size() const { return hash_.size(); }
+
+  virtual uint64_t add(const char* const* seqs, const size_t* lens, size_t nb) {
+    adder a(hash_, seqs, lens, nb, canonical_);
+    a.exec_join(threads_);
+    hash_.reset_done();
+    if(!a.error().empty())
+      throw std::runtime_error(a.error());
+    return a.added();
+  }
+
+  virtual void query(const char* const* seqs, const size_t* lens, size_t nb, unsigned int threads,
+                     uint64_t* counts) const {
+    const typename hash_type::array* ary = hash_.ary();
+    query_sequences<mer_type>(seqs, lens, nb, canonical_, threads, counts, [ary](const mer_type& m, mer_type& tmp) {
+        uint64_t val;
+        size_t   id;
+        return ary->get_val_for_key(m, &val, tmp, &id) ? val : (uint64_t)0;
+      });
+  }
+
+  virtual void dump(const char* path, unsigned int out_counter_len, uint64_t lower, uint64_t upper) {
+    jellyfish::file_header header;
+    header.fill_standard();
+    header.canonical(canonical_);
+    jellyfish::binary_dumper<typename hash_type::array> dumper(out_counter_len, hash_.key_len(), threads_, path, &header);
+    dumper.one_file(true);
+    dumper.zero_array(false);
+    dumper.min(lower);
+    dumper.max(upper);
+    dumper.dump(hash_.ary());
+  }
+};
+
+template<int S>
+counter_engine* new_counter(uint64_t size, unsigned int counter_len, unsigned int threads, bool canonical) {
+  return new counter<S>(size, counter_len, threads, canonical);
+}
+counter_engine* (* const new_counters[JELLYFISH_MAX_K_VALUES])(uint64_t, unsigned int, unsigned int, bool) = {
+  new_counter<0>, new_counter<1>, new_counter<2>, new_counter<3>
+};
+
+struct db_engine {
+  virtual ~db_engine() { }
+  virtual uint64_t size() const = 0;
+  virtual void query(const char* const* seqs, const size_t* lens, size_t nb, unsigned int threads,
+                     uint64_t* counts) const = 0;
+};
+
+template<int S>
+class db : public db_engine {
+  typedef slot_mer<S>                                      mer_type;
+  typedef jellyfish::binary_query_base<mer_type, uint64_t> query_type;
+
+  jellyfish::mapped_file      map_;
+  std::unique_ptr<query_type> query_; // Null if the database is empty
+  const bool                  canonical_;
+  const uint64_t              size_;
+
+public:
+  db(const char* path, const jellyfish::file_header& header) :
+    map_(path),
+    canonical_(header.canonical()),
+    size_((map_.length() - std::min(map_.length(), header.offset())) /
+          (header.key_len() / 8 + (header.key_len() % 8 != 0) + header.counter_len()))
+  {
+    if(map_.length() > header.offset())
+      query_.reset(new query_type(map_.base() + header.offset(), header.key_len(), header.counter_len(),
+                                  header.hash_function(), header.size() - 1, map_.length() - header.offset()));
+  }
+
+  virtual uint64_t size() const {
+    return size_;
+  }
+
+  virtual void query(const char* const* seqs, const size_t* lens, size_t nb, unsigned int threads,
+                     uint64_t* counts) const {
+    const query_type* q = query_.get();
+    query_sequences<mer_type>(seqs, lens, nb, canonical_, threads, counts, [q](const mer_type& m, mer_type& tmp) {
+        return q ? q->check(m, tmp) : (uint64_t)0;
+      });
+  }
+};
+
+template<int S>
+db_engine* new_db(const char* path, const jellyfish::file_header& header) {
+  return new db<S>(path, header);
+}
+db_engine* (* const new_dbs[JELLYFISH_MAX_K_VALUES])(const char*, const jellyfish::file_header&) = {
+  new_db<0>, new_db<1>, new_db<2>, new_db<3>
+};
+} // namespace
+
+struct jellyfish_counter {
+  const unsigned int              k;
+  const k_slot                    slot;
+  std::unique_ptr<counter_engine> engine; // Destroyed before the slot is released
+
+  jellyfish_counter(unsigned int k_, uint64_t size, unsigned int counter_len, unsigned int threads, bool canonical) :
+    k(k_), slot(k_), engine(new_counters[slot()](size, counter_len, threads, canonical))
+  { }
+};
+
+struct jellyfish_db {
+  unsigned int               k;
+  bool                       canonical;
+  std::unique_ptr<k_slot>    slot;
+  std::unique_ptr<db_engine> engine; // Destroyed before the slot is released
+
+  explicit jellyfish_db(const char* path) {
+    std::ifstream in(path);
+    if(!in.good())
+      throw std::runtime_error(std::string("Can't open file '") + path + "'");
+    jellyfish::file_header header(in);
+    if(header.format() != jellyfish::binary_dumper<jellyfish::large_hash::array<jellyfish::mer_dna> >::format)
+      throw std::runtime_error(std::string("Unsupported format '") + header.format() + "'");
+    k         = header.key_len() / 2;
+    canonical = header.canonical();
+    slot.reset(new k_slot(k));
+    engine.reset(new_dbs[(*slot)()](path, header));
+  }
+};
+
+const char* jellyfish_last_error(void) {
+  return last_error;
+}
+
+size_t jellyfish_nb_positions(unsigned int k, const char* const* seqs, const size_t* lens, size_t nb) {
+  size_t res = 0;
+  for(size_t i = 0; i < nb; ++i)
+    res += nb_positions(k, lens[i]);
+  return res;
+}
+
+jellyfish_counter* jellyfish_counter_new(unsigned int k, uint64_t size, unsigned int counter_len,
+                                         unsigned int threads, int canonical) {
+  return guard((jellyfish_counter*)0, [&]() {
+      if(threads == 0)
+        throw std::invalid_argument("The number of threads must be positive");
+      return new jellyfish_counter(k, size, counter_len, threads, canonical);
+    });
+}
+
+void jellyfish_counter_free(jellyfish_counter* counter) {
+  delete counter;
+}
+
+unsigned int jellyfish_counter_k(const jellyfish_counter* counter) {
+  return counter->k;
+}
+
+uint64_t jellyfish_counter_size(const jellyfish_counter* counter) {
+  return counter->engine->size();
+}
+
+int64_t jellyfish_counter_add(jellyfish_counter* counter, const char* const* seqs, const size_t* lens, size_t nb) {
+  return guard((int64_t)-1, [&]() { return (int64_t)counter->engine->add(seqs, lens, nb); });
+}
+
+int jellyfish_counter_query(const jellyfish_counter* counter, const char* const* seqs, const size_t* lens,
+                            size_t nb, unsigned int threads, uint64_t* counts) {
+  return guard(-1, [&]() {
+      counter->engine->query(seqs, lens, nb, threads, counts);
+      return 0;
+    });
+}
+
+int jellyfish_counter_dump(jellyfish_counter* counter, const char* path, unsigned int out_counter_len,
+                           uint64_t lower, uint64_t upper) {
+  return guard(-1, [&]() {
+      counter->engine->dump(path, out_counter_len, lower, upper);
+      return 0;
+    });
+}
+
+jellyfish_db* jellyfish_db_open(const char* path) {
+  return guard((jellyfish_db*)0, [&]() { return new jellyfish_db(path); });
+}
+
+void jellyfish_db_close(jellyfish_db* db) {
+  delete db;
+}
+
+unsigned int jellyfish_db_k(const jellyfish_db* db) {
+  return db->k;
+}
+
+int jellyfish_db_canonical(const jellyfish_db* db) {
+  return db->canonical;
+}
+
+uint64_t jellyfish_db_size(const jellyfish_db* db) {
+  return db->engine->size();
+}
+
+int jellyfish_db_query(const jellyfish_db* db, const char* const* seqs, const size_t* lens, size_t nb,
+                       unsigned int threads, uint64_t* counts) {
+  return guard(-1, [&]() {
+      db->engine->query(seqs, lens, nb, threads, counts);
+      return 0;
+    });
+}
@@ -0,0 +1,269 @@
+/*  This file is part of Jellyfish.
+
+    Jellyfish is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Jellyfish is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Jellyfish.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <signal.h>
+#include <string.h>
+#include <poll.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+
+#include <cstdio>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+
+#include <jellyfish/progress.hpp>
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+namespace jellyfish {
+namespace {
+// Write end of the wake pipe of the reporter, for the signal handler
+int              wake_fd = -1;
+struct sigaction old_usr1;
+
+void usr1_handler(int) {
+  const int  saved_errno = errno;
+  const char c           = 'u';
+  if(wake_fd != -1 && write(wake_fd, &c, 1) == -1) { } // Nothing to do if it fails
+  errno = saved_errno;
+}
+
+// Resident set size, if available. Peak resident set size otherwise.
+uint64_t resident_bytes() {
+  std::ifstream statm("/proc/self/statm");
+  uint64_t      size, resident;
+  if(statm >> size >> resident)
+    return resident * sysconf(_SC_PAGESIZE);
+  struct rusage usage;
+  if(getrusage(RUSAGE_SELF, &usage) == -1)
+    return 0;
+#ifdef __APPLE__
+  return usage.ru_maxrss; // In bytes on Mac OS X
+#else
+  return (uint64_t)usage.ru_maxrss * 1024;
+#endif
+}
+
+double as_seconds(std::chrono::steady_clock::duration d) {
+  return std::chrono::duration_cast<std::chrono::duration<double> >(d).count();
+}
+
+// Write all of buf to fd, ignoring errors: the client may have gone.
+void send_all(int fd, const std::string& buf) {
+  size_t sent = 0;
+  while(sent < buf.size()) {
+    const ssize_t res = send(fd, buf.data() + sent, buf.size() - sent, MSG_NOSIGNAL);
+    if(res == -1 && errno == EINTR) continue;
+    if(res <= 0) return;
+    sent += res;
+  }
+}
+} // namespace
+
+progress_reporter::progress_reporter(const char* command, const char* path, double interval, const char* socket_path) :
+  command_(command),
+  path_(path ? path : ""),
+  socket_path_(socket_path ? socket_path : ""),
+  interval_(interval),
+  socket_(-1),
+  start_(clock::now()),
+  last_time_(start_),
+  last_mers_(0),
+  rate_(0.0)
+{
+  if(interval_ <= 0)
+    throw Error(err::msg() << "The metrics interval must be positive");
+  if(wake_fd != -1)
+    throw Error("Only one progress reporter at a time");
+  if(pipe(wake_))
+    throw Error(err::msg() << "Failed to create pipe: " << err::no);
+  fcntl(wake_[0], F_SETFD, FD_CLOEXEC);
+  fcntl(wake_[1], F_SETFD, FD_CLOEXEC);
+
+  if(!socket_path_.empty()) {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if(socket_path_.size() >= sizeof(addr.sun_path))
+      throw Error(err::msg() << "Socket path '" << socket_path_ << "' is too long");
+    strcpy(addr.sun_path, socket_path_.c_str());
+    socket_ = socket(AF_UNIX, SOCK_STREAM, 0);
+    if(socket_ == -1)
+      throw Error(err::msg() << "Failed to create socket: " << err::no);
+    fcntl(socket_, F_SETFD, FD_CLOEXEC);
+    unlink(socket_path_.c_str());
+    if(bind(socket_, (struct sockaddr*)&addr, sizeof(addr)) || listen(socket_, 8))
+      throw Error(err::msg() << "Failed to listen on socket '" << socket_path_ << "': " << err::no);
+  }
+
+  wake_fd = wake_[1];
+  struct sigaction act;
+  memset(&act, 0, sizeof(act));
+  act.sa_handler = usr1_handler;
+  act.sa_flags   = SA_RESTART;
+  sigaction(SIGUSR1, &act, &old_usr1);
+
+  const int res = pthread_create(&thread_, 0, start_routine, this);
+  if(res) {
+    sigaction(SIGUSR1, &old_usr1, 0);
+    wake_fd = -1;
+    throw Error(err::msg() << "Can't create thread: " << strerror(res));
+  }
+}
+
+progress_reporter::~progress_reporter() {
+  const char c = 's';
+  if(write(wake_[1], &c, 1) == 1)
+    pthread_join(thread_, 0);
+  sigaction(SIGUSR1, &old_usr1, 0);
+  wake_fd = -1;
+  write_file();
+  close(wake_[0]);
+  close(wake_[1]);
+  if(socket_ != -1) {
+    close(socket_);
+    unlink(socket_path_.c_str());
+  }
+}
+
+void* progress_reporter::start_routine(void* self) {
+  static_cast<progress_reporter*>(self)->run();
+  return 0;
+}
+
+void progress_reporter::run() {
+  struct pollfd fds[2];
+  fds[0].fd     = wake_[0];
+  fds[0].events = POLLIN;
+  fds[1].fd     = socket_;
+  fds[1].events = POLLIN;
+  const nfds_t nfds = socket_ != -1 ? 2 : 1;
+
+  const clock::duration interval = std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(interval_));
+  clock::time_point     next     = clock::now() + interval;
+  while(true) {
+    int timeout = -1;
+    if(!path_.empty()) {
+      const clock::time_point now = clock::now();
+      timeout = now >= next ? 0 : std::chrono::duration_cast<std::chrono::milliseconds>(next - now).count() + 1;
+    }
+    const int res = poll(fds, nfds, timeout);
+    if(res == -1) {
+      if(errno == EINTR) continue;
+      return;
+    }
+    if(res == 0) { // Periodic report
+      write_file();
+      next += interval;
+      continue;
+    }
+    if(fds[0].revents & POLLIN) {
+      char c;
+      if(read(wake_[0], &c, 1) != 1 || c == 's')
+        return;
+      if(path_.empty())
+        std::cerr << metrics() << std::flush;
+      else
+        write_file();
+    }
+    if(nfds > 1 && (fds[1].revents & POLLIN))
+      serve_client();
+  }
+}
+
+void progress_reporter::write_file() {
+  if(path_.empty()) return;
+  const std::string tmp = path_ + ".tmp";
+  {
+    std::ofstream out(tmp.c_str());
+    out << metrics();
+    if(!out.good()) return;
+  }
+  rename(tmp.c_str(), path_.c_str());
+}
+
+// Answer any request with the metrics. Wait briefly for the request
+// to be sent so the client does not get a reset connection.
+void progress_reporter::serve_client() {
+  const int fd = accept(socket_, 0, 0);
+  if(fd == -1) return;
+  struct pollfd pfd;
+  pfd.fd     = fd;
+  pfd.events = POLLIN;
+  char buf[4096];
+  if(poll(&pfd, 1, 100) == 1 && recv(fd, buf, sizeof(buf), 0) < 0) { } // Request is ignored
+
+  const std::string  body = metrics();
+  std::ostringstream response;
+  response << "HTTP/1.0 200 OK\r\n"
+           << "Content-Type: text/plain; version=0.0.4\r\n"
+           << "Content-Length: " << body.size() << "\r\n\r\n"
+           << body;
+  send_all(fd, response.str());
+  close(fd);
+}
+
+std::string progress_reporter::metrics() {
+  const clock::time_point now  = clock::now();
+  const uint64_t          mers = progress::get(progress::MERS);
+  const double            dt   = as_seconds(now - last_time_);
+  if(dt >= 1.0) {
+    rate_      = (mers - last_mers_) / dt;
+    last_time_ = now;
+    last_mers_ = mers;
+  }
+  const uint64_t new_keys    = progress::get(progress::NEW_KEYS);
+  const uint64_t dumped_keys = progress::get(progress::DUMPED_KEYS);
+  const uint64_t hash_keys   = new_keys > dumped_keys ? new_keys - dumped_keys : 0;
+  const uint64_t hash_size   = progress::get(progress::HASH_SIZE);
+
+  std::ostringstream os;
+  os << std::setprecision(15);
+  const std::string labels = "{command=\"" + command_ + "\"}";
+  auto metric = [&](const char* name, const char* type, const char* help, double val) {
+    os << "# HELP jellyfish_" << name << ' ' << help << '\n'
+       << "# TYPE jellyfish_" << name << ' ' << type << '\n'
+       << "jellyfish_" << name << labels << ' ' << val << '\n';
+  };
+  metric("elapsed_seconds", "gauge", "Time since the start of the command", as_seconds(now - start_));
+  metric("resident_bytes", "gauge", "Resident set size of the process", resident_bytes());
+  metric("input_files_total", "counter", "Input files and pipes opened", progress::get(progress::INPUT_FILES));
+  metric("input_file_bytes_total", "counter", "Size of the regular input files opened", progress::get(progress::INPUT_FILE_BYTES));
+  metric("input_bases_total", "counter", "Bases parsed from the input", progress::get(progress::INPUT_BASES));
+  metric("mers_total", "counter", "k-mers parsed", mers);
+  metric("mers_per_second", "gauge", "k-mers parsed per second, over at least the last second", rate_);
+  metric("hash_size", "gauge", "Size of the hash", hash_size);
+  metric("hash_keys", "gauge", "Approximate number of distinct k-mers in the hash", hash_keys);
+  metric("hash_occupancy", "gauge", "Approximate fraction of the hash used", hash_size ? (double)hash_keys / hash_size : 0.0);
+  metric("hash_doublings_total", "counter", "Doublings of the size of the hash", progress::get(progress::DOUBLINGS));
+  metric("dumps_total", "counter", "Dumps of the hash to disk", progress::get(progress::DUMPS));
+  metric("records_read_total", "counter", "Records read from databases", progress::get(progress::RECORDS_READ));
+  metric("records_written_total", "counter", "Records written to the output", progress::get(progress::RECORDS_WRITTEN));
+  return os.str();
+}
+} // namespace jellyfish
@@ -15,6 +15,7 @@
 */
 
 #include <jellyfish/thread_exec.hpp>
+#include <jellyfish/trace.hpp>
 
 void jellyfish::thread_exec::exec(int nb_threads) {
   struct thread_info empty = {0, 0, 0};
@@ -39,6 +40,7 @@ void jellyfish::thread_exec::join() {
 
 void *jellyfish::thread_exec::start_routine(void *_info) {
   struct thread_info *info = (struct thread_info *)_info;
+  jellyfish::trace::span span("thread");
   info->self->start(info->id);
   return 0;
 }
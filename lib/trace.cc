@@ -0,0 +1,100 @@
+/*  This file is part of Jellyfish.
+
+    Jellyfish is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Jellyfish is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Jellyfish.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+
+#include <unistd.h>
+#include <pthread.h>
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+
+#include <jellyfish/trace.hpp>
+
+namespace jellyfish {
+namespace {
+pthread_mutex_t buffers_mutex = PTHREAD_MUTEX_INITIALIZER;
+uint64_t        generations   = 0;
+
+// Microseconds since start, with nanosecond precision
+void write_us(std::ostream& os, uint64_t ns) {
+  os << (ns / 1000) << '.' << std::setw(3) << std::setfill('0') << (ns % 1000);
+}
+} // namespace
+
+trace::trace(const char* path, const char* command, size_t capacity) :
+  path_(path),
+  command_(command),
+  capacity_(capacity),
+  generation_(__sync_add_and_fetch(&generations, 1)),
+  start_ns_(now_ns())
+{
+  if(capacity_ == 0)
+    throw Error("The trace buffers must not be empty");
+  {
+    std::ofstream out(path_.c_str());
+    if(!out.good())
+      throw Error(err::msg() << "Failed to open trace file '" << path_ << "'");
+  }
+  trace* expected = 0;
+  if(!__atomic_compare_exchange_n(&active(), &expected, this, false, __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+    throw Error("Only one trace at a time");
+}
+
+trace::~trace() {
+  __atomic_store_n(&active(), (trace*)0, __ATOMIC_RELEASE);
+  std::ofstream out(path_.c_str());
+  write(out);
+  out.close();
+  if(!out.good())
+    std::cerr << "Error writing trace file '" << path_ << "'" << std::endl;
+}
+
+trace::buffer* trace::new_buffer() {
+  pthread_mutex_lock(&buffers_mutex);
+  buffers_.push_back(std::unique_ptr<buffer>(new buffer(capacity_, buffers_.size())));
+  buffer* res = buffers_.back().get();
+  pthread_mutex_unlock(&buffers_mutex);
+  return res;
+}
+
+void trace::write(std::ostream& os) const {
+  const pid_t pid     = getpid();
+  uint64_t    dropped = 0;
+  bool        first   = true;
+
+  os << "{\"traceEvents\":[\n";
+  for(auto it = buffers_.cbegin(); it != buffers_.cend(); ++it) {
+    const buffer& buf = **it;
+    dropped += buf.dropped();
+    os << (first ? "" : ",\n")
+       << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << pid << ",\"tid\":" << buf.tid()
+       << ",\"args\":{\"name\":\"thread " << buf.tid() << "\"}}";
+    first = false;
+    buf.for_each([&](const event& e) {
+        os << ",\n{\"name\":\"" << e.name << "\",\"cat\":\"" << command_ << "\",\"ph\":\"X\",\"pid\":" << pid
+           << ",\"tid\":" << buf.tid() << ",\"ts\":";
+        write_us(os, e.begin_ns > start_ns_ ? e.begin_ns - start_ns_ : 0);
+        os << ",\"dur\":";
+        write_us(os, e.end_ns - e.begin_ns);
+        os << '}';
+      });
+  }
+  os << "\n],\"displayTimeUnit\":\"ms\",\"otherData\":{\"command\":\"" << command_
+     << "\",\"dropped_events\":" << dropped << "}}\n";
+}
+} // namespace jellyfish
@@ -0,0 +1,205 @@
+/*  This file is part of Jellyfish.
+
+    Jellyfish is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Jellyfish is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Jellyfish.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdint.h>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <memory>
+#include <limits>
+
+#include <jellyfish/err.hpp>
+#include <jellyfish/thread_exec.hpp>
+#include <jellyfish/locks_pthread.hpp>
+#include <jellyfish/mapped_file.hpp>
+#include <jellyfish/spectrum.hpp>
+#include <jellyfish/top_mers.hpp>
+#include <jellyfish/database_chunks.hpp>
+#include <jellyfish/jellyfish.hpp>
+#include <sub_commands/analyze_main_cmdline.hpp>
+
+namespace err = jellyfish::err;
+
+using jellyfish::mer_dna;
+typedef jellyfish::top_mers<mer_dna, uint64_t> top_mers;
+
+static analyze_main_cmdline args; // Command line switches and arguments
+
+// Number of records (binary format) or bytes (text format) in a chunk
+static const size_t records_per_chunk = (size_t)1 << 18;
+static const size_t bytes_per_chunk   = (size_t)1 << 24;
+
+// Each thread takes the next chunk of the database and passes every
+// record to the consumers. The histogram, stats and top k-mers are
+// kept per thread and added at the end. The dump of a chunk is
+// formatted in memory and written after the dump of the previous
+// chunks.
+template<typename Chunks>
+class analyzer : public jellyfish::thread_exec {
+  const Chunks&                    chunks_;
+  const uint64_t                   min_, max_;
+  std::vector<jellyfish::spectrum> histos_;
+  std::vector<jellyfish::spectrum> stats_;
+  std::vector<top_mers>            tops_;
+  std::ostream*                    dump_;
+  size_t                           next_chunk_;
+  jellyfish::locks::pthread::cond  dump_cond_;
+  size_t                           next_dump_;
+
+public:
+  analyzer(const Chunks& chunks, int nb_threads, uint64_t min, uint64_t max,
+           bool histo, bool stats, size_t top, std::ostream* dump) :
+    chunks_(chunks),
+    min_(min), max_(max),
+    histos_(histo ? nb_threads : 0, jellyfish::spectrum(args.low_arg, args.high_arg, args.increment_arg)),
+    stats_(stats ? nb_threads : 0),
+    tops_(top ? nb_threads : 0, top_mers(top)),
+    dump_(dump),
+    next_chunk_(0),
+    next_dump_(0)
+  { }
+
+  virtual void start(int thid) {
+    jellyfish::spectrum* histo  = histos_.empty() ? 0 : &histos_[thid];
+    jellyfish::spectrum* stats  = stats_.empty() ? 0 : &stats_[thid];
+    top_mers*            top    = tops_.empty() ? 0 : &tops_[thid];
+    const char           spacer = args.tab_flag ? '\t' : ' ';
+    std::ostringstream   buffer;
+
+    for(size_t i = __sync_fetch_and_add(&next_chunk_, 1); i < chunks_.size(); i = __sync_fetch_and_add(&next_chunk_, 1)) {
+      typename Chunks::reader it = chunks_.chunk(i);
+      buffer.str("");
+      while(it.next()) {
+        const uint64_t val = it.val();
+        if(histo) histo->add(val);
+        if(val < min_ || val > max_) continue;
+        if(stats) stats->add(val);
+        if(top) top->add(it.key(), val);
+        if(dump_) {
+          if(args.column_flag)
+            buffer << it.key() << spacer << val << "\n";
+          else
+            buffer << ">" << val << "\n" << it.key() << "\n";
+        }
+      }
+
+      if(dump_) {
+        dump_cond_.lock();
+        while(next_dump_ != i)
+          dump_cond_.wait();
+        const std::string str = buffer.str();
+        dump_->write(str.data(), str.size());
+        ++next_dump_;
+        dump_cond_.broadcast();
+        dump_cond_.unlock();
+      }
+    }
+  }
+
+  void histo(jellyfish::spectrum& res) const {
+    for(auto it = histos_.cbegin(); it != histos_.cend(); ++it)
+      res += *it;
+  }
+  void stats(jellyfish::spectrum& res) const {
+    for(auto it = stats_.cbegin(); it != stats_.cend(); ++it)
+      res += *it;
+  }
+  void top(top_mers& res) const {
+    for(auto it = tops_.cbegin(); it != tops_.cend(); ++it)
+      res += *it;
+  }
+};
+
+std::ofstream* open_output(const char* path) {
+  std::ofstream* res = new std::ofstream(path);
+  if(!res->good())
+    err::die(err::msg() << "Error opening output file '" << path << "'");
+  return res;
+}
+
+template<typename Chunks>
+void analyze(const Chunks& chunks) {
+  std::unique_ptr<std::ofstream> histo_out(args.histo_given ? open_output(args.histo_arg) : 0);
+  std::unique_ptr<std::ofstream> stats_out(args.stats_given ? open_output(args.stats_arg) : 0);
+  std::unique_ptr<std::ofstream> dump_out(args.dump_given ? open_output(args.dump_arg) : 0);
+  std::unique_ptr<std::ofstream> top_out(args.top_given ? open_output(args.top_arg) : 0);
+
+  const uint64_t min = args.lower_count_given ? args.lower_count_arg : 0;
+  const uint64_t max = args.upper_count_given ? args.upper_count_arg : std::numeric_limits<uint64_t>::max();
+  analyzer<Chunks> analyzer(chunks, args.threads_arg, min, max, args.histo_given, args.stats_given,
+                            args.top_given ? args.top_n_arg : 0, dump_out.get());
+  analyzer.exec_join(args.threads_arg);
+
+  if(histo_out) {
+    jellyfish::spectrum histo(args.low_arg, args.high_arg, args.increment_arg);
+    analyzer.histo(histo);
+    histo.write_histo(*histo_out, args.full_flag);
+  }
+  if(stats_out) {
+    jellyfish::spectrum stats;
+    analyzer.stats(stats);
+    stats.write_stats(*stats_out);
+  }
+  if(top_out) {
+    top_mers top(args.top_n_arg);
+    analyzer.top(top);
+    top.write(*top_out);
+  }
+
+  const char* const paths[] = { args.histo_arg, args.stats_arg, args.dump_arg, args.top_arg };
+  std::ofstream* const outs[] = { histo_out.get(), stats_out.get(), dump_out.get(), top_out.get() };
+  for(int i = 0; i < 4; ++i) {
+    if(!outs[i]) continue;
+    outs[i]->close();
+    if(!outs[i]->good())
+      err::die(err::msg() << "Error writing output file '" << paths[i] << "'");
+  }
+}
+
+int analyze_main(int argc, char *argv[])
+{
+  args.parse(argc, argv);
+
+  if(args.high_arg < args.low_arg)
+    analyze_main_cmdline::error("High count value must be >= to low count value");
+
+  std::ifstream is(args.db_arg);
+  if(!is.good())
+    err::die(err::msg() << "Failed to open input file '" << args.db_arg << "'");
+  jellyfish::file_header header;
+  header.read(is);
+  is.close();
+  mer_dna::k(header.key_len() / 2);
+
+  jellyfish::mapped_file map(args.db_arg);
+  map.sequential().will_need();
+  const char* const data   = map.base() + header.offset();
+  const size_t      length = map.length() - header.offset();
+
+  if(!header.format().compare(binary_dumper::format)) {
+    jellyfish::binary_chunks<mer_dna, uint64_t> chunks(data, header.key_len(), header.counter_len(), length,
+                                                       records_per_chunk);
+    analyze(chunks);
+  } else if(!header.format().compare(text_dumper::format)) {
+    jellyfish::text_chunks<mer_dna, uint64_t> chunks(data, length, bytes_per_chunk);
+    analyze(chunks);
+  } else {
+    err::die(err::msg() << "Unknown format '" << header.format() << "'");
+  }
+
+  return 0;
+}
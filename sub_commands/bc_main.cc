@@ -18,6 +18,7 @@
 
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include <vector>
 #include <chrono>
 
@@ -29,6 +30,9 @@
 #include <jellyfish/mer_dna_bloom_counter.hpp>
 #include <jellyfish/thread_exec.hpp>
 #include <jellyfish/file_header.hpp>
+#include <jellyfish/progress.hpp>
+#include <jellyfish/trace.hpp>
+#include <jellyfish/mem_planner.hpp>
 #include <sub_commands/bc_main_cmdline.hpp>
 
 namespace err = jellyfish::err;
@@ -44,18 +48,21 @@ static bc_main_cmdline args; // Command line switches and arguments
 typedef std::vector<const char*> file_vector;
 using jellyfish::mer_dna;
 using jellyfish::mer_dna_bloom_counter;
+using jellyfish::mer_dna_blocked_bloom_counter;
+using jellyfish::mer_dna_count_min_sketch;
+using jellyfish::mer_dna_cuckoo_filter;
 typedef jellyfish::mer_overlap_sequence_parser<jellyfish::stream_manager<file_vector::const_iterator> > sequence_parser;
 typedef jellyfish::mer_iterator<sequence_parser, jellyfish::mer_dna> mer_iterator;
 
-template<typename PathIterator>
+template<typename PathIterator, typename BloomCounter>
 class mer_bloom_counter : public jellyfish::thread_exec {
   int                                     nb_threads_;
-  mer_dna_bloom_counter&                  filter_;
+  BloomCounter&                           filter_;
   jellyfish::stream_manager<PathIterator> streams_;
   sequence_parser                         parser_;
 
 public:
-  mer_bloom_counter(int nb_threads, mer_dna_bloom_counter& filter,
+  mer_bloom_counter(int nb_threads, BloomCounter& filter,
                     PathIterator file_begin, PathIterator file_end,
                     PathIterator pipe_begin, PathIterator pipe_end,
                     uint32_t concurent_files) :
@@ -64,10 +71,23 @@ public:
     parser_(jellyfish::mer_dna::k(), streams_.nb_streams(), 3 * nb_threads, 4096, streams_)
   { }
 
+  // The k-mers are inserted in batches to overlap their memory
+  // accesses.
   virtual void start(int thid) {
+    static const size_t  batch_size = 64;
+    std::vector<mer_dna> batch(batch_size);
+    size_t               nb = 0;
+    jellyfish::progress_batch mers_progress(jellyfish::progress::MERS);
     for(mer_iterator mers(parser_, args.canonical_flag) ; mers; ++mers) {
-      filter_.insert(*mers);
+      batch[nb++] = *mers;
+      if(nb == batch_size) {
+        filter_.insert_many(batch.begin(), batch.end());
+        mers_progress.add(nb);
+        nb = 0;
+      }
     }
+    filter_.insert_many(batch.begin(), batch.begin() + nb);
+    mers_progress.add(nb);
   }
 };
 
@@ -81,43 +101,21 @@ static void signal_handler(int sig) {
   _exit(EXIT_FAILURE); // Should not be reached
 }
 
-int bc_main(int argc, char *argv[])
-{
-  auto start_time = system_clock::now();
-
-  jellyfish::file_header header;
-  header.fill_standard();
-  header.set_cmdline(argc, argv);
-
-  args.parse(argc, argv);
-  mer_dna::k(args.mer_len_arg);
-
-  std::unique_ptr<jellyfish::generator_manager> generator_manager;
-  if(args.generator_given) {
-    auto gm =
-      new jellyfish::generator_manager(args.generator_arg, args.Generators_arg,
-                                       args.shell_given ? args.shell_arg : (const char*)0);
-    generator_manager.reset(gm);
-    generator_manager->start();
-    manager_pid = generator_manager->pid();
-    struct sigaction act;
-    memset(&act, '\0', sizeof(act));
-    act.sa_handler = signal_handler;
-    assert(sigaction(SIGTERM, &act, 0) == 0);
-  }
-
-  header.canonical(args.canonical_flag);
-  std::ofstream output(args.output_arg);
-  if(!output.good())
-    err::die(err::msg() << "Can't open output file '" << args.output_arg << "'");
-
-  header.format("bloomcounter");
-  header.key_len(args.mer_len_arg * 2);
-  jellyfish::hash_pair<mer_dna> hash_fns;
-  header.matrix(hash_fns.m1, 1);
-  header.matrix(hash_fns.m2, 2);
+// Only a cuckoo filter can be full. Then some k-mers are missing
+// from it.
+template<typename BloomCounter>
+void check_full(const BloomCounter&) { }
+void check_full(const mer_dna_cuckoo_filter& filter) {
+  if(filter.overflows())
+    err::die(err::msg() << "The cuckoo filter is full: " << filter.overflows()
+             << " k-mers were not inserted. Increase the size (-s)");
+}
 
-  mer_dna_bloom_counter filter(args.fpr_arg, args.size_arg, hash_fns);
+// Insert the k-mers in the bloom counter and write it to output
+template<typename BloomCounter>
+void fill_bloom_counter(BloomCounter& filter, jellyfish::file_header& header, std::ofstream& output,
+                        std::unique_ptr<jellyfish::generator_manager>& generator_manager,
+                        system_clock::time_point start_time) {
   header.size(filter.m());
   header.nb_hashes(filter.k());
   header.write(output);
@@ -129,9 +127,9 @@ int bc_main(int argc, char *argv[])
   auto pipes_begin = generator_manager.get() ? generator_manager->pipes().begin() : args.file_arg.end();
   auto pipes_end = (bool)generator_manager ? generator_manager->pipes().end() : args.file_arg.end();
 
-  mer_bloom_counter<file_vector::const_iterator> counter(args.threads_arg, filter,
-                                                         args.file_arg.begin(), args.file_arg.end(),
-                                                         pipes_begin, pipes_end, args.Files_arg);
+  mer_bloom_counter<file_vector::const_iterator, BloomCounter> counter(args.threads_arg, filter,
+                                                                       args.file_arg.begin(), args.file_arg.end(),
+                                                                       pipes_begin, pipes_end, args.Files_arg);
   counter.exec_join(args.threads_arg);
 
   // If we have a manager, wait for it
@@ -143,6 +141,8 @@ int bc_main(int argc, char *argv[])
     generator_manager.reset();
   }
 
+  check_full(filter);
+
   auto after_count_time = system_clock::now();
 
   filter.write_bits(output);
@@ -156,6 +156,120 @@ int bc_main(int argc, char *argv[])
                 << "Counting " << as_seconds(after_count_time - after_init_time) << "\n"
                 << "Writing  " << as_seconds(after_dump_time - after_count_time) << "\n";
   }
+}
+
+// Header of the cuckoo filter given to --like. Its k-mers must be
+// compatible with the ones of header.
+jellyfish::file_header read_like_header(const char* path, const jellyfish::file_header& header) {
+  std::ifstream in(path, std::ios::in|std::ios::binary);
+  jellyfish::file_header res(in);
+  if(!in.good())
+    err::die(err::msg() << "Failed to parse header of file '" << path << "'");
+  if(res.format() != "bloomcounter/cuckoo")
+    err::die(err::msg() << "File '" << path << "' is not a cuckoo filter");
+  if(res.key_len() != header.key_len() || res.canonical() != header.canonical())
+    err::die(err::msg() << "The mer length and canonical switch must be the same as in '" << path << "'");
+  return res;
+}
+
+int bc_main(int argc, char *argv[])
+{
+  auto start_time = system_clock::now();
+
+  jellyfish::file_header header;
+  header.fill_standard();
+  header.set_cmdline(argc, argv);
+
+  args.parse(argc, argv);
+  if(args.bits_given && args.bits_arg != 4 && args.bits_arg != 8)
+    bc_main_cmdline::error("Number of bits per cell must be 4 or 8");
+  if(args.bits_given + args.blocked_flag + args.cuckoo_flag > 1)
+    bc_main_cmdline::error("The --bits, --blocked and --cuckoo switches are exclusive");
+  if(args.like_given && !args.cuckoo_flag)
+    bc_main_cmdline::error("The --like switch requires --cuckoo");
+  if(!args.size_given && !args.like_given && !args.mem_given)
+    bc_main_cmdline::error("The size (-s) is required unless --like or --mem is given");
+  mer_dna::k(args.mer_len_arg);
+  // The default rate of the other filters would cost a cuckoo filter
+  // more than 3 times the memory of its own best rate
+  if(args.cuckoo_flag && !args.fpr_given)
+    args.fpr_arg = mer_dna_cuckoo_filter::max_load_fpr();
+
+  // Expected number of k-mers and the memory it needs, checked
+  // against the budget if any
+  const bc_mem_params mem_params(args);
+  uint64_t            size = args.size_arg;
+  if(args.mem_given) {
+    if(!args.size_given && !args.like_given) {
+      size = bc_max_size(mem_params, args.mem_arg);
+      if(!size)
+        err::die(err::msg() << "No bloom counter fits in a memory budget of " << args.mem_arg << " bytes");
+    }
+    const mem_plan plan = bc_mem_plan(mem_params, size);
+    if(plan.total() > args.mem_arg) {
+      std::ostringstream breakdown;
+      plan.print(breakdown);
+      err::die(err::msg() << "Predicted peak memory of " << plan.total() << " bytes exceeds the budget of "
+               << args.mem_arg << " bytes:\n" << breakdown.str());
+    }
+  }
+
+  std::unique_ptr<jellyfish::progress_reporter> reporter(jellyfish::make_progress_reporter("bc", args));
+  std::unique_ptr<jellyfish::trace> trace(jellyfish::make_trace("bc", args));
+
+  std::unique_ptr<jellyfish::generator_manager> generator_manager;
+  if(args.generator_given) {
+    auto gm =
+      new jellyfish::generator_manager(args.generator_arg, args.Generators_arg,
+                                       args.shell_given ? args.shell_arg : (const char*)0);
+    generator_manager.reset(gm);
+    generator_manager->start();
+    manager_pid = generator_manager->pid();
+    struct sigaction act;
+    memset(&act, '\0', sizeof(act));
+    act.sa_handler = signal_handler;
+    assert(sigaction(SIGTERM, &act, 0) == 0);
+  }
+
+  header.canonical(args.canonical_flag);
+  std::ofstream output(args.output_arg);
+  if(!output.good())
+    err::die(err::msg() << "Can't open output file '" << args.output_arg << "'");
+
+  header.key_len(args.mer_len_arg * 2);
+  const jellyfish::file_header like = args.like_given ? read_like_header(args.like_arg, header) : jellyfish::file_header();
+  jellyfish::hash_pair<mer_dna> hash_fns = args.like_given
+    ? jellyfish::hash_pair<mer_dna>(like.matrix(1), like.matrix(2))
+    : jellyfish::hash_pair<mer_dna>();
+  header.matrix(hash_fns.m1, 1);
+  header.matrix(hash_fns.m2, 2);
+
+  if(args.bits_given) {
+    header.format("bloomcounter/countmin");
+    header.counter_bits(args.bits_arg);
+    mer_dna_count_min_sketch filter(args.fpr_arg, size, args.bits_arg, hash_fns);
+    fill_bloom_counter(filter, header, output, generator_manager, start_time);
+  } else if(args.cuckoo_flag) {
+    header.format("bloomcounter/cuckoo");
+    header.alignment(mer_dna_cuckoo_filter::bucket_bytes);
+    if(args.like_given) {
+      mer_dna_cuckoo_filter filter(like.size(), like.nb_hashes(), hash_fns);
+      fill_bloom_counter(filter, header, output, generator_manager, start_time);
+    } else {
+      mer_dna_cuckoo_filter filter(args.fpr_arg, size, hash_fns);
+      fill_bloom_counter(filter, header, output, generator_manager, start_time);
+    }
+  } else if(args.blocked_flag) {
+    header.format("bloomcounter/blocked");
+    // Blocks start on a cache line when the file is mapped
+    header.alignment(mer_dna_blocked_bloom_counter::block_bytes);
+    mer_dna_blocked_bloom_counter filter(args.fpr_arg, size, hash_fns);
+    fill_bloom_counter(filter, header, output, generator_manager, start_time);
+  } else {
+    header.format("bloomcounter");
+    mer_dna_bloom_counter filter(args.fpr_arg, size, hash_fns);
+    fill_bloom_counter(filter, header, output, generator_manager, start_time);
+  }
 
   return 0;
 }
@@ -0,0 +1,70 @@
+/*  This file is part of Jellyfish.
+
+    Jellyfish is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Jellyfish is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Jellyfish.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <fstream>
+
+#include <jellyfish/err.hpp>
+#include <jellyfish/file_header.hpp>
+#include <jellyfish/mapped_file.hpp>
+#include <jellyfish/jellyfish.hpp>
+#include <sub_commands/compact_main_cmdline.hpp>
+
+namespace err = jellyfish::err;
+
+using jellyfish::mer_dna;
+
+static compact_main_cmdline args;
+
+int compact_main(int argc, char *argv[])
+{
+  args.parse(argc, argv);
+
+  if(args.fingerprint_arg > 64)
+    compact_main_cmdline::error("The length of the fingerprints must be at most 64");
+
+  std::ifstream in(args.db_arg, std::ios::in|std::ios::binary);
+  jellyfish::file_header header(in);
+  if(!in.good())
+    err::die(err::msg() << "Failed to parse header of file '" << args.db_arg << "'");
+  in.close();
+  if(header.format() != binary_dumper::format)
+    err::die(err::msg() << "Unsupported format '" << header.format() << "'. Must be a binary list.");
+  mer_dna::k(header.key_len() / 2);
+
+  jellyfish::mapped_file binary_map(args.db_arg);
+  binary_map.sequential().will_need();
+  binary_records records(binary_map.base() + header.offset(), header.key_len(), header.counter_len(),
+                         binary_map.length() - header.offset());
+  compact_builder builder(records, args.fingerprint_arg, args.gamma_arg, args.threads_arg);
+  binary_map.unmap();
+
+  std::ofstream out(args.output_arg, std::ios::out|std::ios::binary);
+  if(!out.good())
+    err::die(err::msg() << "Error opening output file '" << args.output_arg << "'");
+  jellyfish::file_header out_header;
+  out_header.fill_standard();
+  out_header.set_cmdline(argc, argv);
+  out_header.key_len(header.key_len());
+  out_header.canonical(header.canonical());
+  builder.update_header(out_header);
+  out_header.write(out);
+  builder.write(out);
+  out.close();
+  if(!out.good())
+    err::die(err::msg() << "Error writing output file '" << args.output_arg << "'");
+
+  return 0;
+}
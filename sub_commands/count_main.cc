@@ -18,6 +18,8 @@
 #include <unistd.h>
 #include <assert.h>
 #include <signal.h>
+#include <sys/time.h>
+#include <sys/resource.h>
 
 #include <iostream>
 #include <fstream>
@@ -29,7 +31,11 @@
 #include <chrono>
 
 #include <jellyfish/err.hpp>
+#include <jellyfish/json.h>
 #include <jellyfish/thread_exec.hpp>
+#include <jellyfish/thread_stats.hpp>
+#include <jellyfish/progress.hpp>
+#include <jellyfish/trace.hpp>
 #include <jellyfish/hash_counter.hpp>
 #include <jellyfish/locks_pthread.hpp>
 #include <jellyfish/stream_manager.hpp>
@@ -39,6 +45,9 @@
 #include <jellyfish/mer_qual_iterator.hpp>
 #include <jellyfish/jellyfish.hpp>
 #include <jellyfish/merge_files.hpp>
+#include <jellyfish/mem_planner.hpp>
+#include <jellyfish/spectrum.hpp>
+#include <jellyfish/top_mers.hpp>
 #include <jellyfish/mer_dna_bloom_counter.hpp>
 #include <jellyfish/generator_manager.hpp>
 #include <sub_commands/count_main_cmdline.hpp>
@@ -55,9 +64,18 @@ template<typename DtnType>
 inline double as_seconds(DtnType dtn) { return duration_cast<duration<double>>(dtn).count(); }
 
 using jellyfish::mer_dna;
-using jellyfish::mer_dna_bloom_counter;
+using jellyfish::thread_stats;
+using jellyfish::mer_dna_bloom_counter_file;
+using jellyfish::mer_dna_blocked_bloom_counter_file;
+using jellyfish::mer_dna_count_min_sketch_file;
+using jellyfish::mer_dna_cuckoo_filter_file;
 using jellyfish::mer_dna_bloom_filter;
 typedef std::vector<const char*> file_vector;
+typedef jellyfish::top_mers<mer_dna, uint64_t> top_mers;
+
+// Statistics of each counting thread, if --report is given. Empty
+// otherwise.
+static std::vector<thread_stats> counting_stats;
 
 // Types for parsing arbitrary sequence ignoring quality scores
 typedef jellyfish::mer_overlap_sequence_parser<jellyfish::stream_manager<file_vector::const_iterator> > sequence_parser;
@@ -98,15 +116,18 @@ struct filter {
   }
 };
 
+template<typename BloomCounter>
 struct filter_bc : public filter {
-  const mer_dna_bloom_counter& counter_;
-  filter_bc(const mer_dna_bloom_counter& counter, filter* prev = 0) :
+  const BloomCounter& counter_;
+  const unsigned int  min_;
+  filter_bc(const BloomCounter& counter, unsigned int min, filter* prev = 0) :
     filter(prev),
-    counter_(counter)
+    counter_(counter),
+    min_(min)
   { }
   bool operator()(const mer_dna& m) {
     unsigned int c = counter_.check(m);
-    return and_res(c > 1, m);
+    return and_res(c >= min_, m);
   }
 };
 
@@ -146,37 +167,57 @@ public:
   { }
 
   virtual void start(int thid) {
-    size_t count = 0;
+    thread_stats::scope stats_scope(counting_stats.empty() ? 0 : &counting_stats[thid]);
+    size_t count = 0, adds = 0;
+    bool   is_new;
+    size_t id;
+    jellyfish::progress_batch mers_progress(jellyfish::progress::MERS);
+    jellyfish::progress_batch keys_progress(jellyfish::progress::NEW_KEYS);
     MerIteratorType mers(parser_, args.canonical_flag);
 
     switch(op_) {
      case COUNT:
       for( ; mers; ++mers) {
-        if((*filter_)(*mers))
-          ary_.add(*mers, 1);
+        if((*filter_)(*mers)) {
+          ary_.add(*mers, 1, &is_new, &id);
+          ++adds;
+          if(is_new) ++keys_progress;
+        }
         ++count;
+        ++mers_progress;
       }
       break;
 
     case PRIME:
       for( ; mers; ++mers) {
-        if((*filter_)(*mers))
-          ary_.set(*mers);
+        if((*filter_)(*mers)) {
+          ary_.set(*mers, &is_new, &id);
+          ++adds;
+          if(is_new) ++keys_progress;
+        }
         ++count;
+        ++mers_progress;
       }
       break;
 
     case UPDATE:
       mer_dna tmp;
       for( ; mers; ++mers) {
-        if((*filter_)(*mers))
+        if((*filter_)(*mers)) {
           ary_.update_add(*mers, 1, tmp);
+          ++adds;
+        }
         ++count;
+        ++mers_progress;
       }
       break;
     }
+    mers_progress.flush();
+    keys_progress.flush();
 
     ary_.done();
+    thread_stats::incr<&thread_stats::mers>(count);
+    thread_stats::incr<&thread_stats::adds>(adds);
   }
 };
 
@@ -184,23 +225,152 @@ public:
 typedef mer_counter_base<file_vector::const_iterator, mer_iterator, sequence_parser> mer_counter;
 typedef mer_counter_base<file_vector::const_iterator, mer_qual_iterator, sequence_qual_parser> mer_qual_counter;
 
-mer_dna_bloom_counter* load_bloom_filter(const char* path) {
+// Bloom counter mapped from file, in the standard or blocked layout,
+// count-min sketch or cuckoo filter. Only one of them is set. The
+// file is mapped read only: the counter is only checked.
+struct loaded_bloom_counter {
+  std::unique_ptr<mer_dna_bloom_counter_file>         bc;
+  std::unique_ptr<mer_dna_blocked_bloom_counter_file> blocked;
+  std::unique_ptr<mer_dna_count_min_sketch_file>      cms;
+  std::unique_ptr<mer_dna_cuckoo_filter_file>         cuckoo;
+};
+
+// Lookups are random. Pre-fault the whole file if load is true.
+static int bloom_map_flags(bool load) {
+  return load ? jellyfish::mapped_file::populate_flag() : 0;
+}
+// Huge pages only on request: the advice is ignored but on tmpfs.
+template<typename BloomCounter>
+BloomCounter* advise_bloom_counter(BloomCounter* bc, bool huge_pages) {
+  bc->file().random();
+  if(huge_pages)
+    bc->file().huge_pages();
+  return bc;
+}
+
+filter* load_bloom_filter(const char* path, unsigned int min, bool load, bool huge_pages, loaded_bloom_counter& res) {
   std::ifstream in(path, std::ios::in|std::ios::binary);
   jellyfish::file_header header(in);
   if(!in.good())
     err::die(err::msg() << "Failed to parse bloom filter file '" << path << "'");
-  if(header.format() != "bloomcounter")
-    err::die(err::msg() << "Invalid format '" << header.format() << "'. Expected 'bloomcounter'");
+  in.close();
   if(header.key_len() != mer_dna::k() * 2)
     err::die("Invalid mer length in bloom filter");
   jellyfish::hash_pair<mer_dna> fns(header.matrix(1), header.matrix(2));
-  auto res = new mer_dna_bloom_counter(header.size(), header.nb_hashes(), in, fns);
-  if(!in.good())
-    err::die("Bloom filter file is truncated");
-  in.close();
+  const int flags = bloom_map_flags(load);
+  try {
+    if(header.format() == "bloomcounter/countmin") {
+      res.cms.reset(advise_bloom_counter(new mer_dna_count_min_sketch_file(header.size(), header.nb_hashes(), header.counter_bits(),
+                                                                            path, fns, header.offset(), flags), huge_pages));
+      if(min > res.cms->max_count())
+        err::die(err::msg() << "Minimum count " << min << " is larger than the maximum count "
+                 << res.cms->max_count() << " of the count-min sketch");
+      return new filter_bc<mer_dna_count_min_sketch_file>(*res.cms, min);
+    }
+    if(header.format() == "bloomcounter/cuckoo") {
+      res.cuckoo.reset(advise_bloom_counter(new mer_dna_cuckoo_filter_file(header.size(), header.nb_hashes(), path, fns,
+                                                                            header.offset(), flags), huge_pages));
+      if(min > res.cuckoo->max_count())
+        err::die(err::msg() << "Minimum count " << min << " is larger than the maximum count "
+                 << res.cuckoo->max_count() << " of the cuckoo filter");
+      return new filter_bc<mer_dna_cuckoo_filter_file>(*res.cuckoo, min);
+    }
+    if(min > 2)
+      err::die(err::msg() << "Minimum count " << min << " requires a count-min sketch (bc --bits) or a cuckoo filter (bc --cuckoo)");
+    if(header.format() == "bloomcounter") {
+      res.bc.reset(advise_bloom_counter(new mer_dna_bloom_counter_file(header.size(), header.nb_hashes(), path, fns,
+                                                                        header.offset(), flags), huge_pages));
+      return new filter_bc<mer_dna_bloom_counter_file>(*res.bc, min);
+    } else if(header.format() == "bloomcounter/blocked") {
+      res.blocked.reset(advise_bloom_counter(new mer_dna_blocked_bloom_counter_file(header.size(), header.nb_hashes(), path, fns,
+                                                                                     header.offset(), flags), huge_pages));
+      return new filter_bc<mer_dna_blocked_bloom_counter_file>(*res.blocked, min);
+    }
+  } catch(std::runtime_error& e) {
+    err::die(err::msg() << "Failed to load bloom filter: " << e.what());
+  }
+  err::die(err::msg() << "Invalid format '" << header.format()
+           << "'. Expected 'bloomcounter', 'bloomcounter/blocked', 'bloomcounter/countmin' or 'bloomcounter/cuckoo'");
+  return 0;
+}
+
+static Json::Value stats_json(const thread_stats& stats) {
+  static const double ns = 1e-9;
+  Json::Value res;
+  res["mers"]                 = (Json::UInt64)stats.mers;
+  res["adds"]                 = (Json::UInt64)stats.adds;
+  res["reprobes"]             = (Json::UInt64)stats.reprobes;
+  res["cas_failures"]         = (Json::UInt64)stats.cas_failures;
+  res["barrier_waits"]        = (Json::UInt64)stats.barrier_waits;
+  res["barrier_seconds"]      = stats.barrier_ns * ns;
+  res["barrier_parks"]        = (Json::UInt64)stats.barrier_parks;
+  res["produce_calls"]        = (Json::UInt64)stats.produce_calls;
+  res["produce_seconds"]      = stats.produce_ns * ns;
+  res["consume_calls"]        = (Json::UInt64)stats.consume_calls;
+  res["consume_wait_seconds"] = stats.consume_ns * ns;
+  res["seconds"]              = stats.total_ns * ns;
+  // The rest is spent iterating over the k-mers and adding them to the hash
+  const uint64_t waits = stats.barrier_ns + stats.produce_ns + stats.consume_ns;
+  res["hash_seconds"]         = (stats.total_ns > waits ? stats.total_ns - waits : 0) * ns;
+  res["mers_per_second"]      = stats.total_ns ? stats.mers / (stats.total_ns * ns) : 0.0;
   return res;
 }
 
+// Report of the statistics of the counting threads (summed over the
+// passes if --if is given), the time of each phase and of each dump.
+static void write_report(const char* path, double init, double counting, double writing,
+                         jellyfish::dumper_t<mer_array>& dumper, size_t hash_size, const mem_plan& plan) {
+  Json::Value root;
+  root["threads"]   = args.threads_arg;
+  root["hash_size"] = (Json::UInt64)hash_size;
+
+  // Peak memory predicted by the planner, for the initial size of the
+  // hash, and actual
+  Json::Value& memory = root["memory"];
+  for(auto it = plan.items().cbegin(); it != plan.items().cend(); ++it)
+    memory["predicted"][it->name] = (Json::UInt64)it->bytes;
+  memory["predicted_peak_bytes"] = (Json::UInt64)plan.total();
+  struct rusage usage;
+  if(getrusage(RUSAGE_SELF, &usage) == 0) {
+#ifdef __APPLE__
+    memory["actual_peak_bytes"] = (Json::UInt64)usage.ru_maxrss; // In bytes on Mac OS X
+#else
+    memory["actual_peak_bytes"] = (Json::UInt64)usage.ru_maxrss * 1024;
+#endif
+  }
+  root["phases"]["init"]     = init;
+  root["phases"]["counting"] = counting;
+  root["phases"]["writing"]  = writing;
+
+  thread_stats total;
+  root["per_thread"] = Json::Value(Json::arrayValue);
+  for(size_t i = 0; i < counting_stats.size(); ++i) {
+    Json::Value thread = stats_json(counting_stats[i]);
+    thread["thread"] = (Json::UInt)i;
+    root["per_thread"].append(thread);
+    total += counting_stats[i];
+  }
+  root["total"] = stats_json(total);
+  root["total"]["mers_per_second"] = counting > 0 ? total.mers / counting : 0.0;
+
+  const std::vector<Time>&        times = dumper.dump_times();
+  const std::vector<std::string>& names = dumper.file_names();
+  root["dumps"] = Json::Value(Json::arrayValue);
+  for(size_t i = 0; i < times.size(); ++i) {
+    Json::Value dump;
+    dump["seconds"] = times[i].seconds();
+    if(i < names.size())
+      dump["file"] = names[i];
+    root["dumps"].append(dump);
+  }
+
+  std::ofstream out(path);
+  Json::StyledStreamWriter writer("  ");
+  writer.write(out, root);
+  if(!out.good())
+    err::die(err::msg() << "Error writing report file '" << path << "'");
+}
+
 // If get a termination signal, kill the manager and then kill myself.
 static pid_t manager_pid = 0;
 static void signal_handler(int sig) {
@@ -226,6 +396,28 @@ int count_main(int argc, char *argv[])
 
   mer_dna::k(args.mer_len_arg);
 
+  // Size of the hash and the memory it needs, checked against the
+  // budget if any
+  const count_mem_params mem_params(args);
+  uint64_t               hash_size = args.size_arg;
+  if(args.mem_given && !args.size_given) {
+    hash_size = count_max_size(mem_params, args.mem_arg);
+    if(!hash_size)
+      err::die(err::msg() << "No hash fits in a memory budget of " << args.mem_arg << " bytes");
+  } else if(!args.size_given) {
+    count_main_cmdline::error("The size (-s) is required unless --mem is given");
+  }
+  const mem_plan plan = count_mem_plan(mem_params, hash_size);
+  if(args.mem_given && plan.total() > args.mem_arg) {
+    std::ostringstream breakdown;
+    plan.print(breakdown);
+    err::die(err::msg() << "Predicted peak memory of " << plan.total() << " bytes exceeds the budget of "
+             << args.mem_arg << " bytes:\n" << breakdown.str());
+  }
+
+  std::unique_ptr<jellyfish::progress_reporter> reporter(jellyfish::make_progress_reporter("count", args));
+  std::unique_ptr<jellyfish::trace> trace(jellyfish::make_trace("count", args));
+
   std::unique_ptr<jellyfish::generator_manager> generator_manager;
   if(args.generator_given) {
     auto gm =
@@ -240,10 +432,22 @@ int count_main(int argc, char *argv[])
     assert(sigaction(SIGTERM, &act, 0) == 0);
   }
 
+  if(args.report_given)
+    counting_stats.resize(args.threads_arg);
+
   header.canonical(args.canonical_flag);
-  mer_hash ary(args.size_arg, args.mer_len_arg * 2, args.counter_len_arg, args.threads_arg, args.reprobes_arg);
+  mer_hash ary(hash_size, args.mer_len_arg * 2, args.counter_len_arg, args.threads_arg, args.reprobes_arg);
   if(args.disk_flag)
     ary.do_size_doubling(false);
+  if(args.xorshift_hash_flag) {
+    if(args.mer_len_arg > 32)
+      err::die("The xorshift-multiply hash (--xorshift-hash) requires a mer length of at most 32");
+    ary.hash_family(jellyfish::invertible_hash::XORSHIFT_MUL);
+  }
+  // Double the hash only while the plan for its current size fits the
+  // budget. Dump to disk past that.
+  if(args.mem_given)
+    ary.max_size(std::max((uint64_t)ary.size(), 2 * count_max_size(mem_params, args.mem_arg)));
 
   std::auto_ptr<jellyfish::dumper_t<mer_array> > dumper;
   if(args.text_flag)
@@ -272,11 +476,9 @@ int count_main(int argc, char *argv[])
   // Bloom counter read from file to filter out low frequency
   // k-mers. Two pass algorithm.
   std::unique_ptr<filter> mer_filter(new filter);
-  std::unique_ptr<mer_dna_bloom_counter> bc;
-  if(args.bc_given) {
-    bc.reset(load_bloom_filter(args.bc_arg));
-    mer_filter.reset(new filter_bc(*bc));
-  }
+  loaded_bloom_counter bc;
+  if(args.bc_given)
+    mer_filter.reset(load_bloom_filter(args.bc_arg, args.bc_min_arg, args.bc_load_flag, args.bc_huge_pages_flag, bc));
 
   // Bloom filter to filter out low frequency k-mers. One pass
   // algorithm.
@@ -313,32 +515,72 @@ int count_main(int argc, char *argv[])
 
   auto after_count_time = system_clock::now();
 
+  // Histogram, stats and top k-mers, if requested. Computed from the
+  // same k-mers as written in the output.
+  const uint64_t min = args.lower_count_given ? args.lower_count_arg : 0;
+  const uint64_t max = args.upper_count_given ? args.upper_count_arg : std::numeric_limits<uint64_t>::max();
+  std::unique_ptr<jellyfish::spectrum> spectrum;
+  if(args.histo_given || args.stats_given)
+    spectrum.reset(new jellyfish::spectrum);
+  std::unique_ptr<top_mers> top;
+  if(args.top_given)
+    top.reset(new top_mers(args.top_n_arg));
+
   // If no intermediate files, dump directly into output file. If not, will do a round of merging
-  if(!args.no_write_flag) {
-    if(dumper->nb_files() == 0) {
+  if(dumper->nb_files() == 0) {
+    if(spectrum) {
+      jellyfish::spectrum_computer<mer_array> computer(*ary.ary(), args.threads_arg, min, max);
+      computer.compute(*spectrum);
+    }
+    if(top) {
+      jellyfish::top_mers_computer<mer_array> computer(*ary.ary(), args.threads_arg, args.top_n_arg, min, max);
+      computer.compute(*top);
+    }
+    if(!args.no_write_flag) {
       dumper->one_file(true);
       if(args.lower_count_given)
         dumper->min(args.lower_count_arg);
       if(args.upper_count_given)
         dumper->max(args.upper_count_arg);
       dumper->dump(ary.ary());
-    } else {
-      dumper->dump(ary.ary());
-      if(!args.no_merge_flag) {
-        std::vector<const char*> files = dumper->file_names_cstr();
-        uint64_t min = args.lower_count_given ? args.lower_count_arg : 0;
-        uint64_t max = args.upper_count_given ? args.upper_count_arg : std::numeric_limits<uint64_t>::max();
-        try {
-          merge_files(files, args.output_arg, header, min, max);
-        } catch(MergeError e) {
-          err::die(err::msg() << e.what());
-        }
-        if(!args.no_unlink_flag) {
-          for(int i =0; i < dumper->nb_files(); ++i)
-            unlink(files[i]);
-        }
-      } // if(!args.no_merge_flag
-    } // if(!args.no_merge_flag
+    }
+  } else if(!args.no_write_flag || spectrum || top) {
+    // The counts are split between the intermediate files and the
+    // hash. Dump the hash and merge, writing the output only if
+    // needed.
+    dumper->dump(ary.ary());
+    if(!args.no_merge_flag || spectrum || top) {
+      std::vector<const char*> files = dumper->file_names_cstr();
+      const bool write_output = !args.no_write_flag && !args.no_merge_flag;
+      try {
+        merge_files(files, write_output ? args.output_arg : 0, header, min, max, spectrum.get(), top.get());
+      } catch(MergeError e) {
+        err::die(err::msg() << e.what());
+      }
+      if(!args.no_unlink_flag && !args.no_merge_flag) {
+        for(int i =0; i < dumper->nb_files(); ++i)
+          unlink(files[i]);
+      }
+    }
+  }
+
+  if(args.histo_given) {
+    std::ofstream histo_file(args.histo_arg);
+    spectrum->write_histo(histo_file);
+    if(!histo_file.good())
+      err::die(err::msg() << "Error writing histogram file '" << args.histo_arg << "'");
+  }
+  if(args.stats_given) {
+    std::ofstream stats_file(args.stats_arg);
+    spectrum->write_stats(stats_file);
+    if(!stats_file.good())
+      err::die(err::msg() << "Error writing stats file '" << args.stats_arg << "'");
+  }
+  if(args.top_given) {
+    std::ofstream top_file(args.top_arg);
+    top->write(top_file);
+    if(!top_file.good())
+      err::die(err::msg() << "Error writing top file '" << args.top_arg << "'");
   }
 
   auto after_dump_time = system_clock::now();
@@ -350,5 +592,10 @@ int count_main(int argc, char *argv[])
                 << "Writing  " << as_seconds(after_dump_time - after_count_time) << "\n";
   }
 
+  if(args.report_given)
+    write_report(args.report_arg, as_seconds(after_init_time - start_time),
+                 as_seconds(after_count_time - after_init_time),
+                 as_seconds(after_dump_time - after_count_time), *dumper, ary.size(), plan);
+
   return 0;
 }
@@ -21,11 +21,13 @@
 #include <iostream>
 #include <fstream>
 #include <limits>
+#include <memory>
 
 #include <jellyfish/err.hpp>
 #include <jellyfish/misc.hpp>
 #include <jellyfish/fstream_default.hpp>
 #include <jellyfish/jellyfish.hpp>
+#include <jellyfish/progress.hpp>
 #include <sub_commands/dump_main_cmdline.hpp>
 
 namespace err = jellyfish::err;
@@ -35,18 +37,24 @@ static dump_main_cmdline args; // Command line switches and arguments
 template<typename iterator>
 void dump(iterator& it, std::ostream &out,
           uint64_t lower_count, uint64_t upper_count) {
+  jellyfish::progress_batch read_progress(jellyfish::progress::RECORDS_READ);
+  jellyfish::progress_batch written_progress(jellyfish::progress::RECORDS_WRITTEN);
   if(args.column_flag) {
     char spacer = args.tab_flag ? '\t' : ' ';
     while(it.next()) {
+      ++read_progress;
       if(it.val() < lower_count || it.val() > upper_count)
         continue;
       out << it.key() << spacer << it.val() << "\n";
+      ++written_progress;
     }
   } else {
     while(it.next()) {
+      ++read_progress;
       if(it.val() < lower_count || it.val() > upper_count)
         continue;
       out << ">" << it.val() << "\n" << it.key() << "\n";
+      ++written_progress;
     }
   }
 }
@@ -55,6 +63,7 @@ int dump_main(int argc, char *argv[])
 {
   args.parse(argc, argv);
   std::ios::sync_with_stdio(false); // No sync with stdio -> faster
+  std::unique_ptr<jellyfish::progress_reporter> reporter(jellyfish::make_progress_reporter("dump", args));
 
   ofstream_default out(args.output_given ? args.output_arg : 0, std::cout);
   if(!out.good())
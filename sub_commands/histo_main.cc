@@ -25,22 +25,16 @@
 #include <jellyfish/err.hpp>
 #include <jellyfish/misc.hpp>
 #include <jellyfish/fstream_default.hpp>
+#include <jellyfish/spectrum.hpp>
 #include <jellyfish/jellyfish.hpp>
 #include <sub_commands/histo_main_cmdline.hpp>
 
 namespace err = jellyfish::err;
 
 template<typename reader_type>
-void compute_histo(reader_type& reader, const uint64_t base, const uint64_t ceil,
-                   uint64_t* histo, const uint64_t nb_buckets, const uint64_t inc) {
-  while(reader.next()) {
-    if(reader.val() < base)
-      ++histo[0];
-    else if(reader.val() > ceil)
-      ++histo[nb_buckets - 1];
-    else
-      ++histo[(reader.val() - base) / inc];
-  }
+void compute_histo(reader_type& reader, jellyfish::spectrum& histo) {
+  while(reader.next())
+    histo.add(reader.val());
 }
 
 
@@ -61,29 +55,19 @@ int histo_main(int argc, char *argv[])
   if(!out.good())
     err::die(err::msg() << "Error opening output file '" << args.output_arg << "'");
 
-  const uint64_t base = args.increment_arg >= args.low_arg ? 0 : args.low_arg - args.increment_arg;
-  const uint64_t ceil = args.high_arg + args.increment_arg;
-  const uint64_t inc  = args.increment_arg;
-
-  const uint64_t nb_buckets  = (ceil + inc - base) / inc;
-  uint64_t*      histo       = new uint64_t[nb_buckets];
-  memset(histo, '\0', sizeof(uint64_t) * nb_buckets);
+  jellyfish::spectrum histo(args.low_arg, args.high_arg, args.increment_arg);
 
   if(!header.format().compare(binary_dumper::format)) {
     binary_reader reader(is, &header);
-    compute_histo(reader, base, ceil, histo, nb_buckets, inc);
+    compute_histo(reader, histo);
   } else if(!header.format().compare(text_dumper::format)) {
     text_reader reader(is, &header);
-    compute_histo(reader, base, ceil, histo, nb_buckets, inc);
+    compute_histo(reader, histo);
   } else {
     err::die(err::msg() << "Unknown format '" << header.format() << "'");
   }
 
-  for(uint64_t i = 0, col = base; i < nb_buckets; ++i, col += inc)
-    if(histo[i] > 0 || args.full_flag)
-      out << col << " " << histo[i] << "\n";
-
-  delete [] histo;
+  histo.write_histo(out, args.full_flag);
   out.close();
 
   return 0;
@@ -32,6 +32,10 @@ main_func_t query_main;
 main_func_t dump_main;
 main_func_t cite_main;
 main_func_t mem_main;
+main_func_t compact_main;
+main_func_t profile_main;
+main_func_t analyze_main;
+main_func_t top_main;
 // main_func_t dump_fastq_main;
 // main_func_t histo_fastq_main;
 // main_func_t hash_fastq_merge_main;
@@ -55,6 +59,10 @@ cmd_func cmd_list[] = {
   {"query",             &query_main},
   {"cite",              &cite_main},
   {"mem",               &mem_main},
+  {"compact",           &compact_main},
+  {"profile",           &profile_main},
+  {"analyze",           &analyze_main},
+  {"top",               &top_main},
   // {"qhisto",            &histo_fastq_main},
   // {"qdump",             &dump_fastq_main},
   // {"qmerge",            &hash_fastq_merge_main},
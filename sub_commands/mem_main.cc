@@ -17,38 +17,24 @@
 #include <iostream>
 #include <string>
 
-#include <jellyfish/mer_dna.hpp>
-#include <jellyfish/large_hash_array.hpp>
+#include <jellyfish/mem_planner.hpp>
 #include <sub_commands/mem_main_cmdline.hpp>
 
-static const char* suffixes = "kMGTPE";
-
-template<uint64_t U>
-std::string add_suffix(uint64_t x) {
-  const int max_i = strlen(suffixes);
-  int       i     = 0;
-  while(x >= U && i <= max_i) {
-    x /= U;
-    ++i;
-  }
-  std::ostringstream res;
-  res << x;
-  if(i > 0)
-    res << suffixes[i - 1];
-  return res.str();
-}
-
 int mem_main(int argc, char *argv[]) {
   mem_main_cmdline args(argc, argv);
-  jellyfish::large_hash::array<jellyfish::mer_dna>::usage_info usage(args.mer_len_arg * 2, args.counter_len_arg, args.reprobes_arg);
-
-  if(args.size_given) {
-    uint64_t val = usage.mem(args.size_arg);
-    std::cout << val << " (" << add_suffix<1024>(val) << ")\n";
-  } else {
-    uint64_t val = usage.size(args.mem_arg);
-    std::cout << val << " (" << add_suffix<1000>(val) << ")\n";
+  const count_mem_params params(args);
+
+  uint64_t size = args.size_arg;
+  if(!args.size_given) {
+    size = count_max_size(params, args.mem_arg);
+    std::cout << size << " (" << mem_with_suffix(size) << ")\n";
+    if(!size)
+      return 0;
   }
+  const mem_plan plan = count_mem_plan(params, size);
+  if(args.size_given)
+    std::cout << plan.total() << " (" << mem_with_suffix(plan.total()) << ")\n";
+  plan.print(std::cout);
 
   return 0;
 }
@@ -14,13 +14,79 @@
     along with Jellyfish.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <fstream>
+#include <vector>
+#include <memory>
+
 #include <jellyfish/file_header.hpp>
 #include <jellyfish/merge_files.hpp>
+#include <jellyfish/mer_dna_bloom_counter.hpp>
+#include <jellyfish/progress.hpp>
+#include <jellyfish/trace.hpp>
 
 #include <sub_commands/merge_main_cmdline.hpp>
 
 namespace err = jellyfish::err;
 
+using jellyfish::mer_dna;
+using jellyfish::mer_dna_cuckoo_filter;
+using jellyfish::mer_dna_cuckoo_filter_file;
+
+static const char* cuckoo_format = "bloomcounter/cuckoo";
+
+// Add the counts of cuckoo filters. They must have the same size and
+// hash functions, i.e. be created with bc --cuckoo --like.
+void merge_cuckoo_filters(const std::vector<const char*>& inputs, const char* output,
+                          jellyfish::file_header& out_header) {
+  std::ifstream in(inputs[0], std::ios::in|std::ios::binary);
+  jellyfish::file_header header(in);
+  mer_dna::k(header.key_len() / 2);
+  jellyfish::hash_pair<mer_dna> fns(header.matrix(1), header.matrix(2));
+  mer_dna_cuckoo_filter filter(header.size(), header.nb_hashes(), in, fns);
+  if(!in.good())
+    err::die(err::msg() << "Cuckoo filter file '" << inputs[0] << "' is truncated");
+  in.close();
+
+  for(size_t i = 1; i < inputs.size(); ++i) {
+    std::ifstream other_in(inputs[i], std::ios::in|std::ios::binary);
+    jellyfish::file_header other_header(other_in);
+    if(!other_in.good())
+      err::die(err::msg() << "Failed to parse header of file '" << inputs[i] << "'");
+    other_in.close();
+    if(other_header.format() != cuckoo_format || other_header.size() != header.size() ||
+       other_header.key_len() != header.key_len() || other_header.canonical() != header.canonical() ||
+       !(other_header.matrix(1) == header.matrix(1)) || !(other_header.matrix(2) == header.matrix(2)))
+      err::die(err::msg() << "Cuckoo filter '" << inputs[i] << "' can't be merged with '" << inputs[0]
+               << "'. Create it with bc --cuckoo --like " << inputs[0]);
+    try {
+      mer_dna_cuckoo_filter_file other(other_header.size(), other_header.nb_hashes(), inputs[i], fns,
+                                       other_header.offset());
+      other.file().sequential();
+      if(!filter.merge(other))
+        err::die(err::msg() << "The cuckoo filter is full after merging '" << inputs[i] << "'");
+    } catch(std::runtime_error& e) {
+      err::die(err::msg() << "Failed to load cuckoo filter: " << e.what());
+    }
+  }
+
+  out_header.format(cuckoo_format);
+  out_header.alignment(mer_dna_cuckoo_filter::bucket_bytes);
+  out_header.key_len(header.key_len());
+  out_header.canonical(header.canonical());
+  out_header.matrix(fns.m1, 1);
+  out_header.matrix(fns.m2, 2);
+  out_header.size(filter.m());
+  out_header.nb_hashes(filter.k());
+  std::ofstream out(output);
+  if(!out.good())
+    err::die(err::msg() << "Can't open output file '" << output << "'");
+  out_header.write(out);
+  filter.write_bits(out);
+  out.close();
+  if(!out.good())
+    err::die(err::msg() << "Error writing output file '" << output << "'");
+}
+
 int merge_main(int argc, char *argv[])
 {
   jellyfish::file_header out_header;
@@ -30,6 +96,17 @@ int merge_main(int argc, char *argv[])
   merge_main_cmdline args(argc, argv);
   uint64_t min = args.lower_count_given ? args.lower_count_arg : 0;
   uint64_t max = args.upper_count_given ? args.upper_count_arg : std::numeric_limits<uint64_t>::max();
+  std::unique_ptr<jellyfish::progress_reporter> reporter(jellyfish::make_progress_reporter("merge", args));
+  std::unique_ptr<jellyfish::trace> trace(jellyfish::make_trace("merge", args));
+
+  std::ifstream first(args.input_arg[0], std::ios::in|std::ios::binary);
+  jellyfish::file_header first_header(first);
+  if(first.good() && first_header.format() == cuckoo_format) {
+    first.close();
+    merge_cuckoo_filters(args.input_arg, args.output_arg, out_header);
+    return 0;
+  }
+  first.close();
 
   try {
     merge_files(args.input_arg, args.output_arg, out_header, min, max);
@@ -0,0 +1,277 @@
+/*  This file is part of Jellyfish.
+
+    Jellyfish is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Jellyfish is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Jellyfish.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <vector>
+#include <sstream>
+#include <memory>
+
+#include <jellyfish/err.hpp>
+#include <jellyfish/thread_exec.hpp>
+#include <jellyfish/locks_pthread.hpp>
+#include <jellyfish/file_header.hpp>
+#include <jellyfish/stream_manager.hpp>
+#include <jellyfish/whole_sequence_parser.hpp>
+#include <jellyfish/sequence_mers.hpp>
+#include <jellyfish/read_profile.hpp>
+#include <jellyfish/mer_dna_bloom_counter.hpp>
+#include <jellyfish/fstream_default.hpp>
+#include <jellyfish/jellyfish.hpp>
+#include <sub_commands/profile_main_cmdline.hpp>
+
+namespace err = jellyfish::err;
+
+using jellyfish::mer_dna;
+using jellyfish::mer_dna_bloom_counter;
+using jellyfish::mer_dna_blocked_bloom_counter;
+using jellyfish::mer_dna_count_min_sketch;
+using jellyfish::mer_dna_cuckoo_filter;
+using jellyfish::sequence_mers;
+typedef std::vector<const char*> file_vector;
+typedef jellyfish::stream_manager<file_vector::const_iterator> stream_manager;
+typedef jellyfish::whole_sequence_parser<stream_manager> sequence_parser;
+
+static profile_main_cmdline args;
+
+// Get the counts of all the mers of a read
+template<typename Database>
+void lookup(const Database& db, const std::vector<mer_dna>& mers, std::vector<uint64_t>& counts) {
+  counts.resize(mers.size());
+  for(size_t i = 0; i < mers.size(); ++i)
+    counts[i] = db.check(mers[i]);
+}
+
+// Same as above for databases supporting prefetching. The position
+// returned by the prefetch is stored in counts until the lookup is
+// done, lookahead mers later.
+template<typename Database>
+void lookup_prefetch(const Database& db, const std::vector<mer_dna>& mers, std::vector<uint64_t>& counts) {
+  static const size_t lookahead = 8;
+  const size_t        n         = mers.size();
+  counts.resize(n);
+  for(size_t i = 0; i < std::min(lookahead, n); ++i)
+    counts[i] = db.prefetch(mers[i]);
+  for(size_t i = 0; i < n; ++i) {
+    if(i + lookahead < n)
+      counts[i + lookahead] = db.prefetch(mers[i + lookahead]);
+    counts[i] = db.check(mers[i], counts[i]);
+  }
+}
+void lookup(const binary_hash_query& db, const std::vector<mer_dna>& mers, std::vector<uint64_t>& counts) {
+  lookup_prefetch(db, mers, counts);
+}
+void lookup(const compact_query& db, const std::vector<mer_dna>& mers, std::vector<uint64_t>& counts) {
+  lookup_prefetch(db, mers, counts);
+}
+
+// Each thread takes a buffer of reads from the parser and formats
+// the output in memory. The buffers are numbered when taken from the
+// parser (which has only one producer, hence gives the buffers in
+// order of the input), and are written in that order.
+template<typename Database>
+class read_profiler : public jellyfish::thread_exec {
+  const Database&                    db_;
+  stream_manager                     streams_;
+  sequence_parser                    parser_;
+  const bool                         canonical_;
+  const jellyfish::profile::writer*  binary_;
+  std::ostream&                      out_;
+  std::ostream*                      summary_;
+  const uint64_t                     threshold_;
+
+  jellyfish::locks::pthread::mutex   parser_mutex_;
+  uint64_t                           next_job_;
+  jellyfish::locks::pthread::cond    output_cond_;
+  uint64_t                           next_output_;
+
+public:
+  read_profiler(const Database& db, int nb_threads, file_vector::const_iterator file_begin,
+                file_vector::const_iterator file_end, bool canonical,
+                const jellyfish::profile::writer* binary, std::ostream& out,
+                std::ostream* summary, uint64_t threshold) :
+    db_(db),
+    streams_(file_begin, file_end),
+    parser_(3 * nb_threads, 100, 1, streams_),
+    canonical_(canonical),
+    binary_(binary),
+    out_(out),
+    summary_(summary),
+    threshold_(threshold),
+    next_job_(0),
+    next_output_(0)
+  { }
+
+  virtual void start(int thid) {
+    std::vector<mer_dna>  mers;
+    std::vector<uint64_t> counts, tmp;
+    std::ostringstream    out_buffer, summary_buffer;
+    sequence_mers         it(canonical_);
+    const sequence_mers   it_end(canonical_);
+
+    while(true) {
+      parser_mutex_.lock();
+      sequence_parser::job j(parser_);
+      const uint64_t       job_id = next_job_++;
+      parser_mutex_.unlock();
+      if(j.is_empty()) break;
+
+      out_buffer.str("");
+      summary_buffer.str("");
+      for(size_t i = 0; i < j->nb_filled; ++i) {
+        const jellyfish::header_sequence_qual& read = j->data[i];
+        mers.clear();
+        for(it = read.seq; it != it_end; ++it)
+          mers.push_back(*it);
+        lookup(db_, mers, counts);
+
+        if(binary_) {
+          binary_->write(out_buffer, read.header, counts);
+        } else {
+          out_buffer << ">" << read.header << "\n";
+          for(size_t c = 0; c < counts.size(); ++c)
+            out_buffer << (c ? " " : "") << counts[c];
+          out_buffer << "\n";
+        }
+        if(summary_) {
+          const jellyfish::profile::summary s(counts, threshold_, tmp);
+          summary_buffer << read.header << "\t" << s.nb_mers << "\t" << s.min << "\t" << s.median
+                         << "\t" << s.below << "\n";
+        }
+      }
+
+      output_cond_.lock();
+      while(next_output_ != job_id)
+        output_cond_.wait();
+      const std::string out_str = out_buffer.str();
+      out_.write(out_str.data(), out_str.size());
+      if(summary_) {
+        const std::string summary_str = summary_buffer.str();
+        summary_->write(summary_str.data(), summary_str.size());
+      }
+      ++next_output_;
+      output_cond_.broadcast();
+      output_cond_.unlock();
+    }
+  }
+};
+
+template<typename Database>
+void profile_reads(const Database& db, bool canonical, const jellyfish::profile::writer* binary,
+                   std::ostream& out, std::ostream* summary) {
+  read_profiler<Database> profiler(db, args.threads_arg, args.file_arg.cbegin(), args.file_arg.cend(),
+                                   canonical, binary, out, summary, args.threshold_arg);
+  profiler.exec_join(args.threads_arg);
+}
+
+int profile_main(int argc, char *argv[])
+{
+  args.parse(argc, argv);
+
+  ofstream_default out(args.output_given ? args.output_arg : 0, std::cout,
+                       args.binary_flag ? std::ios::out|std::ios::binary : std::ios::out);
+  if(!out.good())
+    err::die(err::msg() << "Error opening output file '" << args.output_arg << "'");
+  std::unique_ptr<std::ofstream> summary;
+  if(args.summary_given) {
+    summary.reset(new std::ofstream(args.summary_arg));
+    if(!summary->good())
+      err::die(err::msg() << "Error opening summary file '" << args.summary_arg << "'");
+  }
+
+  std::ifstream in(args.db_arg, std::ios::in|std::ios::binary);
+  jellyfish::file_header header(in);
+  if(!in.good())
+    err::die(err::msg() << "Failed to parse header of file '" << args.db_arg << "'");
+  mer_dna::k(header.key_len() / 2);
+
+  std::unique_ptr<jellyfish::profile::writer> binary;
+  if(args.binary_flag) {
+    binary.reset(new jellyfish::profile::writer(args.out_counter_len_arg));
+    jellyfish::file_header out_header;
+    out_header.fill_standard();
+    out_header.set_cmdline(argc, argv);
+    out_header.format(jellyfish::profile::format);
+    out_header.key_len(header.key_len());
+    out_header.canonical(header.canonical());
+    out_header.counter_len(binary->val_len());
+    out_header.write(out);
+  }
+
+  if(header.format() == "bloomcounter") {
+    jellyfish::hash_pair<mer_dna> fns(header.matrix(1), header.matrix(2));
+    mer_dna_bloom_counter filter(header.size(), header.nb_hashes(), in, fns);
+    if(!in.good())
+      err::die("Bloom filter file is truncated");
+    in.close();
+    profile_reads(filter, header.canonical(), binary.get(), out, summary.get());
+  } else if(header.format() == "bloomcounter/blocked") {
+    jellyfish::hash_pair<mer_dna> fns(header.matrix(1), header.matrix(2));
+    mer_dna_blocked_bloom_counter filter(header.size(), header.nb_hashes(), in, fns);
+    if(!in.good())
+      err::die("Bloom filter file is truncated");
+    in.close();
+    profile_reads(filter, header.canonical(), binary.get(), out, summary.get());
+  } else if(header.format() == "bloomcounter/countmin") {
+    jellyfish::hash_pair<mer_dna> fns(header.matrix(1), header.matrix(2));
+    mer_dna_count_min_sketch filter(header.size(), header.nb_hashes(), header.counter_bits(), in, fns);
+    if(!in.good())
+      err::die("Bloom filter file is truncated");
+    in.close();
+    profile_reads(filter, header.canonical(), binary.get(), out, summary.get());
+  } else if(header.format() == "bloomcounter/cuckoo") {
+    jellyfish::hash_pair<mer_dna> fns(header.matrix(1), header.matrix(2));
+    mer_dna_cuckoo_filter filter(header.size(), header.nb_hashes(), in, fns);
+    if(!in.good())
+      err::die("Bloom filter file is truncated");
+    in.close();
+    profile_reads(filter, header.canonical(), binary.get(), out, summary.get());
+  } else if(header.format() == binary_dumper::format) {
+    in.close();
+    jellyfish::mapped_file binary_map(args.db_arg);
+    if(args.hash_flag) {
+      binary_map.sequential();
+      binary_hash_query hq(binary_map.base() + header.offset(), header.key_len(), header.counter_len(), header.hash_function(),
+                           header.size(), binary_map.length() - header.offset(), args.threads_arg);
+      binary_map.unmap();
+      profile_reads(hq, header.canonical(), binary.get(), out, summary.get());
+    } else {
+      if(!args.no_load_flag)
+        binary_map.load();
+      binary_query bq(binary_map.base() + header.offset(), header.key_len(), header.counter_len(), header.hash_function(),
+                      header.size() - 1, binary_map.length() - header.offset());
+      profile_reads(bq, header.canonical(), binary.get(), out, summary.get());
+    }
+  } else if(header.format() == jellyfish::compact::format) {
+    in.close();
+    jellyfish::mapped_file compact_map(args.db_arg);
+    if(!args.no_load_flag)
+      compact_map.load();
+    compact_query cq(compact_map.base() + header.offset(), header, compact_map.length() - header.offset());
+    profile_reads(cq, header.canonical(), binary.get(), out, summary.get());
+  } else {
+    err::die(err::msg() << "Unsupported format '" << header.format() << "'. Must be a bloom counter, binary list or compact database.");
+  }
+
+  out.flush();
+  if(!out.good())
+    err::die(err::msg() << "Error writing output file '" << args.output_arg << "'");
+  if(summary) {
+    summary->close();
+    if(!summary->good())
+      err::die(err::msg() << "Error writing summary file '" << args.summary_arg << "'");
+  }
+
+  return 0;
+}
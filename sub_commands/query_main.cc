@@ -15,6 +15,7 @@
 */
 
 #include <vector>
+#include <memory>
 
 #include <jellyfish/err.hpp>
 #include <jellyfish/thread_exec.hpp>
@@ -30,7 +31,10 @@
 namespace err = jellyfish::err;
 
 using jellyfish::mer_dna;
-using jellyfish::mer_dna_bloom_counter;
+using jellyfish::mer_dna_bloom_counter_file;
+using jellyfish::mer_dna_blocked_bloom_counter_file;
+using jellyfish::mer_dna_count_min_sketch_file;
+using jellyfish::mer_dna_cuckoo_filter_file;
 typedef std::vector<const char*> file_vector;
 typedef jellyfish::mer_overlap_sequence_parser<jellyfish::stream_manager<file_vector::iterator> > sequence_parser;
 typedef jellyfish::mer_iterator<sequence_parser, mer_dna> mer_iterator;
@@ -50,6 +54,56 @@ void query_from_sequence(PathIterator file_begin, PathIterator file_end, const D
     out << *mers << " " << db.check(*mers) << "\n";
 }
 
+// Same as above, but the lookup of each k-mer is delayed to let the
+// prefetch of its position in the hash complete.
+template<typename PathIterator, typename Database>
+void query_from_sequence_prefetch(PathIterator file_begin, PathIterator file_end, const Database& db,
+                                  std::ostream& out, bool canonical) {
+  static const uint64_t lookahead = 8;
+  mer_dna  mers[lookahead];
+  size_t   pos[lookahead];
+  uint64_t nb = 0;
+
+  jellyfish::stream_manager<PathIterator> streams(file_begin, file_end);
+  sequence_parser parser(mer_dna::k(), 1, 3, 4096, streams);
+  for(mer_iterator it(parser, canonical); it; ++it, ++nb) {
+    const uint64_t i = nb % lookahead;
+    if(nb >= lookahead)
+      out << mers[i] << " " << db.check(mers[i], pos[i]) << "\n";
+    mers[i] = *it;
+    pos[i]  = db.prefetch(mers[i]);
+  }
+  for(uint64_t j = nb > lookahead ? nb - lookahead : 0; j < nb; ++j) {
+    const uint64_t i = j % lookahead;
+    out << mers[i] << " " << db.check(mers[i], pos[i]) << "\n";
+  }
+}
+
+// Same as above, for bloom counters. The k-mers are looked up in
+// batches with check_many to overlap their memory accesses.
+template<typename PathIterator, typename Database>
+void query_from_sequence_many(PathIterator file_begin, PathIterator file_end, const Database& db,
+                              std::ostream& out, bool canonical) {
+  static const size_t  batch_size = 64;
+  std::vector<mer_dna> mers(batch_size);
+  unsigned int         counts[batch_size];
+  size_t               nb = 0;
+
+  jellyfish::stream_manager<PathIterator> streams(file_begin, file_end);
+  sequence_parser parser(mer_dna::k(), 1, 3, 4096, streams);
+  for(mer_iterator it(parser, canonical); it; ++it) {
+    mers[nb++] = *it;
+    if(nb < batch_size) continue;
+    db.check_many(mers.begin(), mers.end(), counts);
+    for(size_t i = 0; i < nb; ++i)
+      out << mers[i] << " " << counts[i] << "\n";
+    nb = 0;
+  }
+  db.check_many(mers.begin(), mers.begin() + nb, counts);
+  for(size_t i = 0; i < nb; ++i)
+    out << mers[i] << " " << counts[i] << "\n";
+}
+
 template<typename Database>
 void query_from_cmdline(std::vector<const char*> mers, const Database& db, std::ostream& out,
                         bool canonical) {
@@ -83,6 +137,22 @@ void query_from_stdin(const Database& db, std::ostream& out, bool canonical) {
   }
 }
 
+// Bloom counters are mapped read only, pre-faulted when the database
+// would be loaded.
+static int bloom_map_flags(bool load) {
+  return load ? jellyfish::mapped_file::populate_flag() : 0;
+}
+
+template<typename BloomCounter>
+void query_bloom_counter(const BloomCounter& filter, std::ostream& out, bool canonical) {
+  filter.file().random();
+  if(args.huge_pages_flag)
+    filter.file().huge_pages();
+  query_from_sequence_many(args.sequence_arg.begin(), args.sequence_arg.end(), filter, out, canonical);
+  query_from_cmdline(args.mers_arg, filter, out, canonical);
+  if(args.interactive_flag)  query_from_stdin(filter, out, canonical);
+}
+
 int query_main(int argc, char *argv[])
 {
   args.parse(argc, argv);
@@ -96,27 +166,82 @@ int query_main(int argc, char *argv[])
   if(!in.good())
     err::die(err::msg() << "Failed to parse header of file '" << args.file_arg << "'");
   mer_dna::k(header.key_len() / 2);
+  const bool load = !args.no_load_flag &&
+    (args.load_flag || (args.sequence_arg.begin() != args.sequence_arg.end()) || (args.mers_arg.size() > 100));
   if(header.format() == "bloomcounter") {
+    in.close();
     jellyfish::hash_pair<mer_dna> fns(header.matrix(1), header.matrix(2));
-    mer_dna_bloom_counter filter(header.size(), header.nb_hashes(), in, fns);
-    if(!in.good())
-      err::die("Bloom filter file is truncated");
+    std::unique_ptr<mer_dna_bloom_counter_file> filter;
+    try {
+      filter.reset(new mer_dna_bloom_counter_file(header.size(), header.nb_hashes(), args.file_arg, fns,
+                                                  header.offset(), bloom_map_flags(load)));
+    } catch(std::runtime_error& e) {
+      err::die(err::msg() << "Failed to load bloom filter: " << e.what());
+    }
+    query_bloom_counter(*filter, out, header.canonical());
+  } else if(header.format() == "bloomcounter/blocked") {
     in.close();
-    query_from_sequence(args.sequence_arg.begin(), args.sequence_arg.end(), filter, out, header.canonical());
-    query_from_cmdline(args.mers_arg, filter, out, header.canonical());
-    if(args.interactive_flag)  query_from_stdin(filter, out, header.canonical());
+    jellyfish::hash_pair<mer_dna> fns(header.matrix(1), header.matrix(2));
+    std::unique_ptr<mer_dna_blocked_bloom_counter_file> filter;
+    try {
+      filter.reset(new mer_dna_blocked_bloom_counter_file(header.size(), header.nb_hashes(), args.file_arg, fns,
+                                                          header.offset(), bloom_map_flags(load)));
+    } catch(std::runtime_error& e) {
+      err::die(err::msg() << "Failed to load bloom filter: " << e.what());
+    }
+    query_bloom_counter(*filter, out, header.canonical());
+  } else if(header.format() == "bloomcounter/countmin") {
+    in.close();
+    jellyfish::hash_pair<mer_dna> fns(header.matrix(1), header.matrix(2));
+    std::unique_ptr<mer_dna_count_min_sketch_file> filter;
+    try {
+      filter.reset(new mer_dna_count_min_sketch_file(header.size(), header.nb_hashes(), header.counter_bits(),
+                                                     args.file_arg, fns, header.offset(), bloom_map_flags(load)));
+    } catch(std::runtime_error& e) {
+      err::die(err::msg() << "Failed to load bloom filter: " << e.what());
+    }
+    query_bloom_counter(*filter, out, header.canonical());
+  } else if(header.format() == "bloomcounter/cuckoo") {
+    in.close();
+    jellyfish::hash_pair<mer_dna> fns(header.matrix(1), header.matrix(2));
+    std::unique_ptr<mer_dna_cuckoo_filter_file> filter;
+    try {
+      filter.reset(new mer_dna_cuckoo_filter_file(header.size(), header.nb_hashes(), args.file_arg, fns,
+                                                  header.offset(), bloom_map_flags(load)));
+    } catch(std::runtime_error& e) {
+      err::die(err::msg() << "Failed to load bloom filter: " << e.what());
+    }
+    query_bloom_counter(*filter, out, header.canonical());
   } else if(header.format() == binary_dumper::format) {
     jellyfish::mapped_file binary_map(args.file_arg);
-    if(!args.no_load_flag &&
-       (args.load_flag || (args.sequence_arg.begin() != args.sequence_arg.end()) || (args.mers_arg.size() > 100)))
+    if(args.hash_flag) {
+      binary_map.sequential();
+      binary_hash_query hq(binary_map.base() + header.offset(), header.key_len(), header.counter_len(), header.hash_function(),
+                           header.size(), binary_map.length() - header.offset(), args.threads_arg);
+      binary_map.unmap();
+      query_from_sequence_prefetch(args.sequence_arg.begin(), args.sequence_arg.end(), hq, out, header.canonical());
+      query_from_cmdline(args.mers_arg, hq, out, header.canonical());
+      if(args.interactive_flag)  query_from_stdin(hq, out, header.canonical());
+      return 0;
+    }
+    if(load)
       binary_map.load();
-    binary_query bq(binary_map.base() + header.offset(), header.key_len(), header.counter_len(), header.matrix(),
+    binary_query bq(binary_map.base() + header.offset(), header.key_len(), header.counter_len(), header.hash_function(),
                                header.size() - 1, binary_map.length() - header.offset());
     query_from_sequence(args.sequence_arg.begin(), args.sequence_arg.end(), bq, out, header.canonical());
     query_from_cmdline(args.mers_arg, bq, out, header.canonical());
     if(args.interactive_flag)  query_from_stdin(bq, out, header.canonical());
+  } else if(header.format() == jellyfish::compact::format) {
+    in.close();
+    jellyfish::mapped_file compact_map(args.file_arg);
+    if(!args.no_load_flag)
+      compact_map.load();
+    compact_query cq(compact_map.base() + header.offset(), header, compact_map.length() - header.offset());
+    query_from_sequence_prefetch(args.sequence_arg.begin(), args.sequence_arg.end(), cq, out, header.canonical());
+    query_from_cmdline(args.mers_arg, cq, out, header.canonical());
+    if(args.interactive_flag)  query_from_stdin(cq, out, header.canonical());
   } else {
-    err::die(err::msg() << "Unsupported format '" << header.format() << "'. Must be a bloom counter or binary list.");
+    err::die(err::msg() << "Unsupported format '" << header.format() << "'. Must be a bloom counter, binary list or compact database.");
   }
 
   return 0;
@@ -24,23 +24,17 @@
 #include <jellyfish/err.hpp>
 #include <jellyfish/misc.hpp>
 #include <jellyfish/fstream_default.hpp>
+#include <jellyfish/spectrum.hpp>
 #include <jellyfish/jellyfish.hpp>
 #include <sub_commands/stats_main_cmdline.hpp>
 
 namespace err = jellyfish::err;
 
 template<typename reader_type>
-void compute_stats(reader_type& reader, uint64_t low, uint64_t high,
-                   uint64_t& uniq, uint64_t& distinct, uint64_t& total,
-                   uint64_t& max) {
-  uniq = distinct = total = max = 0;
-
+void compute_stats(reader_type& reader, uint64_t low, uint64_t high, jellyfish::spectrum& stats) {
   while(reader.next()) {
     if(reader.val() < low || reader.val() > high) continue;
-    uniq  += reader.val() == 1;
-    total += reader.val();
-    max    = std::max(max, reader.val());
-    ++distinct;
+    stats.add(reader.val());
   }
 }
 
@@ -62,21 +56,18 @@ int stats_main(int argc, char *argv[])
 
   if(!args.upper_count_given)
     args.upper_count_arg = std::numeric_limits<uint64_t>::max();
-  uint64_t uniq = 0, distinct = 0, total = 0, max = 0;
+  jellyfish::spectrum stats;
   if(!header.format().compare(binary_dumper::format)) {
     binary_reader reader(is, &header);
-    compute_stats(reader, args.lower_count_arg, args.upper_count_arg, uniq, distinct, total, max);
+    compute_stats(reader, args.lower_count_arg, args.upper_count_arg, stats);
   } else if(!header.format().compare(text_dumper::format)) {
     text_reader reader(is, &header);
-    compute_stats(reader, args.lower_count_arg, args.upper_count_arg, uniq, distinct, total, max);
+    compute_stats(reader, args.lower_count_arg, args.upper_count_arg, stats);
   } else {
     err::die(err::msg() << "Unknown format '" << header.format() << "'");
   }
 
-  out << "Unique:    " << uniq << "\n"
-      << "Distinct:  " << distinct << "\n"
-      << "Total:     " << total << "\n"
-      << "Max_count: " << max << "\n";
+  stats.write_stats(out);
   out.close();
 
   return 0;
@@ -0,0 +1,123 @@
+/*  This file is part of Jellyfish.
+
+    Jellyfish is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Jellyfish is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Jellyfish.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdint.h>
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <limits>
+
+#include <jellyfish/err.hpp>
+#include <jellyfish/thread_exec.hpp>
+#include <jellyfish/mapped_file.hpp>
+#include <jellyfish/fstream_default.hpp>
+#include <jellyfish/top_mers.hpp>
+#include <jellyfish/database_chunks.hpp>
+#include <jellyfish/jellyfish.hpp>
+#include <sub_commands/top_main_cmdline.hpp>
+
+namespace err = jellyfish::err;
+
+using jellyfish::mer_dna;
+typedef jellyfish::top_mers<mer_dna, uint64_t> top_mers;
+
+static top_main_cmdline args; // Command line switches and arguments
+
+// Number of records (binary format) or bytes (text format) in a chunk
+static const size_t records_per_chunk = (size_t)1 << 18;
+static const size_t bytes_per_chunk   = (size_t)1 << 24;
+
+// Each thread takes the next chunk of the database and keeps the
+// best k-mers it has seen.
+template<typename Chunks>
+class top_finder : public jellyfish::thread_exec {
+  const Chunks&         chunks_;
+  const uint64_t        min_, max_;
+  std::vector<top_mers> tops_;
+  size_t                next_chunk_;
+
+public:
+  top_finder(const Chunks& chunks, int nb_threads, size_t n, uint64_t min, uint64_t max) :
+    chunks_(chunks), min_(min), max_(max), tops_(nb_threads, top_mers(n)), next_chunk_(0)
+  { }
+
+  virtual void start(int thid) {
+    top_mers& top = tops_[thid];
+    for(size_t i = __sync_fetch_and_add(&next_chunk_, 1); i < chunks_.size(); i = __sync_fetch_and_add(&next_chunk_, 1)) {
+      typename Chunks::reader it = chunks_.chunk(i);
+      while(it.next()) {
+        const uint64_t val = it.val();
+        if(val >= min_ && val <= max_)
+          top.add(it.key(), val);
+      }
+    }
+  }
+
+  void top(top_mers& res) const {
+    for(auto it = tops_.cbegin(); it != tops_.cend(); ++it)
+      res += *it;
+  }
+};
+
+template<typename Chunks>
+void find_top(const Chunks& chunks, top_mers& res, uint64_t min, uint64_t max) {
+  top_finder<Chunks> finder(chunks, args.threads_arg, res.capacity(), min, max);
+  finder.exec_join(args.threads_arg);
+  finder.top(res);
+}
+
+int top_main(int argc, char *argv[])
+{
+  args.parse(argc, argv);
+
+  std::ifstream is(args.db_arg);
+  if(!is.good())
+    err::die(err::msg() << "Failed to open input file '" << args.db_arg << "'");
+  jellyfish::file_header header;
+  header.read(is);
+  is.close();
+  mer_dna::k(header.key_len() / 2);
+
+  ofstream_default out(args.output_given ? args.output_arg : 0, std::cout);
+  if(!out.good())
+    err::die(err::msg() << "Error opening output file '" << args.output_arg << "'");
+
+  jellyfish::mapped_file map(args.db_arg);
+  map.sequential().will_need();
+  const char* const data   = map.base() + header.offset();
+  const size_t      length = map.length() - header.offset();
+
+  const uint64_t min = args.lower_count_given ? args.lower_count_arg : 0;
+  const uint64_t max = args.upper_count_given ? args.upper_count_arg : std::numeric_limits<uint64_t>::max();
+  top_mers       top(args.top_n_arg);
+  if(!header.format().compare(binary_dumper::format)) {
+    jellyfish::binary_chunks<mer_dna, uint64_t> chunks(data, header.key_len(), header.counter_len(), length,
+                                                       records_per_chunk);
+    find_top(chunks, top, min, max);
+  } else if(!header.format().compare(text_dumper::format)) {
+    jellyfish::text_chunks<mer_dna, uint64_t> chunks(data, length, bytes_per_chunk);
+    find_top(chunks, top, min, max);
+  } else {
+    err::die(err::msg() << "Unknown format '" << header.format() << "'");
+  }
+
+  top.write(out, args.tab_flag ? '\t' : ' ');
+  out.flush();
+  if(!out.good())
+    err::die("Error writing output");
+
+  return 0;
+}
@@ -4,6 +4,36 @@
 %{
   class HashCounter : public jellyfish::cooperative::hash_counter<jellyfish::mer_dna> {
     typedef jellyfish::cooperative::hash_counter<jellyfish::mer_dna> super;
+
+    // Add the k-mers of the sequences, each thread taking the next
+    // sequence in turn.
+    class adder : public jellyfish::thread_exec {
+      HashCounter&                    hash_;
+      const std::vector<const char*>& seqs_;
+      const std::vector<size_t>&      lens_;
+      const bool                      canonical_;
+      size_t                          next_;
+      uint64_t                        added_;
+
+    public:
+      adder(HashCounter& hash, const std::vector<const char*>& seqs, const std::vector<size_t>& lens, bool canonical) :
+        hash_(hash), seqs_(seqs), lens_(lens), canonical_(canonical), next_(0), added_(0)
+      { }
+      uint64_t added() const { return added_; }
+
+      virtual void start(int thid) {
+        uint64_t added = 0;
+        for(size_t i = __sync_fetch_and_add(&next_, 1); i < seqs_.size(); i = __sync_fetch_and_add(&next_, 1)) {
+          string_mers::for_each(seqs_[i], lens_[i], canonical_, [&](const jellyfish::mer_dna& m, size_t pos) {
+              hash_.super::add(m, 1);
+              ++added;
+            });
+        }
+        __sync_fetch_and_add(&added_, added);
+        hash_.done();
+      }
+    };
+
   public:
     HashCounter(size_t size, unsigned int val_len, unsigned int nb_threads = 1) : \
     super(size, jellyfish::mer_dna::k() * 2, val_len, nb_threads)
@@ -16,6 +46,21 @@
       return res;
     }
 
+    uint64_t count(const jellyfish::mer_dna& m) const {
+      uint64_t val;
+      return ary()->get_val_for_key(m, &val) ? val : 0;
+    }
+
+    // Add every k-mer of the sequences with the number of threads
+    // given to the constructor. No other thread may use the hash
+    // meanwhile. Returns the number of k-mers added.
+    uint64_t add_sequences(const std::vector<const char*>& seqs, const std::vector<size_t>& lens, bool canonical) {
+      adder a(*this, seqs, lens, canonical);
+      a.exec_join(nb_threads_);
+      done_threads_ = 0; // Ready for the next batch
+      return a.added();
+    }
+
   };
 %}
 
@@ -23,6 +23,9 @@
 %}
 
 %include "mer_dna.i"
+%include "string_mers.i"
 %include "mer_file.i"
 %include "hash_counter.i"
 %include "hash_set.i"
+%include "sequences.i"
+%include "mer_array.i"
@@ -0,0 +1,161 @@
+/**************************************************************/
+/* Zero-copy arrays over a binary/sorted database (NumPy). The */
+/* file is memory mapped and the keys and counts are strided   */
+/* views of the records: no Python object per record.          */
+/**************************************************************/
+#ifdef SWIGPYTHON
+%{
+  // Layout of the records of a binary/sorted database: each record
+  // is the key (2 bits per base, little endian) followed by the
+  // count (little endian).
+  class MerFileLayout {
+    size_t       offset_;
+    unsigned int k_;
+    unsigned int key_bytes_;
+    unsigned int val_bytes_;
+    size_t       nb_records_;
+
+  public:
+    MerFileLayout(const char* path) throw(std::runtime_error) {
+      std::ifstream in(path);
+      if(!in.good())
+        throw std::runtime_error(std::string("Can't open file '") + path + "'");
+      jellyfish::file_header header(in);
+      if(header.format() != binary_dumper::format)
+        throw std::runtime_error(std::string("Unsupported format '") + header.format() + "', expected '" +
+                                 binary_dumper::format + "'");
+      offset_    = header.offset();
+      k_         = header.key_len() / 2;
+      key_bytes_ = header.key_len() / 8 + (header.key_len() % 8 != 0);
+      val_bytes_ = header.counter_len();
+      in.seekg(0, std::ios::end);
+      const size_t length = (size_t)in.tellg() - offset_;
+      if(length % record_len() != 0)
+        throw std::runtime_error(std::string("Length of file '") + path + "' is not a multiple of the record length");
+      nb_records_ = length / record_len();
+    }
+
+    size_t       offset() const { return offset_; }
+    unsigned int k() const { return k_; }
+    unsigned int key_bytes() const { return key_bytes_; }
+    unsigned int val_bytes() const { return val_bytes_; }
+    unsigned int record_len() const { return key_bytes_ + val_bytes_; }
+    size_t       nb_records() const { return nb_records_; }
+  };
+%}
+
+%feature("autodoc", "Layout of the records of a binary/sorted Jellyfish database");
+class MerFileLayout {
+public:
+  %feature("autodoc", "Read the header of the database");
+  MerFileLayout(const char* path) throw(std::runtime_error);
+  %feature("autodoc", "Offset of the first record in the file");
+  size_t offset() const;
+  %feature("autodoc", "Length of the k-mers");
+  unsigned int k() const;
+  %feature("autodoc", "Length of a key in bytes");
+  unsigned int key_bytes() const;
+  %feature("autodoc", "Length of a count in bytes");
+  unsigned int val_bytes() const;
+  %feature("autodoc", "Length of a record (key and count) in bytes");
+  unsigned int record_len() const;
+  %feature("autodoc", "Number of records in the database");
+  size_t nb_records() const;
+};
+
+%pythoncode %{
+def decode_keys(raw, k):
+    """Decode packed keys (a uint8 array of shape (n, key_bytes), as
+    MerArray.raw_keys) into an array of n byte strings of k bases."""
+    import numpy as np
+    raw   = np.asarray(raw, dtype=np.uint8)
+    pos   = 2 * (k - 1 - np.arange(k))  # Bit position of each base
+    codes = (raw[:, pos // 8] >> (pos % 8).astype(np.uint8)) & 3
+    bases = np.ascontiguousarray(np.frombuffer(b"ACGT", dtype=np.uint8)[codes])
+    return bases.view("S%d" % k).reshape(-1)
+
+def encode_keys(mers):
+    """Pack a list of k-mers (str or bytes, all of the same length, k <=
+    32) into a uint64 array, as MerArray.keys returns them."""
+    import numpy as np
+    mers  = np.asarray([m.encode() if isinstance(m, str) else m for m in mers])
+    k     = mers.dtype.itemsize
+    if k > 32: raise ValueError("k-mers longer than 32 bases do not fit in 64 bits")
+    codes = np.zeros(256, dtype=np.uint64)
+    codes[np.frombuffer(b"CcGgTt", dtype=np.uint8)] = [1, 1, 2, 2, 3, 3]
+    bases = codes[mers.view(np.uint8).reshape(-1, k)]
+    return (bases << (2 * (k - 1 - np.arange(k, dtype=np.uint64)))).sum(axis=1, dtype=np.uint64)
+
+class MerArray(object):
+    """Records of a binary/sorted database as NumPy arrays. The file is
+    memory mapped: the arrays are views of the file, read from disk
+    when accessed, and a slice of records (or the chunks() iterator)
+    only touches the corresponding part of the file."""
+    def __init__(self, path, start=0, stop=None, _mm=None):
+        import mmap
+        self.layout = MerFileLayout(path)
+        self.path   = path
+        self.k      = self.layout.k()
+        if _mm is None:
+            with open(path, "rb") as f:
+                _mm = mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ)
+        self._mm                     = _mm
+        self.start, self.stop, step = slice(start, stop).indices(self.layout.nb_records())
+        if self.stop < self.start: self.stop = self.start
+
+    def __len__(self):
+        return self.stop - self.start
+
+    def __getitem__(self, s):
+        if not isinstance(s, slice) or s.step not in (None, 1):
+            raise TypeError("MerArray only supports contiguous slices")
+        start, stop, step = s.indices(len(self))
+        return MerArray(self.path, self.start + start, self.start + max(start, stop), self._mm)
+
+    def chunks(self, size=1 << 20):
+        """Iterate over the records by slices of size records"""
+        for i in range(0, len(self), size):
+            yield self[i:i + size]
+
+    def _view(self, dtype, shift, shape, strides):
+        import numpy as np
+        offset = self.layout.offset() + self.start * self.layout.record_len() + shift
+        return np.ndarray(shape, dtype=dtype, buffer=self._mm, offset=offset, strides=strides)
+
+    @property
+    def records(self):
+        """Records as an array of shape (n, record_len) of uint8"""
+        import numpy as np
+        return self._view(np.uint8, 0, (len(self), self.layout.record_len()), (self.layout.record_len(), 1))
+
+    @property
+    def raw_keys(self):
+        """Packed keys as an array of shape (n, key_bytes) of uint8"""
+        return self.records[:, :self.layout.key_bytes()]
+
+    @property
+    def keys(self):
+        """Keys as an array of uint64 (k <= 32). A view of the file if the
+        keys are 1, 2, 4 or 8 bytes long, a copy otherwise"""
+        return self._uint(0, self.layout.key_bytes())
+
+    @property
+    def counts(self):
+        """Counts as an array of unsigned integers. A view of the file if
+        the counts are 1, 2, 4 or 8 bytes long, a uint64 copy otherwise"""
+        return self._uint(self.layout.key_bytes(), self.layout.val_bytes())
+
+    def mers(self):
+        """k-mers as an array of byte strings"""
+        return decode_keys(self.raw_keys, self.k)
+
+    def _uint(self, shift, nb):
+        import numpy as np
+        if nb > 8: raise ValueError("Field of %d bytes does not fit in 64 bits" % nb)
+        if nb in (1, 2, 4, 8):
+            return self._view(np.dtype("<u%d" % nb), shift, (len(self),), (self.layout.record_len(),))
+        res = np.zeros((len(self), 8), dtype=np.uint8)
+        res[:, :nb] = self.records[:, shift:shift + nb]
+        return res.view("<u8").reshape(-1)
+%}
+#endif
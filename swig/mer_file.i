@@ -4,8 +4,12 @@
 %{
   class QueryMerFile {
     std::unique_ptr<jellyfish::mer_dna_bloom_filter> bf;
+    std::unique_ptr<jellyfish::mer_dna_blocked_bloom_counter> bbc;
+    std::unique_ptr<jellyfish::mer_dna_count_min_sketch>      cms;
+    std::unique_ptr<jellyfish::mer_dna_cuckoo_filter>         cf;
     jellyfish::mapped_file                           binary_map;
     std::unique_ptr<binary_query>                    jf;
+    std::unique_ptr<compact_query>                   cq;
 
   public:
     QueryMerFile(const char* path) throw(std::runtime_error) {
@@ -19,19 +23,48 @@
         bf.reset(new jellyfish::mer_dna_bloom_filter(header.size(), header.nb_hashes(), in, fns));
         if(!in.good())
           throw std::runtime_error("Bloom filter file is truncated");
+      } else if(header.format() == "bloomcounter/blocked") {
+        jellyfish::hash_pair<jellyfish::mer_dna> fns(header.matrix(1), header.matrix(2));
+        bbc.reset(new jellyfish::mer_dna_blocked_bloom_counter(header.size(), header.nb_hashes(), in, fns));
+        if(!in.good())
+          throw std::runtime_error("Bloom filter file is truncated");
+      } else if(header.format() == "bloomcounter/countmin") {
+        jellyfish::hash_pair<jellyfish::mer_dna> fns(header.matrix(1), header.matrix(2));
+        cms.reset(new jellyfish::mer_dna_count_min_sketch(header.size(), header.nb_hashes(), header.counter_bits(), in, fns));
+        if(!in.good())
+          throw std::runtime_error("Bloom filter file is truncated");
+      } else if(header.format() == "bloomcounter/cuckoo") {
+        jellyfish::hash_pair<jellyfish::mer_dna> fns(header.matrix(1), header.matrix(2));
+        cf.reset(new jellyfish::mer_dna_cuckoo_filter(header.size(), header.nb_hashes(), in, fns));
+        if(!in.good())
+          throw std::runtime_error("Bloom filter file is truncated");
       } else if(header.format() == "binary/sorted") {
         binary_map.map(path);
-        jf.reset(new binary_query(binary_map.base() + header.offset(), header.key_len(), header.counter_len(), header.matrix(),
+        jf.reset(new binary_query(binary_map.base() + header.offset(), header.key_len(), header.counter_len(), header.hash_function(),
                                   header.size() - 1, binary_map.length() - header.offset()));
+      } else if(header.format() == jellyfish::compact::format) {
+        binary_map.map(path);
+        cq.reset(new compact_query(binary_map.base() + header.offset(), header, binary_map.length() - header.offset()));
       } else {
         throw std::runtime_error(std::string("Unsupported format '") + header.format() + "'");
       }
     }
 
+    unsigned int check(const jellyfish::mer_dna& m) const {
+      return jf ? jf->check(m) : (cq ? cq->check(m) : (bbc ? bbc->check(m) : (cms ? cms->check(m) : (cf ? cf->check(m) : bf->check(m)))));
+    }
+    // Thread safe version of check
+    uint64_t count(const jellyfish::mer_dna& m) const {
+      if(jf) {
+        jellyfish::mer_dna mid_key;
+        return jf->check(m, mid_key);
+      }
+      return check(m);
+    }
 #ifdef SWIGPERL
-    unsigned int get(const MerDNA& m) { return jf ? jf->check(m) : bf->check(m); }
+    unsigned int get(const MerDNA& m) { return check(m); }
 #else
-    unsigned int __getitem__(const MerDNA& m) { return jf ? jf->check(m) : bf->check(m); }
+    unsigned int __getitem__(const MerDNA& m) { return check(m); }
 #endif
   };
 %}
@@ -33,6 +33,26 @@ class TestHashCounter(unittest.TestCase):
             if not good: break
         self.assertTrue(good)
 
+    def test_count_sequences(self):
+        jellyfish.MerDNA.k(15)
+        hash  = jellyfish.HashCounter(16, 5, 2)
+        seqs  = ["".join(random.choice("ACGT") for _ in range(random.randrange(200))) for _ in range(50)]
+        seqs += ["ACGTNNACGTACGTACGTACGTAC", b"TTTTTTTTTTTTTTTTTTTT"]
+        nb    = sum(max(0, len(s) - 15 + 1) for s in seqs) - 6
+        self.assertEqual(nb, hash.count_sequences(seqs))
+        self.assertEqual(nb, hash.count_sequences(seqs, 2))
+        self.assertRaises(ValueError, hash.count_sequences, seqs, 3)
+
+        counts = hash.query_many(seqs, 3)
+        self.assertEqual(len(seqs), len(counts))
+        for seq, count in zip(seqs, counts):
+            if isinstance(seq, bytes): seq = seq.decode()
+            self.assertEqual(max(0, len(seq) - 15 + 1), len(count))
+            self.assertEqual(list(count), list(hash.query_sequence(seq)))
+            for i, c in enumerate(count):
+                m = seq[i:i+15]
+                self.assertEqual(0 if "N" in m else hash[jellyfish.MerDNA(m)], c)
+
 
 if __name__ == '__main__':
     data = sys.argv.pop(1)
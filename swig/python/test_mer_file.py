@@ -2,7 +2,12 @@ import jellyfish
 import unittest
 import sys
 import os
+import random
 from collections import Counter
+try:
+    import numpy
+except ImportError:
+    numpy = None
 
 class TestMerFile(unittest.TestCase):
     def setUp(self):
@@ -52,6 +57,58 @@ class TestMerFile(unittest.TestCase):
             if not good: break
         self.assertTrue(good)
 
+    def test_query_compact(self):
+        good = True
+        qf   = jellyfish.QueryMerFile(os.path.join(data, "swig_python.mphf"))
+        for mer, count in self.mf:
+            good = good and count == qf[mer]
+            if not good: break
+        self.assertTrue(good)
+
+    def test_query_sequence(self):
+        qf   = jellyfish.QueryMerFile(os.path.join(data, "swig_python.jf"))
+        k    = jellyfish.MerDNA.k()
+        seqs = []
+        for mer, count in self.mf:
+            seqs.append(str(mer))
+            if len(seqs) >= 100: break
+        seq    = "".join(seqs)
+        counts = qf.query_sequence(seq)
+        self.assertEqual(len(seq) - k + 1, len(counts))
+        for i, c in enumerate(counts):
+            self.assertEqual(qf[jellyfish.MerDNA(seq[i:i+k])], c)
+        many = qf.query_many(seqs, 2)
+        self.assertEqual([[qf[jellyfish.MerDNA(s)]] for s in seqs], [list(c) for c in many])
+
+    def test_query_many_threads(self):
+        # Concurrent lookups in a binary database
+        qf    = jellyfish.QueryMerFile(os.path.join(data, "swig_python.jf"))
+        k     = jellyfish.MerDNA.k()
+        mers  = [str(mer) for mer, count in self.mf][:20000]
+        seqs  = ["".join(mers[i:i+50]) for i in range(0, len(mers), 50)]
+        seqs += ["".join(random.choice("ACGT") for _ in range(200)) for _ in range(20)]
+        expected = [[qf[jellyfish.MerDNA(s[i:i+k])] for i in range(len(s) - k + 1)] for s in seqs]
+        for threads in (1, 4, 8):
+            self.assertEqual(expected, [list(c) for c in qf.query_many(seqs, threads)])
+
+    @unittest.skipUnless(numpy, "NumPy is not installed")
+    def test_array(self):
+        a = jellyfish.MerArray(os.path.join(data, "swig_python.jf"))
+        mers, counts = a.mers(), a.counts
+        self.assertEqual(len(a), len(counts))
+        i = 0
+        for mer, count in self.mf:
+            self.assertEqual(str(mer), mers[i].decode())
+            self.assertEqual(count, counts[i])
+            i += 1
+        self.assertEqual(len(a), i)
+        chunks = list(a.chunks(1000))
+        self.assertEqual(len(a), sum(len(c) for c in chunks))
+        self.assertTrue((numpy.concatenate([c.counts for c in chunks]) == counts).all())
+        self.assertTrue((jellyfish.decode_keys(a[10:20].raw_keys, a.k) == mers[10:20]).all())
+        if a.k <= 32:
+            self.assertTrue((jellyfish.encode_keys(mers) == a.keys).all())
+
 if __name__ == '__main__':
     data = sys.argv.pop(1)
     unittest.main()
@@ -0,0 +1,177 @@
+/************************************************************/
+/* Batch counting and querying of whole sequences. The work */
+/* is done in C++ threads, without the GIL, and the counts  */
+/* are returned as arrays (memoryview of unsigned 64 bits). */
+/************************************************************/
+#ifdef SWIGPYTHON
+%{
+  namespace python_sequences {
+    // Sequences from a str, a bytes or an iterable of them. The data
+    // is owned by the bytes objects kept in objs_.
+    class sequences {
+      std::vector<PyObject*> objs_;
+
+      bool add(PyObject* o) {
+        PyObject* bytes = 0;
+        if(PyUnicode_Check(o)) {
+          bytes = PyUnicode_AsASCIIString(o);
+        } else if(PyBytes_Check(o)) {
+          Py_INCREF(o);
+          bytes = o;
+        } else {
+          PyErr_SetString(PyExc_TypeError, "A sequence must be a str or bytes");
+        }
+        if(!bytes)
+          return false;
+        objs_.push_back(bytes);
+        seqs.push_back(PyBytes_AS_STRING(bytes));
+        lens.push_back(PyBytes_GET_SIZE(bytes));
+        return true;
+      }
+
+    public:
+      std::vector<const char*> seqs;
+      std::vector<size_t>      lens;
+
+      ~sequences() {
+        for(auto it = objs_.begin(); it != objs_.end(); ++it)
+          Py_DECREF(*it);
+      }
+
+      // Parse a single sequence or, if many is true, a single
+      // sequence or an iterable of sequences.
+      bool parse(PyObject* o, bool many) {
+        if(!many || PyUnicode_Check(o) || PyBytes_Check(o))
+          return add(o);
+        PyObject* it = PyObject_GetIter(o);
+        if(!it)
+          return false;
+        bool      res = true;
+        PyObject* item;
+        while(res && (item = PyIter_Next(it))) {
+          res = add(item);
+          Py_DECREF(item);
+        }
+        Py_DECREF(it);
+        return res && !PyErr_Occurred();
+      }
+    };
+
+    // Memoryview of unsigned 64 bits integers on a bytearray. Steals
+    // the reference to the bytearray.
+    PyObject* counts_view(PyObject* bytes) {
+      PyObject* view = PyMemoryView_FromObject(bytes);
+      Py_DECREF(bytes);
+      if(!view)
+        return 0;
+      PyObject* res = PyObject_CallMethod(view, "cast", "s", "Q");
+      Py_DECREF(view);
+      return res;
+    }
+
+    // Counts of every k-mer position of the sequences, as one array
+    // or, if many is true, a list of arrays.
+    template<typename Query>
+    PyObject* query(const Query& q, PyObject* seqs, unsigned int threads, bool canonical, bool many) {
+      sequences s;
+      if(!s.parse(seqs, many))
+        return 0;
+      const size_t           nb = s.seqs.size();
+      std::vector<PyObject*> outs(nb, (PyObject*)0);
+      std::vector<uint64_t*> counts(nb, (uint64_t*)0);
+      for(size_t i = 0; i < nb; ++i) {
+        outs[i] = PyByteArray_FromStringAndSize(0, string_mers::nb_positions(s.lens[i]) * sizeof(uint64_t));
+        if(!outs[i]) {
+          for(size_t j = 0; j < i; ++j)
+            Py_DECREF(outs[j]);
+          return 0;
+        }
+        counts[i] = (uint64_t*)PyByteArray_AS_STRING(outs[i]);
+      }
+
+      std::string error;
+      Py_BEGIN_ALLOW_THREADS
+      try {
+        string_mers::query_all<Query> all(q, s.seqs, s.lens, counts, canonical);
+        if(threads > 1 && nb > 1)
+          all.exec_join(std::min((size_t)threads, nb));
+        else
+          all.start(0);
+      } catch(std::exception& e) {
+        error = e.what();
+      }
+      Py_END_ALLOW_THREADS
+
+      if(!error.empty()) {
+        for(size_t i = 0; i < nb; ++i)
+          Py_DECREF(outs[i]);
+        PyErr_SetString(PyExc_RuntimeError, error.c_str());
+        return 0;
+      }
+      if(!many)
+        return counts_view(outs[0]);
+      PyObject* res = PyList_New(nb);
+      for(size_t i = 0; i < nb; ++i) {
+        PyObject* view = res ? counts_view(outs[i]) : (Py_DECREF(outs[i]), (PyObject*)0);
+        if(view) {
+          PyList_SET_ITEM(res, i, view);
+        } else if(res) { // Release the list, and the bytearrays not yet in it
+          Py_DECREF(res);
+          res = 0;
+        }
+      }
+      return res;
+    }
+
+    PyObject* count(HashCounter& hash, PyObject* seqs, unsigned int threads, bool canonical) {
+      if(threads && threads != hash.nb_threads())
+        return PyErr_Format(PyExc_ValueError, "The hash was created for %u threads, not %u",
+                            (unsigned int)hash.nb_threads(), threads);
+      sequences s;
+      if(!s.parse(seqs, true))
+        return 0;
+
+      uint64_t    added = 0;
+      std::string error;
+      Py_BEGIN_ALLOW_THREADS
+      try {
+        added = hash.add_sequences(s.seqs, s.lens, canonical);
+      } catch(std::exception& e) {
+        error = e.what();
+      }
+      Py_END_ALLOW_THREADS
+      if(!error.empty()) {
+        PyErr_SetString(PyExc_RuntimeError, error.c_str());
+        return 0;
+      }
+      return PyLong_FromUnsignedLongLong(added);
+    }
+  } // namespace python_sequences
+%}
+
+%extend HashCounter {
+  %feature("autodoc", "Add 1 for every k-mer of a sequence or a list of sequences, with the threads of the hash (given to the constructor). The GIL is released. Returns the number of k-mers added");
+  PyObject* count_sequences(PyObject* seqs, unsigned int threads = 0, bool canonical = false) {
+    return python_sequences::count(*$self, seqs, threads, canonical);
+  }
+  %feature("autodoc", "Count of every k-mer of the sequence, as an array of unsigned 64 bits integers. 0 for a k-mer absent or with a base other than ACGT");
+  PyObject* query_sequence(PyObject* seq, bool canonical = false) {
+    return python_sequences::query(*$self, seq, 1, canonical, false);
+  }
+  %feature("autodoc", "Counts of every k-mer of each sequence, as a list of arrays, computed with threads threads without the GIL");
+  PyObject* query_many(PyObject* seqs, unsigned int threads = 1, bool canonical = false) {
+    return python_sequences::query(*$self, seqs, threads, canonical, true);
+  }
+}
+
+%extend QueryMerFile {
+  %feature("autodoc", "Count of every k-mer of the sequence, as an array of unsigned 64 bits integers. 0 for a k-mer absent or with a base other than ACGT");
+  PyObject* query_sequence(PyObject* seq, bool canonical = false) {
+    return python_sequences::query(*$self, seq, 1, canonical, false);
+  }
+  %feature("autodoc", "Counts of every k-mer of each sequence, as a list of arrays, computed with threads threads without the GIL");
+  PyObject* query_many(PyObject* seqs, unsigned int threads = 1, bool canonical = false) {
+    return python_sequences::query(*$self, seqs, threads, canonical, true);
+  }
+}
+#endif
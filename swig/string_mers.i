@@ -2,5 +2,71 @@
 /* Iterator of all the mers in a string */
 /****************************************/
 %{
+#include <vector>
+#include <algorithm>
+#include <jellyfish/thread_exec.hpp>
 
+  namespace string_mers {
+    // Call f(m, i) for every k-mer m of the sequence, where i is the
+    // position of its first base. A k-mer with a character other than
+    // ACGT is skipped, be it an N, a newline or anything else: i is a
+    // position in the buffer, so no character is ignored as the
+    // parser of files does. Same rule as for_each_mer of the C
+    // interface. If canonical is true, m is the canonical
+    // representation of the k-mer.
+    template<typename F>
+    void for_each(const char* seq, size_t len, bool canonical, F f) {
+      const unsigned int k = jellyfish::mer_dna::k();
+      jellyfish::mer_dna m, rc;
+      unsigned int       filled = 0;
+      for(size_t i = 0; i < len; ++i) {
+        const int code = jellyfish::mer_dna::code(seq[i]);
+        if(code < 0) {
+          filled = 0;
+          continue;
+        }
+        m.shift_left(code);
+        if(canonical)
+          rc.shift_right(jellyfish::mer_dna::complement(code));
+        if(++filled >= k)
+          f(canonical && rc < m ? rc : m, i + 1 - k);
+      }
+    }
+
+    // Number of k-mer positions in a sequence of length len
+    inline size_t nb_positions(size_t len) {
+      const size_t k = jellyfish::mer_dna::k();
+      return len >= k ? len - k + 1 : 0;
+    }
+
+    // Count of every k-mer position of the sequences, with
+    // nb_threads threads. counts[i] must have
+    // nb_positions(lens[i]) entries. Query must have a thread safe
+    // method `uint64_t count(const mer_dna&) const`.
+    template<typename Query>
+    class query_all : public jellyfish::thread_exec {
+      const Query&                    query_;
+      const std::vector<const char*>& seqs_;
+      const std::vector<size_t>&      lens_;
+      const std::vector<uint64_t*>&   counts_;
+      const bool                      canonical_;
+      size_t                          next_;
+
+    public:
+      query_all(const Query& query, const std::vector<const char*>& seqs, const std::vector<size_t>& lens,
+                const std::vector<uint64_t*>& counts, bool canonical) :
+        query_(query), seqs_(seqs), lens_(lens), counts_(counts), canonical_(canonical), next_(0)
+      { }
+
+      virtual void start(int thid) {
+        for(size_t i = __sync_fetch_and_add(&next_, 1); i < seqs_.size(); i = __sync_fetch_and_add(&next_, 1)) {
+          uint64_t* const counts = counts_[i];
+          std::fill(counts, counts + nb_positions(lens_[i]), (uint64_t)0);
+          for_each(seqs_[i], lens_[i], canonical_, [&](const jellyfish::mer_dna& m, size_t pos) {
+              counts[pos] = query_.count(m);
+            });
+        }
+      }
+    };
+  } // namespace string_mers
 %}
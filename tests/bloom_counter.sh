@@ -6,6 +6,10 @@ cd tests
 sort -k2,2 > ${pref}.md5sum <<EOF
 9251799dd5dbd3f617124aa2ff72112a ${pref}.histo
 9251799dd5dbd3f617124aa2ff72112a ${pref}_filtered.histo
+9251799dd5dbd3f617124aa2ff72112a ${pref}_blocked_filtered.histo
+9251799dd5dbd3f617124aa2ff72112a ${pref}_blocked_load.histo
+9251799dd5dbd3f617124aa2ff72112a ${pref}_cuckoo_filtered.histo
+9251799dd5dbd3f617124aa2ff72112a ${pref}_cuckoo_merged.histo
 EOF
 
 cat > ${pref}_commands <<EOF
@@ -44,4 +48,79 @@ QUERY_COL=$($JF query -s seq1m_0.fa ${pref}_none.bc | grep -c ' 2$')
     false
 }
 
+# Same with the cache blocked layout
+$JF bc --blocked -t $nCPUs -o ${pref}_blocked.bc -s 1M -C -m 40 -g ${pref}_commands -G 2
+$JF count -t $nCPUs -o ${pref}_blocked_filtered.jf --bc ${pref}_blocked.bc -s 2M -C -m 40 seq1m_0.fa
+$JF histo ${pref}_blocked_filtered.jf > ${pref}_blocked_filtered.histo
+# Same, with the bloom counter file read upfront in huge pages
+$JF count -t $nCPUs -o ${pref}_blocked_load.jf --bc ${pref}_blocked.bc --bc-load --bc-huge-pages -s 2M -C -m 40 seq1m_0.fa
+$JF histo ${pref}_blocked_load.jf > ${pref}_blocked_load.histo
+
+$JF bc --blocked -t $nCPUs -o ${pref}_blocked_none.bc -s 2M -C -m 40 seq1m_0.fa seq1m_1.fa seq1m_1.fa
+$JF count -t $nCPUs -o ${pref}_blocked_none.jf --bc ${pref}_blocked_none.bc -s 1M -C -m 40 seq1m_0.fa
+$JF histo ${pref}_blocked_none.jf > ${pref}_blocked_none.histo
+BLOCKED_COLLISION=$(cut -d\  -f2 ${pref}_blocked_none.histo)
+[ $((TOTAL / 500 > BLOCKED_COLLISION)) = 1 ] || {
+    echo >&2 "Too many collisions with blocked layout"
+    false
+}
+BLOCKED_QUERY_COL=$($JF query --huge-pages -s seq1m_0.fa ${pref}_blocked_none.bc | grep -c ' 2$')
+[ $BLOCKED_QUERY_COL = $BLOCKED_COLLISION ] || {
+    echo >&2 "Queried count 2 mers should equal collisions with blocked layout"
+    false
+}
+
+# Cuckoo filter, built at once or from two filters merged
+$JF bc --cuckoo -t $nCPUs -o ${pref}_cuckoo.bc -s 1M -C -m 40 -g ${pref}_commands -G 2
+$JF count -t $nCPUs -o ${pref}_cuckoo_filtered.jf --bc ${pref}_cuckoo.bc -s 2M -C -m 40 seq1m_0.fa
+$JF histo ${pref}_cuckoo_filtered.jf > ${pref}_cuckoo_filtered.histo
+
+$JF bc --cuckoo -t $nCPUs -o ${pref}_cuckoo_a.bc -s 1M -C -m 40 seq1m_0.fa
+$JF bc --cuckoo --like ${pref}_cuckoo_a.bc -t $nCPUs -o ${pref}_cuckoo_b.bc -C -m 40 seq1m_0.fa
+$JF merge -o ${pref}_cuckoo_merged.bc ${pref}_cuckoo_a.bc ${pref}_cuckoo_b.bc
+$JF count -t $nCPUs -o ${pref}_cuckoo_merged.jf --bc ${pref}_cuckoo_merged.bc -s 2M -C -m 40 seq1m_0.fa
+$JF histo ${pref}_cuckoo_merged.jf > ${pref}_cuckoo_merged.histo
+CUCKOO_QUERY=$($JF query -s seq1m_0.fa ${pref}_cuckoo_merged.bc | grep -c ' [23]$')
+[ $CUCKOO_QUERY = $TOTAL ] || {
+    echo >&2 "Queried count of merged cuckoo filter should be at least 2 for all mers"
+    false
+}
+$JF bc --cuckoo -t $nCPUs -o ${pref}_cuckoo_large.bc -s 2M -C -m 40 seq1m_0.fa
+if $JF merge -o ${pref}_cuckoo_bad.bc ${pref}_cuckoo_a.bc ${pref}_cuckoo_large.bc 2> /dev/null; then
+    echo >&2 "Merge of cuckoo filters of different sizes should fail"
+    false
+fi
+
+# A bloom counter truncated past its header is an error. The header
+# is its length on 9 digits followed by the JSON text.
+HEADER_LEN=$(expr $(head -c 9 ${pref}.bc) + 9)
+head -c $((HEADER_LEN + 64)) ${pref}.bc > ${pref}_truncated.bc
+if $JF query ${pref}_truncated.bc AAAA 2> ${pref}_truncated.err; then
+    echo >&2 "Query of truncated bloom counter should fail"
+    false
+fi
+grep -q "is truncated" ${pref}_truncated.err || {
+    echo >&2 "Query of truncated bloom counter should report the truncation"
+    false
+}
+
+# Count-min sketch. The k-mers of seq1m_0.fa are seen 3 times, those of
+# seq1m_1.fa once. With --bc-min 3, only the former are counted (up to
+# false positives).
+for bits in 4 8; do
+    $JF bc --bits $bits -t $nCPUs -o ${pref}_cms${bits}.bc -s 2M -C -m 40 seq1m_0.fa seq1m_0.fa seq1m_0.fa seq1m_1.fa
+    $JF count -t $nCPUs -o ${pref}_cms${bits}.jf --bc ${pref}_cms${bits}.bc --bc-min 3 -s 2M -C -m 40 seq1m_0.fa seq1m_1.fa
+    $JF histo ${pref}_cms${bits}.jf > ${pref}_cms${bits}.histo
+    CMS_TOTAL=$(cut -d\  -f2 ${pref}_cms${bits}.histo)
+    [ $CMS_TOTAL -ge $TOTAL -a $(((CMS_TOTAL - TOTAL) * 1000 < TOTAL)) = 1 ] || {
+        echo >&2 "Count-min sketch with $bits bits should filter k-mers seen less than 3 times"
+        false
+    }
+    QUERY_THREE=$($JF query -s seq1m_0.fa ${pref}_cms${bits}.bc | grep -c ' [3-9]$')
+    [ $QUERY_THREE = $TOTAL ] || {
+        echo >&2 "Queried count-min sketch estimate should be at least 3 for all mers"
+        false
+    }
+done
+
 check ${pref}.md5sum
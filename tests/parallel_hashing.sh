@@ -5,28 +5,76 @@ cd tests
 
 sort -k2,2 > ${pref}.md5sum <<EOF 
 864c0b0826854bdc72a85d170549b64b ${pref}_m15_s2M.histo
+138ca321f0cfd3518d0d34456de3ffc4 ${pref}_m15_s2M.report_mers
 864c0b0826854bdc72a85d170549b64b ${pref}_m15_s16M.histo
+864c0b0826854bdc72a85d170549b64b ${pref}_m15_mem64M.histo
+864c0b0826854bdc72a85d170549b64b ${pref}_m15_xorshift_s2M.histo
+864c0b0826854bdc72a85d170549b64b ${pref}_m15_xorshift_disk.histo
+8d8244559262e01cfe79e1ec5cc85fe9 ${pref}_m15_xorshift_s2M.query
+8d8244559262e01cfe79e1ec5cc85fe9 ${pref}_m15_xorshift_s2M.query_hash
+bc3c6ccfec60117c81a409b33ef5dc06 ${pref}_small_s8.dump
+bc3c6ccfec60117c81a409b33ef5dc06 ${pref}_small_s1M.dump
+ed0ff5f2a05ebb42b95e83d896167743 ${pref}_m15_s16M.prom_mers
 41fd8408dde0ea14bec7425b1a877140 ${pref}_m15.stats
 376761a6e273b57b3428c14e3b536edf ${pref}_binary.dump
 376761a6e273b57b3428c14e3b536edf ${pref}_text.dump
 9251799dd5dbd3f617124aa2ff72112a ${pref}_binary.histo
 c30cba4fe2886cea4abb27f5c30ea35e ${pref}_binary.stats
+9251799dd5dbd3f617124aa2ff72112a ${pref}_count.histo
+c30cba4fe2886cea4abb27f5c30ea35e ${pref}_count.stats
+9251799dd5dbd3f617124aa2ff72112a ${pref}_binary_analyze.histo
+c30cba4fe2886cea4abb27f5c30ea35e ${pref}_binary_analyze.stats
+376761a6e273b57b3428c14e3b536edf ${pref}_binary_analyze.dump
+9251799dd5dbd3f617124aa2ff72112a ${pref}_text_analyze.histo
+c30cba4fe2886cea4abb27f5c30ea35e ${pref}_text_analyze.stats
+376761a6e273b57b3428c14e3b536edf ${pref}_text_analyze.dump
+bd8bba9478442b81b80a041b5d7aa6a6 ${pref}_binary.top
+bd8bba9478442b81b80a041b5d7aa6a6 ${pref}_text.top
+bd8bba9478442b81b80a041b5d7aa6a6 ${pref}_count.top
 9251799dd5dbd3f617124aa2ff72112a ${pref}_text.histo
 c30cba4fe2886cea4abb27f5c30ea35e ${pref}_text.stats
 94625cd2d59e278f08421a673eb0926a ${pref}_m15_s2M_L2_U3.histo
 94625cd2d59e278f08421a673eb0926a ${pref}_m15_s2M_L2_U3_automerge.histo
+94625cd2d59e278f08421a673eb0926a ${pref}_m15_s2M_L2_U3_disk_count.histo
+bdece61f09a2468eec2f907e98928dcc ${pref}_m15_s2M_L2_U3_automerge.top
+bdece61f09a2468eec2f907e98928dcc ${pref}_m15_s2M_L2_U3_disk_count.top
 45fb383344e0fb0b7540718339be4c03 ${pref}_query_one_count
+45fb383344e0fb0b7540718339be4c03 ${pref}_query_hash_one_count
+45fb383344e0fb0b7540718339be4c03 ${pref}_query_compact_one_count
+45fb383344e0fb0b7540718339be4c03 ${pref}_profile_one_count
 EOF
 
 # Count with in memory hash doubling
-$JF count -t $nCPUs -o ${pref}_m15_s2M.jf -s 2M -C -m 15 seq10m.fa
+$JF count -t $nCPUs -o ${pref}_m15_s2M.jf -s 2M -C -m 15 --report ${pref}_m15_s2M.report seq10m.fa
+sed -n '/"total"/,$p' ${pref}_m15_s2M.report | grep '"mers" :' | sed -e 's/^ *//' > ${pref}_m15_s2M.report_mers
 $JF histo ${pref}_m15_s2M.jf > ${pref}_m15_s2M.histo
 $JF stats ${pref}_m15_s2M.jf > ${pref}_m15.stats
 
 # Count without size doubling
-$JF count -t $nCPUs -o ${pref}_m15_s16M.jf -s 16M -C -m 15 seq10m.fa
+$JF count -t $nCPUs -o ${pref}_m15_s16M.jf -s 16M -C -m 15 --metrics ${pref}_m15_s16M.prom seq10m.fa
+grep '^jellyfish_mers_total' ${pref}_m15_s16M.prom > ${pref}_m15_s16M.prom_mers
 $JF histo ${pref}_m15_s16M.jf > ${pref}_m15_s16M.histo
 
+# Count within a memory budget: no doubling past it, dump and merge
+$JF count -t $nCPUs -o ${pref}_m15_mem64M.jf --mem 64M -C -m 15 seq10m.fa
+$JF histo ${pref}_m15_mem64M.jf > ${pref}_m15_mem64M.histo
+
+# Count with the xorshift-multiply hash, with size doubling or
+# merging. Same results as with the matrix
+$JF count -t $nCPUs -o ${pref}_m15_xorshift_s2M.jf -s 2M -C -m 15 --xorshift-hash seq10m.fa
+$JF histo ${pref}_m15_xorshift_s2M.jf > ${pref}_m15_xorshift_s2M.histo
+$JF query ${pref}_m15_xorshift_s2M.jf -s seq1m_0.fa > ${pref}_m15_xorshift_s2M.query
+$JF query ${pref}_m15_xorshift_s2M.jf --hash -t $nCPUs -s seq1m_0.fa > ${pref}_m15_xorshift_s2M.query_hash
+$JF count -t $nCPUs -o ${pref}_m15_xorshift_disk.jf -s 2M -C -m 15 --disk --xorshift-hash seq10m.fa
+$JF histo ${pref}_m15_xorshift_disk.jf > ${pref}_m15_xorshift_disk.histo
+
+# Count from a tiny size, doubling many times: no k-mer is lost
+head -n 15 seq1m_0.fa > ${pref}_small.fa
+for s in 8 1M; do
+    $JF count -t $nCPUs -o ${pref}_small_s${s}.jf -s $s -m 15 ${pref}_small.fa
+    $JF dump -c ${pref}_small_s${s}.jf | sort > ${pref}_small_s${s}.dump
+done
+
 # Count large merges in binary and text. Should agree
 $JF count -m 40 -t $nCPUs -o ${pref}_text.jf -s 2M --text seq1m_0.fa
 $JF count -m 40 -t $nCPUs -o ${pref}_binary.jf -s 2M seq1m_0.fa
@@ -36,6 +84,16 @@ $JF histo ${pref}_binary.jf > ${pref}_binary.histo
 $JF stats ${pref}_binary.jf > ${pref}_binary.stats
 $JF dump -c ${pref}_text.jf | sort > ${pref}_text.dump
 $JF dump -c ${pref}_binary.jf | sort > ${pref}_binary.dump
+for f in binary text; do
+    $JF analyze -t $nCPUs --histo ${pref}_${f}_analyze.histo --stats ${pref}_${f}_analyze.stats \
+        --dump ${pref}_${f}_analyze.dump.unsorted -c ${pref}_${f}.jf
+    sort ${pref}_${f}_analyze.dump.unsorted > ${pref}_${f}_analyze.dump
+    $JF top -t $nCPUs -n 20 -o ${pref}_${f}.top ${pref}_${f}.jf
+done
+
+# Histogram and stats computed directly from the hash
+$JF count -m 40 -t $nCPUs -o ${pref}_count.jf -s 2M --no-write --histo ${pref}_count.histo --stats ${pref}_count.stats \
+    --top ${pref}_count.top --top-n 20 seq1m_0.fa
 
 # Check the lower and upper count without merging
 $JF count -t $nCPUs -o ${pref}_m15_s2M_L2_U3.jf -s 2M -C -m 15 -L2 -U3 seq10m.fa
@@ -44,9 +102,16 @@ $JF histo ${pref}_m15_s2M_L2_U3.jf > ${pref}_m15_s2M_L2_U3.histo
 # Check the lower and upper count limits with merging
 $JF count -t $nCPUs -o ${pref}_m15_s2M_L2_U3_automerge.jf -s 2M -C -m 15 -L2 -U3 --disk seq10m.fa
 $JF histo ${pref}_m15_s2M_L2_U3_automerge.jf > ${pref}_m15_s2M_L2_U3_automerge.histo
+$JF top -n 50 ${pref}_m15_s2M_L2_U3_automerge.jf > ${pref}_m15_s2M_L2_U3_automerge.top
+$JF count -t $nCPUs -o ${pref}_m15_s2M_L2_U3_disk_count.jf -s 2M -C -m 15 -L2 -U3 --disk --no-write \
+    --histo ${pref}_m15_s2M_L2_U3_disk_count.histo --top ${pref}_m15_s2M_L2_U3_disk_count.top --top-n 50 seq10m.fa
 
 # Check query
 $JF query ${pref}_binary.jf -s seq1m_0.fa    | grep ' 1$' | wc -l | sed -e 's/ //g' > ${pref}_query_one_count
+$JF query ${pref}_binary.jf --hash -t $nCPUs -s seq1m_0.fa | grep ' 1$' | wc -l | sed -e 's/ //g' > ${pref}_query_hash_one_count
+$JF compact -t $nCPUs -f 16 -o ${pref}_binary.mphf ${pref}_binary.jf
+$JF query ${pref}_binary.mphf -s seq1m_0.fa | grep ' 1$' | wc -l | sed -e 's/ //g' > ${pref}_query_compact_one_count
+$JF profile -t $nCPUs ${pref}_binary.jf seq1m_0.fa | grep -v '^>' | tr ' ' '\n' | grep -c '^1$' > ${pref}_profile_one_count
 # $JF query ${pref}_binary.jf -s seq1m_0.fa -C | grep ' 1$' | wc -l | sed -e 's/ //g' > ${pref}_query_canonical_one_count
 
 # $JF count -m 40 -t $nCPUs -o ${pref}_text -s 2M --text seq1m_0.fa
@@ -10,6 +10,7 @@ I=$($PYTHON -c 'import random; print(random.randint(0, 4))')
 $JF count -m $K -s 10M -t $nCPUs -C -o ${pref}.jf seq1m_$I.fa
 $JF dump -c ${pref}.jf > ${pref}.dump
 $JF histo ${pref}.jf > ${pref}.histo
+$JF compact -t $nCPUs -o ${pref}.mphf ${pref}.jf
 
 for i in test_mer_file.py test_hash_counter.py; do
     echo Test $i
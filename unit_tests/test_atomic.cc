@@ -0,0 +1,71 @@
+#include <stdint.h>
+#include <gtest/gtest.h>
+#include <jellyfish/atomic_cxx11.hpp>
+#include <jellyfish/thread_exec.hpp>
+
+namespace {
+template<typename atomic_t>
+class AtomicTest : public ::testing::Test { };
+
+#ifdef __ATOMIC_ACQ_REL
+typedef ::testing::Types< ::atomic::gcc, ::atomic::cxx11> Implementations;
+#else
+typedef ::testing::Types< ::atomic::gcc> Implementations;
+#endif
+TYPED_TEST_CASE(AtomicTest, Implementations);
+
+TYPED_TEST(AtomicTest, Operations) {
+  uint64_t x = 5;
+  EXPECT_EQ((uint64_t)5, TypeParam::cas(&x, (uint64_t)4, (uint64_t)10));
+  EXPECT_EQ((uint64_t)5, x);
+  EXPECT_EQ((uint64_t)5, TypeParam::cas(&x, (uint64_t)5, (uint64_t)10));
+  EXPECT_EQ((uint64_t)10, x);
+
+  uint64_t o = 3;
+  EXPECT_FALSE(TypeParam::cas_weak(&x, &o, (uint64_t)20));
+  EXPECT_EQ((uint64_t)10, o);
+  while(!TypeParam::cas_weak(&x, &o, (uint64_t)20)) ;
+  EXPECT_EQ((uint64_t)20, x);
+
+  EXPECT_EQ((uint64_t)20, TypeParam::fetch_add(&x, (uint64_t)2));
+  EXPECT_EQ((uint64_t)25, TypeParam::add_fetch(&x, (uint64_t)3));
+  EXPECT_EQ((uint64_t)25, TypeParam::fetch_add_relaxed(&x, (uint64_t)1));
+  EXPECT_EQ((uint64_t)26, TypeParam::set(&x, (uint64_t)7));
+  EXPECT_EQ((uint64_t)7, TypeParam::set_to_max(&x, (uint64_t)3));
+  EXPECT_EQ((uint64_t)9, TypeParam::set_to_max(&x, (uint64_t)9));
+  EXPECT_EQ((uint64_t)9, TypeParam::fetch_or(&x, (uint64_t)6));
+  EXPECT_EQ((uint64_t)15, x);
+
+  unsigned char c = 250;
+  EXPECT_EQ((unsigned char)250, TypeParam::fetch_add(&c, (unsigned char)10));
+  EXPECT_EQ((unsigned char)4, c);
+}
+
+template<typename atomic_t>
+class incrementer : public jellyfish::thread_exec {
+  volatile uint64_t counter_;
+  volatile uint64_t max_;
+
+public:
+  static const int nb = 100000;
+  incrementer() : counter_(0), max_(0) { }
+  virtual void start(int thid) {
+    for(int i = 0; i < nb; ++i) {
+      uint64_t v = counter_;
+      while(!atomic_t::cas_weak(&counter_, &v, v + 1)) ;
+      atomic_t::fetch_add_relaxed(&counter_, (uint64_t)1);
+      atomic_t::set_to_max(&max_, (uint64_t)(thid * nb + i));
+    }
+  }
+  uint64_t counter() const { return counter_; }
+  uint64_t max() const { return max_; }
+};
+
+TYPED_TEST(AtomicTest, Threads) {
+  static const int       nb_threads = 4;
+  incrementer<TypeParam> inc;
+  inc.exec_join(nb_threads);
+  EXPECT_EQ((uint64_t)(2 * nb_threads * incrementer<TypeParam>::nb), inc.counter());
+  EXPECT_EQ((uint64_t)(nb_threads * incrementer<TypeParam>::nb - 1), inc.max());
+}
+} // namespace
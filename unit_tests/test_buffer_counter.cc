@@ -0,0 +1,132 @@
+#include <stdlib.h>
+
+#include <map>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <stdexcept>
+
+#include <gtest/gtest.h>
+#include <unit_tests/test_main.hpp>
+#include <jellyfish/mer_dna.hpp>
+#include <jellyfish/hash_counter.hpp>
+#include <jellyfish/buffer_counter.hpp>
+#include <jellyfish/file_header.hpp>
+#include <jellyfish/binary_dumper.hpp>
+
+namespace {
+using jellyfish::mer_dna;
+typedef jellyfish::cooperative::hash_counter<mer_dna> hash_counter;
+typedef jellyfish::buffer_counter<hash_counter>       buffer_counter;
+
+std::string random_sequence(size_t len) {
+  static const char bases[] = "ACGT";
+  std::string       res;
+  for(size_t i = 0; i < len; ++i)
+    res += (random() % 100 == 0) ? 'N' : bases[random() % 4];
+  return res;
+}
+
+// Threads adding sequences to the counter, in batches of various
+// sizes. Once added, the buffers are overwritten: they must not be
+// used by the counter anymore.
+class producers : public jellyfish::thread_exec {
+  buffer_counter&                              counter_;
+  const std::vector<std::vector<std::string> >& seqs_;
+
+public:
+  producers(buffer_counter& counter, const std::vector<std::vector<std::string> >& seqs) :
+    counter_(counter), seqs_(seqs)
+  { }
+
+  virtual void start(int thid) {
+    const std::vector<std::string>& seqs = seqs_[thid];
+    for(size_t i = 0; i < seqs.size(); i += thid + 1) {
+      std::vector<std::string> batch(seqs.begin() + i, seqs.begin() + std::min(seqs.size(), i + thid + 1));
+      std::vector<const char*> ptrs;
+      std::vector<size_t>      lens;
+      for(auto it = batch.cbegin(); it != batch.cend(); ++it) {
+        ptrs.push_back(it->c_str());
+        lens.push_back(it->size());
+      }
+      if(ptrs.size() == 1)
+        counter_.add(ptrs[0], lens[0]);
+      else
+        counter_.add(ptrs.data(), lens.data(), ptrs.size());
+      for(auto it = batch.begin(); it != batch.end(); ++it)
+        it->assign(it->size(), 'A');
+    }
+  }
+};
+
+TEST(BufferCounter, Count) {
+  static const int   nb_producers = 4;
+  static const int   nb_threads   = 3;
+  static const char* file         = "./buffer_counter.jf";
+  file_unlink        f(file);
+
+  mer_dna::k(21);
+  std::vector<std::vector<std::string> > seqs(nb_producers);
+  std::map<mer_dna, uint64_t>            expected;
+  for(int i = 0; i < nb_producers; ++i) {
+    for(int j = 0; j < 50; ++j) {
+      // Some sequences longer than a chunk
+      const std::string seq = random_sequence(j % 10 == 0 ? 2000 : random() % 200);
+      seqs[i].push_back(seq);
+      for(size_t p = 0; p + mer_dna::k() <= seq.size(); ++p) {
+        const std::string s = seq.substr(p, mer_dna::k());
+        if(s.find('N') != std::string::npos) continue;
+        mer_dna m(s);
+        m.canonicalize();
+        ++expected[m];
+      }
+    }
+  }
+
+  hash_counter hash(1024, mer_dna::k() * 2, 7, nb_threads);
+  {
+    buffer_counter counter(hash, true, 100);
+    counter.start_counting();
+    producers p(counter, seqs);
+    p.exec_join(nb_producers);
+    counter.finish();
+    EXPECT_THROW(counter.add("ACGT", 4), std::logic_error);
+  }
+
+  EXPECT_LT((size_t)1024, hash.size()); // The hash has doubled
+  uint64_t nb = 0;
+  for(auto it = hash.ary()->begin(); it != hash.ary()->end(); ++it, ++nb) {
+    auto& key_val = *it;
+    ASSERT_NE(expected.end(), expected.find(key_val.first));
+    EXPECT_EQ(expected[key_val.first], key_val.second);
+  }
+  EXPECT_EQ(expected.size(), nb);
+
+  // The dumpers work on the result
+  jellyfish::file_header header;
+  header.fill_standard();
+  jellyfish::binary_dumper<hash_counter::array> dumper(4, mer_dna::k() * 2, nb_threads, file, &header);
+  dumper.one_file(true);
+  dumper.dump(hash.ary());
+
+  std::ifstream is(file);
+  jellyfish::file_header rheader(is);
+  jellyfish::binary_reader<mer_dna, uint64_t> reader(is, &rheader);
+  nb = 0;
+  while(reader.next()) {
+    EXPECT_EQ(expected[reader.key()], reader.val());
+    ++nb;
+  }
+  EXPECT_EQ(expected.size(), nb);
+}
+
+TEST(BufferCounter, NoSequence) {
+  mer_dna::k(15);
+  hash_counter hash(1024, mer_dna::k() * 2, 7, 2);
+  buffer_counter counter(hash);
+  counter.start_counting();
+  counter.add("ACGT", 4); // Shorter than k
+  counter.finish();
+  EXPECT_TRUE(hash.ary()->begin() == hash.ary()->end());
+}
+} // namespace
@@ -0,0 +1,97 @@
+#include <map>
+#include <vector>
+#include <fstream>
+#include <algorithm>
+
+#include <gtest/gtest.h>
+#include <unit_tests/test_main.hpp>
+#include <jellyfish/mer_dna_bloom_counter.hpp>
+
+namespace {
+using jellyfish::mer_dna;
+typedef jellyfish::mer_dna_count_min_sketch      sketch_type;
+typedef jellyfish::mer_dna_count_min_sketch_file sketch_file_type;
+
+static const size_t nb_mers    = 10000;
+static const double error_rate = 0.001;
+
+class CountMinSketch : public ::testing::TestWithParam<unsigned int> { };
+
+TEST_P(CountMinSketch, Estimate) {
+  const unsigned int bits = GetParam();
+  mer_dna::k(31);
+  sketch_type cms(error_rate, nb_mers, bits);
+  EXPECT_EQ(bits, cms.bits());
+  EXPECT_EQ((1u << bits) - 1, cms.max_count());
+
+  std::map<mer_dna, unsigned int> counts;
+  std::vector<mer_dna>            inserted;
+  mer_dna m;
+  for(size_t i = 0; i < nb_mers; ++i) {
+    m.randomize();
+    const unsigned int c = 1 + random_bits(5);
+    counts[m] = c;
+    for(unsigned int j = 0; j < c; ++j) {
+      inserted.push_back(m);
+      const unsigned int prev = cms.insert(m);
+      EXPECT_LE(std::min(j, cms.max_count()), prev);
+    }
+  }
+
+  // The estimate is never lower than the count and rarely higher
+  size_t nb_over = 0;
+  for(auto it = counts.cbegin(); it != counts.cend(); ++it) {
+    const unsigned int expected = std::min(it->second, cms.max_count());
+    const unsigned int estimate = cms.check(it->first);
+    EXPECT_LE(expected, estimate);
+    nb_over += estimate > expected;
+  }
+  EXPECT_GT(2 * error_rate * nb_mers, nb_over);
+
+  // Batch insertion gives the same results
+  sketch_type cms_many(cms.m(), cms.k(), bits, cms.hash_functions());
+  cms_many.insert_many(inserted.begin(), inserted.end());
+  std::vector<unsigned int> estimates(counts.size());
+  std::vector<mer_dna>      keys;
+  for(auto it = counts.cbegin(); it != counts.cend(); ++it)
+    keys.push_back(it->first);
+  cms_many.check_many(keys.begin(), keys.end(), estimates.begin());
+  for(size_t i = 0; i < keys.size(); ++i)
+    EXPECT_EQ(cms.check(keys[i]), estimates[i]);
+
+  // Write to file and reload two different ways
+  file_unlink f("count_min_sketch_file");
+  {
+    std::ofstream out(f.path.c_str());
+    cms.write_bits(out);
+    EXPECT_TRUE(out.good());
+    EXPECT_EQ(cms.nb_bytes(), out.tellp());
+  }
+  std::ifstream in(f.path.c_str());
+  sketch_type cms_read(cms.m(), cms.k(), bits, in, cms.hash_functions());
+  EXPECT_EQ(cms.nb_bytes(), in.tellg());
+  in.close();
+  sketch_file_type cms_map(cms.m(), cms.k(), bits, f.path.c_str(), cms.hash_functions());
+  for(size_t i = 0; i < keys.size(); ++i) {
+    EXPECT_EQ(cms.check(keys[i]), cms_read.check(keys[i]));
+    EXPECT_EQ(cms.check(keys[i]), cms_map.check(keys[i]));
+  }
+}
+
+TEST_P(CountMinSketch, Saturate) {
+  const unsigned int bits = GetParam();
+  mer_dna::k(31);
+  sketch_type cms(error_rate, 100, bits);
+  mer_dna m;
+  m.randomize();
+  for(unsigned int i = 0; i < 300; ++i)
+    EXPECT_EQ(std::min(i, cms.max_count()), cms.insert(m));
+  EXPECT_EQ(cms.max_count(), cms.check(m));
+}
+
+INSTANTIATE_TEST_CASE_P(CountMinSketchBits, CountMinSketch, ::testing::Values(4, 8));
+
+TEST(CountMinSketchCtor, InvalidBits) {
+  EXPECT_THROW(sketch_type((size_t)1000, (unsigned long)4, 5), std::runtime_error);
+}
+} // namespace
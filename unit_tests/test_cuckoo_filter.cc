@@ -0,0 +1,135 @@
+#include <map>
+#include <vector>
+#include <fstream>
+#include <algorithm>
+
+#include <gtest/gtest.h>
+#include <unit_tests/test_main.hpp>
+#include <jellyfish/mer_dna_bloom_counter.hpp>
+
+namespace {
+using jellyfish::mer_dna;
+typedef jellyfish::mer_dna_cuckoo_filter      filter_type;
+typedef jellyfish::mer_dna_cuckoo_filter_file filter_file_type;
+
+static const size_t nb_mers    = 20000;
+static const double error_rate = 0.004; // Maximum load
+
+TEST(CuckooFilter, Counts) {
+  mer_dna::k(31);
+  filter_type cf(error_rate, nb_mers);
+  EXPECT_EQ((unsigned long)2, cf.k());
+  EXPECT_EQ((size_t)0, cf.m() % filter_type::bucket_slots);
+  EXPECT_GE(cf.m(), (size_t)(nb_mers / filter_type::max_load));
+
+  std::map<mer_dna, unsigned int> counts;
+  std::vector<mer_dna>            inserted;
+  mer_dna m;
+  for(size_t i = 0; i < nb_mers; ++i) {
+    m.randomize();
+    const unsigned int c = 1 + random_bits(2);
+    counts[m] = c;
+    for(unsigned int j = 0; j < c; ++j) {
+      inserted.push_back(m);
+      EXPECT_LE(std::min(j, cf.max_count()), cf.insert(m));
+    }
+  }
+  EXPECT_EQ((size_t)0, cf.overflows());
+
+  // The estimate is never lower than the count and rarely higher
+  size_t nb_over = 0;
+  for(auto it = counts.cbegin(); it != counts.cend(); ++it) {
+    const unsigned int expected = std::min(it->second, cf.max_count());
+    const unsigned int estimate = cf.check(it->first);
+    EXPECT_LE(expected, estimate);
+    nb_over += estimate > expected;
+  }
+  EXPECT_GT(2 * error_rate * nb_mers, nb_over);
+
+  size_t nb_fp = 0;
+  for(size_t i = 0; i < nb_mers; ++i) {
+    m.randomize();
+    nb_fp += cf.check(m) > 0;
+  }
+  EXPECT_GT(2 * error_rate * nb_mers, nb_fp);
+
+  // Batch insertion gives the same results
+  filter_type cf_many(cf.m(), cf.k(), cf.hash_functions());
+  cf_many.insert_many(inserted.begin(), inserted.end());
+  std::vector<unsigned int> estimates(counts.size());
+  std::vector<mer_dna>      keys;
+  for(auto it = counts.cbegin(); it != counts.cend(); ++it)
+    keys.push_back(it->first);
+  cf_many.check_many(keys.begin(), keys.end(), estimates.begin());
+  for(size_t i = 0; i < keys.size(); ++i)
+    EXPECT_EQ(cf.check(keys[i]), estimates[i]);
+
+  // Write to file and reload two different ways
+  file_unlink f("cuckoo_filter_file");
+  {
+    std::ofstream out(f.path.c_str());
+    cf.write_bits(out);
+    EXPECT_TRUE(out.good());
+    EXPECT_EQ(cf.nb_bytes(), out.tellp());
+  }
+  std::ifstream in(f.path.c_str());
+  filter_type cf_read(cf.m(), cf.k(), in, cf.hash_functions());
+  EXPECT_EQ(cf.nb_bytes(), in.tellg());
+  in.close();
+  filter_file_type cf_map(cf.m(), cf.k(), f.path.c_str(), cf.hash_functions());
+  for(size_t i = 0; i < keys.size(); ++i) {
+    EXPECT_EQ(cf.check(keys[i]), cf_read.check(keys[i]));
+    EXPECT_EQ(cf.check(keys[i]), cf_map.check(keys[i]));
+  }
+}
+
+// The load is max_load down to max_load_fpr(), and lower in
+// proportion of the rate below it.
+TEST(CuckooFilter, Size) {
+  EXPECT_NEAR(0.0033, filter_type::max_load_fpr(), 0.0001);
+  const size_t n = 1000000;
+  const size_t m = filter_type::opt_m(filter_type::max_load_fpr(), n);
+  EXPECT_EQ(m, filter_type::opt_m(0.01, n));
+  EXPECT_NEAR(n / filter_type::max_load, m, filter_type::bucket_slots);
+  EXPECT_NEAR(n / filter_type::max_load * 2, filter_type::opt_m(filter_type::max_load_fpr() / 2, n),
+              2 * filter_type::bucket_slots);
+}
+
+TEST(CuckooFilter, Saturate) {
+  mer_dna::k(31);
+  filter_type cf(error_rate, 100);
+  mer_dna m;
+  m.randomize();
+  for(unsigned int i = 0; i < 10; ++i)
+    EXPECT_EQ(std::min(i, cf.max_count()), cf.insert(m));
+  EXPECT_EQ(cf.max_count(), cf.check(m));
+}
+
+TEST(CuckooFilter, Merge) {
+  mer_dna::k(31);
+  filter_type cf1(error_rate, nb_mers);
+  filter_type cf2(cf1.m(), cf1.k(), cf1.hash_functions());
+
+  // Keys in both, only in cf1 and only in cf2
+  std::vector<mer_dna> keys[3];
+  mer_dna m;
+  for(size_t i = 0; i < nb_mers / 3; ++i) {
+    for(int j = 0; j < 3; ++j) {
+      m.randomize();
+      keys[j].push_back(m);
+      if(j != 2) cf1.insert(m);
+      if(j != 1) cf2.insert(m);
+    }
+  }
+
+  EXPECT_TRUE(cf1.merge(cf2));
+  for(auto it = keys[0].cbegin(); it != keys[0].cend(); ++it)
+    EXPECT_LE((unsigned int)2, cf1.check(*it));
+  for(int j = 1; j < 3; ++j)
+    for(auto it = keys[j].cbegin(); it != keys[j].cend(); ++it)
+      EXPECT_LE((unsigned int)1, cf1.check(*it));
+
+  filter_type cf3(2 * cf1.m(), cf1.k(), cf1.hash_functions());
+  EXPECT_FALSE(cf1.merge(cf3));
+}
+} // namespace
@@ -0,0 +1,70 @@
+#include <string>
+#include <vector>
+#include <sstream>
+
+#include <gtest/gtest.h>
+#include <unit_tests/test_main.hpp>
+#include <jellyfish/mer_dna.hpp>
+#include <jellyfish/database_chunks.hpp>
+
+namespace {
+using jellyfish::mer_dna;
+typedef std::vector<std::pair<mer_dna, uint64_t> > record_list;
+
+template<typename Chunks>
+record_list read_chunks(const Chunks& chunks) {
+  record_list res;
+  for(size_t i = 0; i < chunks.size(); ++i) {
+    typename Chunks::reader it = chunks.chunk(i);
+    while(it.next())
+      res.push_back(std::make_pair(it.key(), it.val()));
+  }
+  return res;
+}
+
+class DatabaseChunks : public ::testing::TestWithParam<size_t> {
+public:
+  static const int nb = 1000;
+  record_list      records;
+  std::string      binary, text;
+
+  void SetUp() {
+    mer_dna::k(23);
+    const unsigned int key_bytes = (2 * mer_dna::k()) / 8 + ((2 * mer_dna::k()) % 8 != 0);
+    std::ostringstream text_os;
+    mer_dna m;
+    for(int i = 0; i < nb; ++i) {
+      m.randomize();
+      const uint64_t v = random_bits(24);
+      records.push_back(std::make_pair(m, v));
+      binary.append((const char*)m.data(), key_bytes);
+      binary.append((const char*)&v, 3);
+      text_os << m << " " << v << "\n";
+    }
+    text = text_os.str();
+  }
+};
+
+TEST_P(DatabaseChunks, Binary) {
+  jellyfish::binary_chunks<mer_dna, uint64_t> chunks(binary.data(), 2 * mer_dna::k(), 3, binary.size(), GetParam());
+  EXPECT_EQ((nb + GetParam() - 1) / GetParam(), chunks.size());
+  EXPECT_EQ(records, read_chunks(chunks));
+}
+
+TEST_P(DatabaseChunks, Text) {
+  jellyfish::text_chunks<mer_dna, uint64_t> chunks(text.data(), text.size(), 10 * GetParam());
+  EXPECT_LE((size_t)1, chunks.size());
+  EXPECT_EQ(records, read_chunks(chunks));
+}
+// The last line has no newline and the bytes after the end of the
+// dump are digits: the last count must stop at the end.
+TEST_P(DatabaseChunks, TextNoFinalNewline) {
+  std::string buffer(text, 0, text.size() - 1);
+  const size_t length = buffer.size();
+  buffer += "999";
+  jellyfish::text_chunks<mer_dna, uint64_t> chunks(buffer.data(), length, 10 * GetParam());
+  EXPECT_EQ(records, read_chunks(chunks));
+}
+
+INSTANTIATE_TEST_CASE_P(DatabaseChunksTest, DatabaseChunks, ::testing::Values(1, 7, 100, 5000));
+} // namespace
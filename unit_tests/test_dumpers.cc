@@ -1,9 +1,13 @@
+#include <thread>
+#include <vector>
+
 #include <gtest/gtest.h>
 #include <unit_tests/test_main.hpp>
 #include <jellyfish/mer_dna.hpp>
 #include <jellyfish/hash_counter.hpp>
 #include <jellyfish/file_header.hpp>
 #include <jellyfish/binary_dumper.hpp>
+#include <jellyfish/binary_hash_query.hpp>
 #include <jellyfish/text_dumper.hpp>
 #include <jellyfish/mapped_file.hpp>
 
@@ -17,6 +21,7 @@ struct binary {
   typedef jellyfish::binary_dumper<hash_counter::array> dumper;
   typedef jellyfish::binary_reader<mer_dna, uint64_t> reader;
   typedef jellyfish::binary_query_base<mer_dna, uint64_t> query;
+  typedef jellyfish::binary_hash_query<mer_dna, uint64_t> hash_query;
 };
 struct text {
   typedef jellyfish::text_dumper<hash_counter::array> dumper;
@@ -80,6 +85,9 @@ TEST(Dumper, IO) {
     jellyfish::mapped_file binary_map(file_binary);
     binary::query bq(binary_map.base() + bh.offset(), bh.key_len(), bh.counter_len(), bh.matrix(),
                      bh.size() - 1, binary_map.length() - bh.offset());
+    binary::hash_query hq(binary_map.base() + bh.offset(), bh.key_len(), bh.counter_len(), bh.matrix(),
+                          bh.size(), binary_map.length() - bh.offset(), 3);
+    EXPECT_EQ((size_t)nb, hq.nb_records());
 
     file_header th;
     std::ifstream tis(file_text);
@@ -88,9 +96,13 @@ TEST(Dumper, IO) {
     text::reader tr(tis, &th);
 
     const uint64_t max_val = ((uint64_t)1 << (8 * dump_counter_len)) - 1;
-    int bcount = 0, tcount = 0, qcount = 0;
+    int bcount = 0, tcount = 0, qcount = 0, hcount = 0;
     mer_dna tmp_key;
+    std::vector<mer_dna>  keys;
+    std::vector<uint64_t> vals;
     while(br.next()) {
+      keys.push_back(br.key());
+      vals.push_back(br.val());
       uint64_t val = 0;
       size_t   id  = 0;
       bool present = hash.ary()->get_val_for_key(br.key(), &val, tmp_key, &id);
@@ -117,10 +129,41 @@ TEST(Dumper, IO) {
         // EXPECT_EQ(id, query_id);
         ++qcount;
       }
+
+      EXPECT_EQ(std::min(max_val, val), hq.check(br.key()));
+      EXPECT_EQ(std::min(max_val, val), hq.check(br.key(), hq.prefetch(br.key())));
+      ++hcount;
     }
     EXPECT_EQ(nb, bcount);
     EXPECT_EQ(nb, tcount);
     EXPECT_EQ(nb, qcount);
+    EXPECT_EQ(nb, hcount);
+
+    // Concurrent queries, each thread with its own scratch key
+    {
+      static const int         nb_threads = 4;
+      std::vector<int>         errors(nb_threads, 0);
+      std::vector<std::thread> threads;
+      for(int t = 0; t < nb_threads; ++t)
+        threads.push_back(std::thread([&, t]() {
+              mer_dna mid_key;
+              for(int r = 0; r < 10; ++r)
+                for(size_t i = 0; i < keys.size(); ++i)
+                  errors[t] += bq.check(keys[i], mid_key) != vals[i];
+            }));
+      for(auto& th : threads)
+        th.join();
+      for(int t = 0; t < nb_threads; ++t)
+        EXPECT_EQ(0, errors[t]) << "thread " << t;
+    }
+
+    // A k-mer not in the database has a count of 0
+    mer_dna  m;
+    uint64_t val_absent;
+    do {
+      m.randomize();
+    } while(hash.ary()->get_val_for_key(m, &val_absent));
+    EXPECT_EQ((uint64_t)0, hq.check(m));
   }
 
   // Dump with zeroing and check hash is empty
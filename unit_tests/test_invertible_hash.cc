@@ -0,0 +1,190 @@
+#include <map>
+#include <set>
+#include <fstream>
+
+#include <gtest/gtest.h>
+#include <unit_tests/test_main.hpp>
+#include <jellyfish/invertible_hash.hpp>
+#include <jellyfish/mer_dna.hpp>
+#include <jellyfish/hash_counter.hpp>
+#include <jellyfish/file_header.hpp>
+#include <jellyfish/binary_dumper.hpp>
+#include <jellyfish/mapped_file.hpp>
+
+namespace {
+using jellyfish::invertible_hash;
+using jellyfish::mer_dna;
+using jellyfish::file_header;
+typedef jellyfish::cooperative::hash_counter<mer_dna> hash_counter;
+
+class InvertibleHash : public ::testing::TestWithParam<invertible_hash::family_type> { };
+
+// The low r bits of a key are recovered from its hash and its high
+// bits.
+TEST_P(InvertibleHash, PseudoInverse) {
+  static const unsigned int rs[4] = { 1, 10, 22, 31 };
+  static const unsigned int cs[4] = { 32, 42, 62, 64 };
+  for(int i = 0; i < 4; ++i) {
+    for(int j = 0; j < 4; ++j) {
+      SCOPED_TRACE(::testing::Message() << "r:" << rs[i] << " c:" << cs[j]);
+      const invertible_hash h = invertible_hash::random(GetParam(), rs[i], cs[j]);
+      const invertible_hash hi = h.pseudo_inverse();
+      EXPECT_EQ(GetParam(), h.family());
+      EXPECT_EQ(rs[i], h.r());
+      EXPECT_EQ(cs[j], h.c());
+      EXPECT_TRUE(h == hi.pseudo_inverse());
+      const uint64_t rmask = ((uint64_t)1 << rs[i]) - 1;
+      const uint64_t cmask = cs[j] == 64 ? ~(uint64_t)0 : ((uint64_t)1 << cs[j]) - 1;
+      for(int k = 0; k < 1000; ++k) {
+        const uint64_t key[2] = { random_bits(64) & cmask, 0 };
+        const uint64_t hash   = h.times(key);
+        ASSERT_EQ((uint64_t)0, hash & ~rmask);
+        const uint64_t v[2] = { (key[0] & ~rmask) | hash, 0 };
+        ASSERT_EQ(key[0] & rmask, hi.times(v));
+      }
+    }
+  }
+}
+
+INSTANTIATE_TEST_CASE_P(InvertibleHashFamilies, InvertibleHash,
+                        ::testing::Values(invertible_hash::MATRIX, invertible_hash::XORSHIFT_MUL));
+
+TEST(XorshiftMulHash, Bijection) {
+  // With r == c, the hash is a permutation of the keys
+  const invertible_hash h = invertible_hash::xorshift_mul(12, 12, random_bits());
+  std::set<uint64_t>    hashes;
+  for(uint64_t key = 0; key < 4096; ++key)
+    hashes.insert(h.times(&key));
+  EXPECT_EQ((size_t)4096, hashes.size());
+}
+
+// The inverse recovers the r low bits at the edges of the sizes: one
+// bit of hash, no high bits (r == c), and keys of 64 bits.
+TEST(XorshiftMulHash, RoundTrip) {
+  static const unsigned int sizes[6][2] = { { 1, 1 }, { 1, 64 }, { 20, 20 }, { 64, 64 }, { 33, 64 }, { 1, 40 } };
+  for(int i = 0; i < 6; ++i) {
+    const unsigned int r = sizes[i][0], c = sizes[i][1];
+    SCOPED_TRACE(::testing::Message() << "r:" << r << " c:" << c);
+    const invertible_hash h  = invertible_hash::xorshift_mul(r, c, random_bits());
+    const invertible_hash hi = h.pseudo_inverse();
+    const uint64_t rmask = r == 64 ? ~(uint64_t)0 : ((uint64_t)1 << r) - 1;
+    const uint64_t cmask = c == 64 ? ~(uint64_t)0 : ((uint64_t)1 << c) - 1;
+    for(int k = 0; k < 10000; ++k) {
+      const uint64_t key  = random_bits(64) & cmask;
+      const uint64_t hash = h.times(&key);
+      ASSERT_EQ((uint64_t)0, hash & ~rmask);
+      const uint64_t v = (key & ~rmask) | hash;
+      ASSERT_EQ(key & rmask, hi.times(&v));
+    }
+  }
+}
+
+TEST(XorshiftMulHash, Spread) {
+  // Keys differing only in their high bits, as consecutive k-mers
+  // sharing their last bases, are spread over the positions.
+  const invertible_hash h = invertible_hash::xorshift_mul(10, 40, random_bits());
+  std::set<uint64_t>    hashes;
+  for(uint64_t i = 0; i < 256; ++i) {
+    const uint64_t key = i << 30;
+    hashes.insert(h.times(&key));
+  }
+  EXPECT_LT((size_t)200, hashes.size());
+}
+
+TEST(XorshiftMulHash, Errors) {
+  EXPECT_THROW(invertible_hash::xorshift_mul(10, 66, 0), std::out_of_range);
+  EXPECT_THROW(invertible_hash::xorshift_mul(0, 40, 0), std::out_of_range);
+  EXPECT_THROW(invertible_hash::xorshift_mul(41, 40, 0), std::out_of_range);
+  EXPECT_THROW(invertible_hash::xorshift_mul(10, 40, 0).matrix(), std::logic_error);
+  EXPECT_NE(invertible_hash::xorshift_mul(10, 40, 1), invertible_hash::xorshift_mul(10, 40, 2));
+  EXPECT_NE(invertible_hash::xorshift_mul(10, 40, 1), invertible_hash::xorshift_mul(10, 40, 1).pseudo_inverse());
+}
+
+TEST(XorshiftMulHash, FileHeader) {
+  const invertible_hash hx = invertible_hash::xorshift_mul(20, 50, random_bits());
+  const invertible_hash hm = invertible_hash::random(invertible_hash::MATRIX, 20, 50);
+
+  file_header header;
+  header.hash_function(hm);
+  EXPECT_EQ(hm, header.hash_function());
+  EXPECT_EQ(hm.matrix(), header.matrix());
+  header.hash_function(hx);
+  EXPECT_EQ(hx, header.hash_function());
+
+  std::stringstream buffer;
+  header.write(buffer);
+  file_header rheader(buffer);
+  EXPECT_EQ(hx, rheader.hash_function());
+  rheader.hash_function(hm);
+  EXPECT_EQ(hm, rheader.hash_function());
+}
+
+// Count with the xorshift-multiply hash, through size doublings, then
+// dump and query the database.
+TEST(XorshiftMulHash, CountDumpQuery) {
+  static const char* file = "./xorshift_mul_hash.jf";
+  file_unlink        f(file);
+
+  mer_dna::k(25);
+  hash_counter hash(256, mer_dna::k() * 2, 5, 1);
+  hash.hash_family(invertible_hash::XORSHIFT_MUL);
+  std::map<mer_dna, uint64_t> expected;
+  mer_dna                     m;
+  for(int i = 0; i < 5000; ++i) {
+    if(i == 0 || random_bits(2))
+      m.randomize();
+    const uint64_t val = random_bits(3);
+    hash.add(m, val);
+    expected[m] += val;
+  }
+  EXPECT_LT((size_t)256, hash.size());
+  EXPECT_EQ(invertible_hash::XORSHIFT_MUL, hash.hash_family());
+  EXPECT_EQ(hash.ary()->lsize(), hash.ary()->hash_function().r());
+
+  size_t nb = 0;
+  for(auto it = hash.ary()->begin(); it != hash.ary()->end(); ++it, ++nb) {
+    auto& key_val = *it;
+    ASSERT_NE(expected.end(), expected.find(key_val.first));
+    EXPECT_EQ(expected[key_val.first], key_val.second);
+  }
+  EXPECT_EQ(expected.size(), nb);
+  for(auto it = expected.cbegin(); it != expected.cend(); ++it) {
+    uint64_t val;
+    ASSERT_TRUE(hash.ary()->get_val_for_key(it->first, &val));
+    EXPECT_EQ(it->second, val);
+  }
+
+  file_header header;
+  header.fill_standard();
+  header.update_from_ary(*hash.ary());
+  jellyfish::binary_dumper<hash_counter::array> dumper(4, mer_dna::k() * 2, 1, file, &header);
+  dumper.one_file(true);
+  dumper.zero_array(false);
+  dumper.dump(hash.ary());
+
+  std::ifstream is(file);
+  file_header   rheader(is);
+  EXPECT_EQ(hash.ary()->hash_function(), rheader.hash_function());
+  jellyfish::binary_reader<mer_dna, uint64_t> reader(is, &rheader);
+  size_t pos = 0;
+  nb         = 0;
+  while(reader.next()) {
+    EXPECT_LE(pos, reader.pos()); // Sorted by position in the hash
+    pos = reader.pos();
+    EXPECT_EQ(expected[reader.key()], reader.val());
+    ++nb;
+  }
+  EXPECT_EQ(expected.size(), nb);
+  is.close();
+
+  jellyfish::mapped_file map(file);
+  jellyfish::binary_query_base<mer_dna, uint64_t> query(map.base() + rheader.offset(), rheader.key_len(), rheader.counter_len(),
+                                                        rheader.hash_function(), rheader.size() - 1,
+                                                        map.length() - rheader.offset());
+  for(auto it = expected.cbegin(); it != expected.cend(); ++it)
+    EXPECT_EQ(it->second, query[it->first]);
+  m.randomize();
+  if(expected.find(m) == expected.end())
+    EXPECT_EQ((uint64_t)0, query[m]);
+}
+} // namespace
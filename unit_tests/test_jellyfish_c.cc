@@ -0,0 +1,162 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include <map>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include <gtest/gtest.h>
+#include <unit_tests/test_main.hpp>
+#include <jellyfish/jellyfish_c.h>
+#include <jellyfish/mer_dna.hpp>
+
+namespace {
+using jellyfish::mer_dna;
+
+std::string random_sequence(size_t len) {
+  static const char bases[] = "ACGT";
+  std::string       res;
+  for(size_t i = 0; i < len; ++i)
+    res += (random() % 50 == 0) ? (random() % 2 ? 'N' : '\n') : bases[random() % 4];
+  return res;
+}
+
+std::string reverse_complement(const std::string& s) {
+  std::string res(s.rbegin(), s.rend());
+  for(auto it = res.begin(); it != res.end(); ++it)
+    *it = *it == 'A' ? 'T' : (*it == 'C' ? 'G' : (*it == 'G' ? 'C' : 'A'));
+  return res;
+}
+
+// The k-mers of the sequences, as the counter sees them: empty string
+// if the k-mer contains a N or a newline.
+std::vector<std::string> mers_of(const std::vector<std::string>& seqs, unsigned int k, bool canonical) {
+  std::vector<std::string> res;
+  for(auto it = seqs.cbegin(); it != seqs.cend(); ++it) {
+    for(size_t i = 0; i + k <= it->size(); ++i) {
+      std::string m = it->substr(i, k);
+      if(m.find_first_not_of("ACGT") != std::string::npos)
+        m.clear();
+      else if(canonical)
+        m = std::min(m, reverse_complement(m));
+      res.push_back(m);
+    }
+  }
+  return res;
+}
+
+struct sequences {
+  std::vector<std::string> strs;
+  std::vector<const char*> seqs;
+  std::vector<size_t>      lens;
+
+  sequences(size_t nb, size_t max_len) {
+    for(size_t i = 0; i < nb; ++i)
+      strs.push_back(random_sequence(random() % max_len));
+    for(auto it = strs.cbegin(); it != strs.cend(); ++it) {
+      seqs.push_back(it->c_str());
+      lens.push_back(it->size());
+    }
+  }
+};
+
+TEST(JellyfishC, CountDumpQuery) {
+  const unsigned int mer_dna_k = mer_dna::k();
+  const sequences    s(200, 500);
+  static const char* file      = "./jellyfish_c.jf";
+  file_unlink        f(file);
+
+  // Two k-mer lengths at the same time
+  static const unsigned int ks[2] = { 15, 40 };
+  jellyfish_counter* counters[2];
+  for(int i = 0; i < 2; ++i) {
+    counters[i] = jellyfish_counter_new(ks[i], 1024, 7, 3, i == 1);
+    ASSERT_NE((jellyfish_counter*)0, counters[i]) << jellyfish_last_error();
+    EXPECT_EQ(ks[i], jellyfish_counter_k(counters[i]));
+  }
+  EXPECT_EQ(mer_dna_k, mer_dna::k());
+
+  for(int i = 0; i < 2; ++i) {
+    const unsigned int             k    = ks[i];
+    const std::vector<std::string> mers = mers_of(s.strs, k, i == 1);
+    std::map<std::string, uint64_t> expected;
+    uint64_t                        nb_mers = 0;
+    for(auto it = mers.cbegin(); it != mers.cend(); ++it) {
+      if(it->empty()) continue;
+      ++nb_mers;
+      expected[*it] += 2;
+    }
+
+    // Add the sequences twice. The hash doubles in size.
+    EXPECT_EQ((int64_t)nb_mers, jellyfish_counter_add(counters[i], s.seqs.data(), s.lens.data(), s.seqs.size()));
+    EXPECT_EQ((int64_t)nb_mers, jellyfish_counter_add(counters[i], s.seqs.data(), s.lens.data(), s.seqs.size()));
+    EXPECT_LT((uint64_t)1024, jellyfish_counter_size(counters[i]));
+
+    const size_t nb_pos = jellyfish_nb_positions(k, s.seqs.data(), s.lens.data(), s.seqs.size());
+    ASSERT_EQ(mers.size(), nb_pos);
+    std::vector<uint64_t> counts(nb_pos, (uint64_t)-1);
+    ASSERT_EQ(0, jellyfish_counter_query(counters[i], s.seqs.data(), s.lens.data(), s.seqs.size(), 2, counts.data()));
+    for(size_t j = 0; j < nb_pos; ++j)
+      EXPECT_EQ(mers[j].empty() ? 0 : expected[mers[j]], counts[j]) << j;
+
+    // Dump the k-mers seen at least 4 times and query the database
+    ASSERT_EQ(0, jellyfish_counter_dump(counters[i], file, 4, 4, UINT64_MAX)) << jellyfish_last_error();
+    jellyfish_db* db = jellyfish_db_open(file);
+    ASSERT_NE((jellyfish_db*)0, db) << jellyfish_last_error();
+    EXPECT_EQ(k, jellyfish_db_k(db));
+    EXPECT_EQ(i == 1, jellyfish_db_canonical(db));
+    uint64_t nb_high = 0;
+    for(auto it = expected.cbegin(); it != expected.cend(); ++it)
+      nb_high += it->second >= 4;
+    EXPECT_EQ(nb_high, jellyfish_db_size(db));
+
+    std::fill(counts.begin(), counts.end(), (uint64_t)-1);
+    ASSERT_EQ(0, jellyfish_db_query(db, s.seqs.data(), s.lens.data(), s.seqs.size(), 3, counts.data()));
+    for(size_t j = 0; j < nb_pos; ++j) {
+      const uint64_t c = mers[j].empty() ? 0 : expected[mers[j]];
+      EXPECT_EQ(c >= 4 ? c : 0, counts[j]) << j;
+    }
+    jellyfish_db_close(db);
+
+    // The counter is unchanged by the dump
+    ASSERT_EQ(0, jellyfish_counter_query(counters[i], s.seqs.data(), s.lens.data(), 1, 1, counts.data()));
+    for(size_t j = 0; j < jellyfish_nb_positions(k, s.seqs.data(), s.lens.data(), 1); ++j)
+      EXPECT_EQ(mers[j].empty() ? 0 : expected[mers[j]], counts[j]);
+  }
+
+  for(int i = 0; i < 2; ++i)
+    jellyfish_counter_free(counters[i]);
+  EXPECT_EQ(mer_dna_k, mer_dna::k());
+}
+
+TEST(JellyfishC, KValues) {
+  std::vector<jellyfish_counter*> counters;
+  for(unsigned int k = 10; k < 10 + JELLYFISH_MAX_K_VALUES; ++k) {
+    counters.push_back(jellyfish_counter_new(k, 64, 7, 1, 0));
+    ASSERT_NE((jellyfish_counter*)0, counters.back()) << jellyfish_last_error();
+  }
+  // Same k as a counter in use
+  jellyfish_counter* same = jellyfish_counter_new(10, 64, 7, 1, 0);
+  EXPECT_NE((jellyfish_counter*)0, same);
+  jellyfish_counter_free(same);
+
+  EXPECT_EQ((jellyfish_counter*)0, jellyfish_counter_new(50, 64, 7, 1, 0));
+  EXPECT_NE((const char*)0, strstr(jellyfish_last_error(), "k-mer lengths"));
+
+  jellyfish_counter_free(counters.back());
+  counters.back() = jellyfish_counter_new(50, 64, 7, 1, 0);
+  ASSERT_NE((jellyfish_counter*)0, counters.back());
+  EXPECT_EQ(50u, jellyfish_counter_k(counters.back()));
+
+  for(auto it = counters.begin(); it != counters.end(); ++it)
+    jellyfish_counter_free(*it);
+}
+
+TEST(JellyfishC, Errors) {
+  EXPECT_EQ((jellyfish_counter*)0, jellyfish_counter_new(0, 64, 7, 1, 0));
+  EXPECT_EQ((jellyfish_counter*)0, jellyfish_counter_new(20, 64, 7, 0, 0));
+  EXPECT_EQ((jellyfish_db*)0, jellyfish_db_open("./does_not_exist.jf"));
+  EXPECT_NE((const char*)0, strstr(jellyfish_last_error(), "does_not_exist.jf"));
+}
+} // namespace
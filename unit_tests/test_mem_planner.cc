@@ -0,0 +1,98 @@
+#include <gtest/gtest.h>
+#include <jellyfish/mem_planner.hpp>
+#include <jellyfish/mer_dna.hpp>
+#include <jellyfish/large_hash_array.hpp>
+
+namespace {
+// Switches of count, as parsed by yaggo
+struct count_args {
+  uint32_t    mer_len_arg, counter_len_arg, out_counter_len_arg, reprobes_arg, threads_arg, Files_arg;
+  bool        min_qual_char_given, disk_flag, text_flag, bf_size_given, bc_given;
+  uint64_t    bf_size_arg;
+  double      bf_fp_arg;
+  const char* bc_arg;
+
+  count_args() :
+    mer_len_arg(25), counter_len_arg(7), out_counter_len_arg(4), reprobes_arg(126), threads_arg(4), Files_arg(1),
+    min_qual_char_given(false), disk_flag(false), text_flag(false), bf_size_given(false), bc_given(false),
+    bf_size_arg(0), bf_fp_arg(0.01), bc_arg(0)
+  { }
+};
+
+uint64_t item(const mem_plan& plan, const std::string& name) {
+  for(auto it = plan.items().cbegin(); it != plan.items().cend(); ++it)
+    if(it->name == name)
+      return it->bytes;
+  return 0;
+}
+
+TEST(MemPlanner, Count) {
+  count_args       args;
+  count_mem_params params(args);
+  const mem_plan   plan = count_mem_plan(params, 1000000);
+
+  jellyfish::large_hash::array<jellyfish::mer_dna>::usage_info usage(50, 7, 126);
+  EXPECT_EQ(usage.mem(1000000), item(plan, "hash"));
+  EXPECT_EQ(usage.mem(2 * 1048576), item(plan, "hash doubling"));
+  EXPECT_EQ((uint64_t)4 * 3 * 4096, item(plan, "parser buffers"));
+  EXPECT_EQ((uint64_t)24, item(plan, "seam buffers"));
+  EXPECT_LT((uint64_t)0, item(plan, "dump buffers"));
+  EXPECT_EQ((uint64_t)0, item(plan, "bloom filter"));
+
+  uint64_t total = 0;
+  for(auto it = plan.items().cbegin(); it != plan.items().cend(); ++it)
+    total += it->bytes;
+  EXPECT_EQ(total, plan.total());
+
+  args.disk_flag     = true;
+  args.bf_size_given = true;
+  args.bf_size_arg   = 1000000;
+  count_mem_params disk_params(args);
+  const mem_plan   disk_plan = count_mem_plan(disk_params, 1000000);
+  EXPECT_EQ((uint64_t)0, item(disk_plan, "hash doubling"));
+  EXPECT_LT((uint64_t)1000000, item(disk_plan, "bloom filter"));
+}
+
+TEST(MemPlanner, CountMaxSize) {
+  count_args             args;
+  const count_mem_params params(args);
+  for(uint64_t budget = 1 << 23; budget < ((uint64_t)1 << 34); budget *= 3) {
+    const uint64_t size = count_max_size(params, budget);
+    ASSERT_LT((uint64_t)0, size);
+    EXPECT_EQ((uint64_t)0, size & (size - 1)); // Power of 2
+    EXPECT_GE(budget, count_mem_plan(params, size).total());
+    EXPECT_LT(budget, count_mem_plan(params, 2 * size).total());
+  }
+  EXPECT_EQ((uint64_t)0, count_max_size(params, 1024));
+}
+
+// Switches of bc, as parsed by yaggo
+struct bc_args {
+  uint32_t    mer_len_arg, threads_arg, Files_arg, bits_arg;
+  bool        bits_given, cuckoo_flag, blocked_flag, like_given;
+  double      fpr_arg;
+  const char* like_arg;
+
+  bc_args() :
+    mer_len_arg(25), threads_arg(2), Files_arg(1), bits_arg(0),
+    bits_given(false), cuckoo_flag(false), blocked_flag(false), like_given(false),
+    fpr_arg(0.001), like_arg(0)
+  { }
+};
+
+TEST(MemPlanner, BcMaxSize) {
+  bc_args args;
+  for(int variant = 0; variant < 4; ++variant) {
+    args.blocked_flag = variant == 1;
+    args.bits_given   = variant == 2;
+    args.bits_arg     = variant == 2 ? 4 : 0;
+    args.cuckoo_flag  = variant == 3;
+    const bc_mem_params params(args);
+    const uint64_t      budget = 100000000;
+    const uint64_t      size   = bc_max_size(params, budget);
+    ASSERT_LT((uint64_t)0, size);
+    EXPECT_GE(budget, bc_mem_plan(params, size).total());
+    EXPECT_LT(budget, bc_mem_plan(params, size + 1).total());
+  }
+}
+} // namespace
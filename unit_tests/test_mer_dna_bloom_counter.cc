@@ -19,6 +19,7 @@
 #include <algorithm>
 #include <utility>
 #include <set>
+#include <vector>
 #include <string>
 #include <fstream>
 #include <gtest/gtest.h>
@@ -39,13 +40,18 @@ struct TestBloomCounter {
   typedef jellyfish::mer_dna_bloom_counter_file file_type;
   static const unsigned int threshold_twice = 2; // Bloom counter counts up to 2.
 };
+struct TestBlockedBloomCounter {
+  typedef jellyfish::mer_dna_blocked_bloom_counter bloom_type;
+  typedef jellyfish::mer_dna_blocked_bloom_counter_file file_type;
+  static const unsigned int threshold_twice = 2;
+};
 struct TestBloomFilter {
   typedef jellyfish::mer_dna_bloom_filter bloom_type;
   typedef jellyfish::mer_dna_bloom_filter_file file_type;
   static const unsigned int threshold_twice = 1; // Bloom filter counts up to 1.
 };
 
-typedef ::testing::Types<TestBloomCounter, TestBloomFilter> TestBloomCounterTypes;
+typedef ::testing::Types<TestBloomCounter, TestBlockedBloomCounter, TestBloomFilter> TestBloomCounterTypes;
 TYPED_TEST_CASE(MerDnaBloomTest, TestBloomCounterTypes);
 
 
@@ -147,4 +153,75 @@ TYPED_TEST(MerDnaBloomTest, Move) {
   EXPECT_EQ(m, bc.m());
 }
 
+TYPED_TEST(MerDnaBloomTest, Batch) {
+  mer_dna::k(31);
+  typename TypeParam::bloom_type bc(error_rate, nb_inserts);
+  typename TypeParam::bloom_type bc_many(bc.m(), bc.k(), bc.hash_functions());
+
+  // Insert all the mers, then the first half a second time
+  std::vector<mer_dna> mers(nb_inserts + nb_inserts / 2);
+  for(size_t i = 0; i < nb_inserts; ++i)
+    mers[i].randomize();
+  std::copy(mers.begin(), mers.begin() + nb_inserts / 2, mers.begin() + nb_inserts);
+
+  std::vector<unsigned int> res(mers.size()), res_many(mers.size());
+  for(size_t i = 0; i < mers.size(); ++i)
+    res[i] = bc.insert(mers[i]);
+  auto it = bc_many.insert_many(mers.begin(), mers.begin() + 3, res_many.begin()); // Shorter than lookahead
+  bc_many.insert_many(mers.begin() + 3, mers.end(), it);
+  EXPECT_EQ(res, res_many);
+
+  // Check inserted and random mers
+  for(size_t i = nb_inserts; i < mers.size(); ++i)
+    mers[i].randomize();
+  bc_many.check_many(mers.begin(), mers.end(), res_many.begin());
+  for(size_t i = 0; i < mers.size(); ++i)
+    EXPECT_EQ(bc.check(mers[i]), res_many[i]);
+}
+
+TEST(BloomCounter2Trits, Decode) {
+  typedef jellyfish::bloom_counter2_trits< ::atomic::gcc> trits;
+  static const unsigned int weights[5] = { 1, 3, 9, 27, 81 };
+  for(unsigned int v = 0; v < 243; ++v) {
+    for(size_t boff = 0; boff < 5; ++boff) {
+      const unsigned int w = (v / weights[boff]) % 3;
+      EXPECT_EQ(w, trits::get(v, boff));
+
+      ::atomic::gcc atomic;
+      unsigned char byte = v;
+      EXPECT_EQ(w, trits::increment(atomic, &byte, boff));
+      EXPECT_EQ(std::min(w + 1, 2u), trits::get(byte, boff));
+    }
+  }
+}
+
+TEST(MerDnaBlockedBloomCounter, OptimalSize) {
+  typedef jellyfish::mer_dna_blocked_bloom_counter blocked_type;
+  static const size_t n = 100000;
+  mer_dna::k(31);
+
+  const double fps[] = { 0.1, 0.01, 0.001 };
+  for(auto fp : fps) {
+    const size_t m = blocked_type::opt_m(fp, n);
+    EXPECT_EQ((size_t)0, m % blocked_type::block_counters);
+    EXPECT_LE(jellyfish::mer_dna_bloom_counter::opt_m(fp, n), m);
+    EXPECT_GE(fp, blocked_type::fp_rate(m / blocked_type::block_counters, n, blocked_type::opt_k(fp)));
+  }
+
+  // Measured false positive rate close to requested
+  static const double fp = 0.01;
+  blocked_type bc(fp, n);
+  mer_dna      m;
+  for(size_t i = 0; i < n; ++i) {
+    m.randomize();
+    bc.insert(m);
+  }
+  size_t nb_collisions = 0;
+  for(size_t i = 0; i < n; ++i) {
+    m.randomize();
+    nb_collisions += bc.check(m) > 0;
+  }
+  EXPECT_GT(1.5 * fp * n, nb_collisions);
+}
+
 }
@@ -0,0 +1,108 @@
+#include <vector>
+#include <set>
+#include <sstream>
+#include <algorithm>
+
+#include <gtest/gtest.h>
+#include <unit_tests/test_main.hpp>
+#include <jellyfish/mer_dna.hpp>
+#include <jellyfish/mphf.hpp>
+#include <jellyfish/compact_database.hpp>
+
+namespace {
+using jellyfish::mer_dna;
+typedef jellyfish::binary_records<mer_dna, uint64_t> binary_records;
+typedef jellyfish::compact::builder<mer_dna, uint64_t> compact_builder;
+typedef jellyfish::compact::query<mer_dna, uint64_t> compact_query;
+
+struct mer_vector_source {
+  std::vector<mer_dna> mers;
+  size_t size() const { return mers.size(); }
+  void key_at(size_t id, mer_dna& m) const { m = mers[id]; }
+};
+
+class MPHF : public ::testing::TestWithParam<std::pair<int, int> > {
+public:
+  void SetUp() { mer_dna::k(GetParam().first); }
+};
+
+TEST_P(MPHF, Permutation) {
+  static const size_t nb = 10000;
+  mer_vector_source   source;
+  std::set<mer_dna>   uniq;
+  mer_dna             m;
+  while(uniq.size() < nb) {
+    m.randomize();
+    if(uniq.insert(m).second)
+      source.mers.push_back(m);
+  }
+
+  jellyfish::mphf::builder<mer_dna, mer_vector_source> builder(source, 2.0, GetParam().second);
+  const jellyfish::mphf::query query = builder.get_query();
+  EXPECT_EQ(nb, query.size());
+  std::vector<bool> seen(nb, false);
+  for(size_t i = 0; i < nb; ++i) {
+    const uint64_t id = query(source.mers[i]);
+    ASSERT_GT(nb, id);
+    EXPECT_FALSE(seen[id]);
+    seen[id] = true;
+  }
+}
+INSTANTIATE_TEST_CASE_P(MPHFTest, MPHF, ::testing::Values(std::make_pair(15, 1), std::make_pair(31, 4),
+                                                          std::make_pair(50, 3)));
+
+TEST(CompactDatabase, Query) {
+  static const size_t       nb      = 5000;
+  static const unsigned int val_len = 2;
+  mer_dna::k(25);
+  const unsigned int key_bytes = (2 * mer_dna::k()) / 8 + ((2 * mer_dna::k()) % 8 != 0);
+
+  std::set<mer_dna>     uniq;
+  std::vector<uint64_t> vals;
+  std::string           records;
+  mer_dna               m;
+  while(uniq.size() < nb) {
+    m.randomize();
+    if(!uniq.insert(m).second) continue;
+    const uint64_t v = random_bits(10);
+    vals.push_back(v);
+    records.append((const char*)m.data(), key_bytes);
+    records.append((const char*)&v, val_len);
+  }
+
+  binary_records recs(records.data(), 2 * mer_dna::k(), val_len, records.size());
+  ASSERT_EQ(nb, recs.size());
+  compact_builder builder(recs, 20, 2.0, 2);
+
+  std::stringstream     buffer;
+  jellyfish::file_header header;
+  header.key_len(2 * mer_dna::k());
+  builder.update_header(header);
+  header.write(buffer);
+  builder.write(buffer);
+
+  const std::string         content = buffer.str();
+  std::istringstream        is(content);
+  jellyfish::file_header    rheader(is);
+  EXPECT_EQ(jellyfish::compact::format, rheader.format());
+  EXPECT_EQ(nb, rheader.size());
+  EXPECT_EQ(20u, rheader.fingerprint_len());
+  EXPECT_EQ(jellyfish::bitsize(*std::max_element(vals.cbegin(), vals.cend())), rheader.counter_bits());
+
+  compact_query query(content.data() + rheader.offset(), rheader, content.size() - rheader.offset());
+  for(size_t i = 0; i < nb; ++i) {
+    recs.key_at(i, m);
+    EXPECT_EQ(vals[i], query.check(m));
+    EXPECT_EQ(vals[i], query.check(m, query.prefetch(m)));
+  }
+
+  // Absent mers are reported with count 0, but for rare false positives
+  int false_positives = 0;
+  for(int i = 0; i < 1000; ++i) {
+    m.randomize();
+    if(uniq.find(m) == uniq.end())
+      false_positives += query.check(m) != 0;
+  }
+  EXPECT_GT(5, false_positives);
+}
+} // namespace
@@ -0,0 +1,80 @@
+#include <vector>
+#include <string>
+#include <sstream>
+
+#include <gtest/gtest.h>
+#include <unit_tests/test_main.hpp>
+#include <jellyfish/mer_dna.hpp>
+#include <jellyfish/sequence_mers.hpp>
+#include <jellyfish/read_profile.hpp>
+
+namespace {
+using jellyfish::mer_dna;
+using jellyfish::sequence_mers;
+namespace profile = jellyfish::profile;
+
+TEST(ReadProfile, Summary) {
+  std::vector<uint64_t> tmp;
+  const std::vector<uint64_t> empty;
+  const profile::summary se(empty, 2, tmp);
+  EXPECT_EQ((uint64_t)0, se.nb_mers);
+  EXPECT_EQ(0.0, se.below);
+
+  const std::vector<uint64_t> odd = { 5, 1, 7, 3, 1 };
+  const profile::summary so(odd, 2, tmp);
+  EXPECT_EQ((uint64_t)5, so.nb_mers);
+  EXPECT_EQ((uint64_t)1, so.min);
+  EXPECT_EQ((uint64_t)3, so.median);
+  EXPECT_DOUBLE_EQ(0.4, so.below);
+
+  const std::vector<uint64_t> even = { 10, 4, 8, 6 };
+  const profile::summary sv(even, 7, tmp);
+  EXPECT_EQ((uint64_t)4, sv.min);
+  EXPECT_EQ((uint64_t)6, sv.median);
+  EXPECT_DOUBLE_EQ(0.5, sv.below);
+}
+
+TEST(ReadProfile, BinaryRecords) {
+  static const int nb_reads = 100;
+  const profile::writer writer(2);
+  const profile::reader reader(2);
+  std::vector<std::string>           headers;
+  std::vector<std::vector<uint64_t>> counts;
+  std::stringstream                  buffer;
+
+  for(int i = 0; i < nb_reads; ++i) {
+    headers.push_back(i % 10 ? std::string("read") + std::to_string(i) : std::string());
+    counts.push_back(std::vector<uint64_t>(random_bits(6)));
+    for(auto it = counts.back().begin(); it != counts.back().end(); ++it)
+      *it = random_bits(20);
+    writer.write(buffer, headers.back(), counts.back());
+  }
+
+  std::string           header;
+  std::vector<uint64_t> read_counts;
+  for(int i = 0; i < nb_reads; ++i) {
+    ASSERT_TRUE(reader.read(buffer, header, read_counts));
+    EXPECT_EQ(headers[i], header);
+    ASSERT_EQ(counts[i].size(), read_counts.size());
+    for(size_t j = 0; j < read_counts.size(); ++j)
+      EXPECT_EQ(std::min((uint64_t)0xffff, counts[i][j]), read_counts[j]);
+  }
+  EXPECT_FALSE(reader.read(buffer, header, read_counts));
+}
+
+TEST(SequenceMers, Iterate) {
+  mer_dna::k(5);
+  const std::string   seq = "ACGTACNGTACGTTT";
+  sequence_mers       it(false);
+  const sequence_mers it_end(false);
+  std::vector<std::string> mers;
+  for(it = seq; it != it_end; ++it)
+    mers.push_back(it->to_str());
+  const std::vector<std::string> expected = { "ACGTA", "CGTAC", "GTACG", "TACGT", "ACGTT", "CGTTT" };
+  EXPECT_EQ(expected, mers);
+
+  // No full mer
+  it = "ACGNTTTT";
+  EXPECT_TRUE(it == it_end);
+}
+} // namespace
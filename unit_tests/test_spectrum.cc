@@ -0,0 +1,70 @@
+#include <map>
+#include <sstream>
+
+#include <gtest/gtest.h>
+#include <unit_tests/test_main.hpp>
+#include <jellyfish/mer_dna.hpp>
+#include <jellyfish/large_hash_array.hpp>
+#include <jellyfish/spectrum.hpp>
+
+namespace {
+using jellyfish::mer_dna;
+typedef jellyfish::large_hash::array<mer_dna> large_array;
+
+TEST(Spectrum, Buckets) {
+  jellyfish::spectrum s(2, 10, 3);
+  const uint64_t vals[] = { 1, 1, 2, 4, 5, 10, 12, 13, 14, 100 };
+  for(auto v : vals)
+    s.add(v);
+  EXPECT_EQ((uint64_t)2, s.uniq());
+  EXPECT_EQ((uint64_t)10, s.distinct());
+  EXPECT_EQ((uint64_t)162, s.total());
+  EXPECT_EQ((uint64_t)100, s.max());
+
+  // base = 0, ceil = 13
+  std::ostringstream histo;
+  s.write_histo(histo);
+  EXPECT_EQ("0 3\n3 2\n9 1\n12 4\n", histo.str());
+
+  std::ostringstream full;
+  s.write_histo(full, true);
+  EXPECT_EQ("0 3\n3 2\n6 0\n9 1\n12 4\n", full.str());
+}
+
+TEST(Spectrum, FromHash) {
+  static const int nb_threads = 4;
+  mer_dna::k(17);
+  large_array ary(1024 * 16, 2 * mer_dna::k(), 5, 126);
+
+  std::map<mer_dna, uint64_t> counts;
+  mer_dna m;
+  for(int i = 0; i < 5000; ++i) {
+    m.randomize();
+    const uint64_t c = 1 + random_bits(3) * random_bits(3);
+    ASSERT_TRUE(ary.add(m, c));
+    counts[m] += c;
+  }
+
+  jellyfish::spectrum expected, expected_filtered;
+  for(auto it = counts.cbegin(); it != counts.cend(); ++it) {
+    expected.add(it->second);
+    if(it->second >= 2 && it->second <= 20)
+      expected_filtered.add(it->second);
+  }
+
+  jellyfish::spectrum res;
+  jellyfish::spectrum_computer<large_array> computer(ary, nb_threads);
+  computer.compute(res);
+  EXPECT_EQ(expected.histo(), res.histo());
+  EXPECT_EQ(expected.distinct(), res.distinct());
+  EXPECT_EQ(expected.uniq(), res.uniq());
+  EXPECT_EQ(expected.total(), res.total());
+  EXPECT_EQ(expected.max(), res.max());
+
+  jellyfish::spectrum res_filtered;
+  jellyfish::spectrum_computer<large_array> computer_filtered(ary, nb_threads, 2, 20);
+  computer_filtered.compute(res_filtered);
+  EXPECT_EQ(expected_filtered.histo(), res_filtered.histo());
+  EXPECT_EQ(expected_filtered.total(), res_filtered.total());
+}
+} // namespace
@@ -0,0 +1,78 @@
+#include <vector>
+#include <gtest/gtest.h>
+#include <jellyfish/locks_pthread.hpp>
+#include <jellyfish/thread_exec.hpp>
+
+namespace {
+using jellyfish::locks::pthread::spin_barrier;
+
+// Threads go through phases separated by a barrier. In each phase,
+// every thread increments a counter, and helps with a number of work
+// items before the barrier.
+class phases : public jellyfish::thread_exec {
+  static const int      nb_items = 50;
+  const int             nb_threads_;
+  spin_barrier          barrier_;
+  volatile unsigned int count_;
+  volatile unsigned int item_;
+  volatile unsigned int items_done_;
+  volatile unsigned int serial_;
+
+public:
+  static const int nb_phases = 100;
+  bool             ok;
+  int              parks;
+
+  phases(int nb_threads, unsigned int spins) :
+    nb_threads_(nb_threads), barrier_(nb_threads, spins),
+    count_(0), item_(0), items_done_(0), serial_(0), ok(true), parks(0)
+  { }
+
+  virtual void start(int thid) {
+    for(int i = 0; i < nb_phases; ++i) {
+      __sync_add_and_fetch(&count_, 1);
+      bool parked = false;
+      const bool serial = barrier_.wait([&]() -> bool {
+          if(__sync_fetch_and_add(&item_, 1) >= (unsigned int)(nb_items * (i + 1)))
+            return false;
+          __sync_add_and_fetch(&items_done_, 1);
+          return true;
+        }, &parked);
+      if(serial)
+        __sync_add_and_fetch(&serial_, 1);
+      if(parked)
+        __sync_add_and_fetch(&parks, 1);
+      // Everybody has incremented and done the work items
+      if(count_ < (unsigned int)(nb_threads_ * (i + 1)) || items_done_ < (unsigned int)(nb_items * (i + 1)))
+        ok = false;
+      barrier_.wait();
+      // Reset the extra items claimed by the threads finding none left
+      if(serial)
+        item_ = nb_items * (i + 1);
+      barrier_.wait();
+    }
+  }
+
+  unsigned int serial() const { return serial_; }
+};
+
+TEST(SpinBarrier, Phases) {
+  static const int nb_threads = 5;
+  const unsigned int spins[3] = { 0, 100, jellyfish::locks::pthread::default_spins() };
+  for(int i = 0; i < 3; ++i) {
+    SCOPED_TRACE(::testing::Message() << "spins:" << spins[i]);
+    phases p(nb_threads, spins[i]);
+    p.exec_join(nb_threads);
+    EXPECT_TRUE(p.ok);
+    EXPECT_EQ((unsigned int)phases::nb_phases, p.serial());
+    if(spins[i] == 0)
+      EXPECT_LT(0, p.parks);
+  }
+}
+
+TEST(SpinBarrier, OneThread) {
+  spin_barrier barrier(1);
+  for(int i = 0; i < 3; ++i)
+    EXPECT_TRUE(barrier.wait());
+}
+} // namespace
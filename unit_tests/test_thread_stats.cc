@@ -0,0 +1,52 @@
+#include <gtest/gtest.h>
+#include <jellyfish/thread_stats.hpp>
+#include <jellyfish/large_hash_array.hpp>
+#include <jellyfish/mer_dna.hpp>
+
+namespace {
+using jellyfish::thread_stats;
+using jellyfish::mer_dna;
+typedef jellyfish::large_hash::array<mer_dna> large_array;
+
+TEST(ThreadStats, Scope) {
+  EXPECT_EQ((thread_stats*)0, thread_stats::current());
+  thread_stats::incr<&thread_stats::mers>(); // No-op
+
+  thread_stats outer, inner;
+  {
+    thread_stats::scope s1(&outer);
+    EXPECT_EQ(&outer, thread_stats::current());
+    thread_stats::incr<&thread_stats::mers>(5);
+    {
+      thread_stats::scope s2(&inner);
+      EXPECT_EQ(&inner, thread_stats::current());
+      thread_stats::incr<&thread_stats::mers>();
+    }
+    EXPECT_EQ(&outer, thread_stats::current());
+  }
+  EXPECT_EQ((thread_stats*)0, thread_stats::current());
+  EXPECT_EQ((uint64_t)5, outer.mers);
+  EXPECT_EQ((uint64_t)1, inner.mers);
+
+  outer += inner;
+  EXPECT_EQ((uint64_t)6, outer.mers);
+  EXPECT_LE(inner.total_ns, outer.total_ns);
+}
+
+TEST(ThreadStats, Reprobes) {
+  mer_dna::k(31);
+  large_array  ary(1024, 62, 8, 126);
+  thread_stats stats;
+  {
+    thread_stats::scope scope(&stats);
+    mer_dna m;
+    for(int i = 0; i < 900; ++i) {
+      m.randomize();
+      ary.add(m, 1);
+    }
+  }
+  // A hash 88% full must have reprobed
+  EXPECT_LT((uint64_t)0, stats.reprobes);
+  EXPECT_EQ((uint64_t)0, stats.cas_failures);
+}
+} // namespace
@@ -0,0 +1,100 @@
+#include <map>
+#include <vector>
+#include <sstream>
+#include <algorithm>
+
+#include <gtest/gtest.h>
+#include <unit_tests/test_main.hpp>
+#include <jellyfish/mer_dna.hpp>
+#include <jellyfish/large_hash_array.hpp>
+#include <jellyfish/top_mers.hpp>
+
+namespace {
+using jellyfish::mer_dna;
+typedef jellyfish::top_mers<mer_dna, uint64_t> top_mers;
+typedef std::pair<mer_dna, uint64_t> element_type;
+typedef jellyfish::large_hash::array<mer_dna> large_array;
+
+bool before(const element_type& a, const element_type& b) {
+  return a.second > b.second || (a.second == b.second && a.first < b.first);
+}
+
+TEST(TopMers, Partial) {
+  static const size_t nb = 10000, n = 50, nb_parts = 4;
+  mer_dna::k(21);
+  std::vector<element_type> all;
+  top_mers                  parts[nb_parts] = { top_mers(n), top_mers(n), top_mers(n), top_mers(n) };
+  mer_dna                   m;
+  for(size_t i = 0; i < nb; ++i) {
+    m.randomize();
+    const uint64_t val = random_bits(6); // Many ties
+    all.push_back(std::make_pair(m, val));
+    parts[i % nb_parts].add(m, val);
+  }
+  std::sort(all.begin(), all.end(), before);
+
+  top_mers top(n);
+  for(size_t i = 0; i < nb_parts; ++i)
+    top += parts[i];
+  const std::vector<element_type> res = top.sorted();
+  ASSERT_EQ(n, res.size());
+  for(size_t i = 0; i < n; ++i) {
+    EXPECT_EQ(all[i].first, res[i].first);
+    EXPECT_EQ(all[i].second, res[i].second);
+  }
+}
+
+TEST(TopMers, Small) {
+  mer_dna::k(5);
+  top_mers top(3), none(0);
+  top.add(mer_dna("AAAAA"), 1);
+  none.add(mer_dna("AAAAA"), 1);
+  EXPECT_EQ((size_t)0, none.size());
+  EXPECT_EQ((size_t)1, top.size());
+  top.add(mer_dna("CCCCC"), 5);
+  top.add(mer_dna("GGGGG"), 5);
+  top.add(mer_dna("TTTTT"), 2);
+  top.add(mer_dna("ACGTA"), 5);
+  const std::vector<element_type> res = top.sorted();
+  ASSERT_EQ((size_t)3, res.size());
+  EXPECT_EQ("ACGTA", res[0].first.to_str());
+  EXPECT_EQ("CCCCC", res[1].first.to_str());
+  EXPECT_EQ("GGGGG", res[2].first.to_str());
+
+  std::ostringstream os;
+  top.write(os, '\t');
+  EXPECT_EQ("ACGTA\t5\nCCCCC\t5\nGGGGG\t5\n", os.str());
+}
+
+TEST(TopMers, FromHash) {
+  static const int    nb_threads = 4;
+  static const size_t n          = 100;
+  mer_dna::k(17);
+  large_array ary(1024 * 16, 2 * mer_dna::k(), 5, 126);
+
+  std::map<mer_dna, uint64_t> counts;
+  mer_dna m;
+  for(int i = 0; i < 5000; ++i) {
+    m.randomize();
+    const uint64_t c = 1 + random_bits(3) * random_bits(3);
+    ASSERT_TRUE(ary.add(m, c));
+    counts[m] += c;
+  }
+
+  std::vector<element_type> all;
+  for(auto it = counts.cbegin(); it != counts.cend(); ++it)
+    if(it->second <= 40)
+      all.push_back(*it);
+  std::sort(all.begin(), all.end(), before);
+
+  top_mers res(n);
+  jellyfish::top_mers_computer<large_array> computer(ary, nb_threads, n, 0, 40);
+  computer.compute(res);
+  const std::vector<element_type> sorted = res.sorted();
+  ASSERT_EQ(n, sorted.size());
+  for(size_t i = 0; i < n; ++i) {
+    EXPECT_EQ(all[i].first, sorted[i].first);
+    EXPECT_EQ(all[i].second, sorted[i].second);
+  }
+}
+} // namespace
@@ -0,0 +1,69 @@
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include <gtest/gtest.h>
+#include <unit_tests/test_main.hpp>
+#include <jellyfish/trace.hpp>
+#include <jellyfish/thread_exec.hpp>
+
+namespace {
+using jellyfish::trace;
+
+size_t count(const std::string& str, const std::string& pattern) {
+  size_t res = 0;
+  for(size_t pos = str.find(pattern); pos != std::string::npos; pos = str.find(pattern, pos + 1))
+    ++res;
+  return res;
+}
+
+class spanner : public jellyfish::thread_exec {
+  const int nb_;
+public:
+  explicit spanner(int nb) : nb_(nb) { }
+  virtual void start(int id) {
+    for(int i = 0; i < nb_; ++i)
+      trace::span span("work");
+  }
+};
+
+TEST(Trace, Disabled) {
+  EXPECT_FALSE(trace::enabled());
+  trace::span span("nothing"); // No-op
+}
+
+TEST(Trace, Timeline) {
+  const char* path = "trace_timeline.json";
+  file_unlink  file(path);
+  std::string  timeline;
+  {
+    trace t(path, "test", 8);
+    EXPECT_TRUE(trace::enabled());
+    EXPECT_THROW(trace(path, "test"), trace::Error);
+
+    { trace::span span("main"); }
+    spanner s(10);
+    s.exec_join(2);
+
+    std::ostringstream os;
+    t.write(os);
+    timeline = os.str();
+  }
+  EXPECT_FALSE(trace::enabled());
+
+  // Main thread plus 2 threads, each with 10 "work" spans within a
+  // "thread" span. The buffers keep the last 8 events.
+  EXPECT_EQ((size_t)3, count(timeline, "\"thread_name\""));
+  EXPECT_EQ((size_t)1, count(timeline, "\"name\":\"main\""));
+  EXPECT_EQ((size_t)2, count(timeline, "\"name\":\"thread\""));
+  EXPECT_EQ((size_t)14, count(timeline, "\"name\":\"work\""));
+  EXPECT_NE(std::string::npos, timeline.find("\"dropped_events\":6"));
+
+  std::ifstream is(path);
+  std::string   content((std::istreambuf_iterator<char>(is)), std::istreambuf_iterator<char>());
+  EXPECT_EQ(timeline, content);
+
+  // Spans are not recorded once the trace is gone
+  { trace::span span("after"); }
+}
+} // namespace